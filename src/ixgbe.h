@@ -46,6 +46,22 @@
 #include "ixgbe_fcoe.h"
 #endif /* CONFIG_FCOE */
 
+#if IS_ENABLED(CONFIG_XFRM_OFFLOAD) && defined(HAVE_XFRM_DEV_OFFLOAD)
+#define HAVE_IXGBE_IPSEC
+#include <net/xfrm.h>
+#include "ixgbe_ipsec.h"
+#endif /* CONFIG_XFRM_OFFLOAD && HAVE_XFRM_DEV_OFFLOAD */
+
+#if IS_ENABLED(CONFIG_MACSEC) && defined(HAVE_METADATA_MACSEC)
+#define HAVE_IXGBE_MACSEC
+#include "ixgbe_macsec.h"
+#endif /* CONFIG_MACSEC && HAVE_METADATA_MACSEC */
+
+#if defined(NETIF_F_HW_L2FW_DOFFLOAD) && defined(HAVE_NDO_DFWD_OPS) && \
+	defined(HAVE_NETDEV_SB_DEV)
+#define HAVE_IXGBE_FWD_OFFLOAD
+#endif
+
 #include "ixgbe_api.h"
 
 #if IS_ENABLED(CONFIG_NET_DEVLINK)
@@ -70,6 +86,10 @@
 #include <linux/ptp_clock_kernel.h>
 #endif
 
+#ifdef CONFIG_FAULT_INJECTION
+#include <linux/fault-inject.h>
+#endif
+
 /* TX/RX descriptor defines */
 #define IXGBE_DEFAULT_TXD		512
 #define IXGBE_DEFAULT_TX_WORK		256
@@ -171,6 +191,14 @@ static inline int ixgbe_skb_pad(void)
 /* How many Rx Buffers do we bundle into one write to the hardware ? */
 #define IXGBE_RX_BUFFER_WRITE	16	/* Must be power of 2 */
 
+/* With the rx-idle-shrink private flag, quiet rings keep only enough
+ * buffers posted to cover IXGBE_RX_FILL_HEADROOM_MS of their recent rate,
+ * but never fewer than IXGBE_RX_FILL_LOW_WATER.
+ */
+#define IXGBE_RX_FILL_LOW_WATER		64
+#define IXGBE_RX_FILL_HEADROOM_MS	20
+#define IXGBE_RX_FILL_REVIEW		(2 * HZ)
+
 #ifdef HAVE_STRUCT_DMA_ATTRS
 #define IXGBE_RX_DMA_ATTR NULL
 #else
@@ -190,15 +218,24 @@ enum ixgbe_tx_flags {
 	IXGBE_TX_FLAGS_HW_VLAN	= 0x01,
 	IXGBE_TX_FLAGS_TSO	= 0x02,
 	IXGBE_TX_FLAGS_TSTAMP	= 0x04,
+	IXGBE_TX_FLAGS_LINKSEC	= 0x08,
 
 	/* olinfo flags */
-	IXGBE_TX_FLAGS_CC	= 0x08,
-	IXGBE_TX_FLAGS_IPV4	= 0x10,
-	IXGBE_TX_FLAGS_CSUM	= 0x20,
+	IXGBE_TX_FLAGS_CC	= 0x10,
+	IXGBE_TX_FLAGS_IPV4	= 0x20,
+	IXGBE_TX_FLAGS_CSUM	= 0x40,
+	IXGBE_TX_FLAGS_IPSEC	= 0x80,
 
 	/* software defined flags */
-	IXGBE_TX_FLAGS_SW_VLAN	= 0x40,
-	IXGBE_TX_FLAGS_FCOE	= 0x80,
+	IXGBE_TX_FLAGS_SW_VLAN	= 0x100,
+	IXGBE_TX_FLAGS_FCOE	= 0x200,
+};
+
+/* IPsec context descriptor fields, zero when the frame is not offloaded */
+struct ixgbe_ipsec_tx_data {
+	u32 flags;
+	u16 trailer_len;
+	u16 sa_idx;
 };
 
 /* VLAN info */
@@ -214,6 +251,7 @@ enum ixgbe_tx_flags {
 #define IXGBE_MAX_VFTA_ENTRIES		128
 #define MAX_EMULATION_MAC_ADDRS		16
 #define IXGBE_MAX_PF_MACVLANS		15
+#define IXGBE_MAX_MACVLANS		63
 
 /* must account for pools assigned to VFs. */
 #ifdef CONFIG_PCI_IOV
@@ -370,9 +408,13 @@ struct ixgbe_tx_queue_stats {
 	u64 tx_done_old;
 };
 
+/* RSC aggregations by segment count: 2-3, 4-7, 8-15, 16 and up */
+#define IXGBE_RSC_HIST_BUCKETS	4
+
 struct ixgbe_rx_queue_stats {
 	u64 rsc_count;
 	u64 rsc_flush;
+	u64 rsc_hist[IXGBE_RSC_HIST_BUCKETS];
 	u64 non_eop_descs;
 	u64 alloc_rx_page;
 	u64 alloc_rx_page_failed;
@@ -396,6 +438,7 @@ enum ixgbe_ring_state_t {
 	__IXGBE_TX_DETECT_HANG,
 	__IXGBE_HANG_CHECK_ARMED,
 	__IXGBE_TX_XDP_RING,
+	__IXGBE_TX_RECOVER_REQUESTED,
 #ifdef HAVE_AF_XDP_ZC_SUPPORT
 	__IXGBE_TX_DISABLED,
 #endif
@@ -490,6 +533,9 @@ struct ixgbe_ring {
 		struct ixgbe_rx_queue_stats rx_stats;
 	};
 	u16 rx_offset;
+	u16 rx_fill_target;		/* Rx buffers to keep posted */
+	u64 rx_fill_packets;		/* stats.packets at last fill review */
+	unsigned long last_tx_recovery;	/* jiffies of last queue recovery */
 	spinlock_t tx_lock;		/* used in XDP mode */
 #ifdef HAVE_XDP_BUFF_RXQ
 	struct xdp_rxq_info xdp_rxq;
@@ -844,8 +890,145 @@ struct ixgbe_therm_proc_data {
 #define IXGBE_TRY_LINK_TIMEOUT	(4 * HZ)
 #define IXGBE_SFP_POLL_JIFFIES	(2 * HZ)	/* SFP poll every 2 seconds */
 
+/* Multispeed fiber link bring-up is run as a state machine from the service
+ * task instead of sleeping in ixgbe_setup_mac_link_multispeed_fiber().  Each
+ * speed is tried in turn: the module is given time to switch its analog
+ * characteristics, then the MAC is set up and link is awaited.  Link status
+ * changes wake the state machine through the LSC interrupt, and an hrtimer
+ * re-runs it at the end of each wait period.
+ */
+enum ixgbe_msf_state {
+	IXGBE_MSF_IDLE = 0,
+	IXGBE_MSF_SETTLE,	/* rate select changed, module settling */
+	IXGBE_MSF_WAIT_LINK,	/* MAC set up, waiting for link partner */
+};
+
+#define IXGBE_MSF_SETTLE_USECS		40000
+/* Per IEEE 802.3ap, Section 73.10.2, we may have to wait up to 500ms if KR
+ * is attempted.  82599 uses the same timing for 10g SFI.
+ */
+#define IXGBE_MSF_10G_LINK_USECS	500000
+#define IXGBE_MSF_1G_LINK_USECS		100000
+#define IXGBE_MSF_POLL_USECS		10000
+
+#ifdef ETHTOOL_GMODULEINFO
+/* Pluggable module EEPROM contents are cached so that ethtool -m does not
+ * bit-bang hundreds of bytes over I2C on every call.  The static pages are
+ * read once per module insertion, the SFF-8472 real-time diagnostics (DOM)
+ * are refreshed periodically from a background worker.
+ */
+#define IXGBE_MODULE_DOM_OFFSET		(ETH_MODULE_SFF_8079_LEN + 96)
+#define IXGBE_MODULE_DOM_LEN		32
+#define IXGBE_MODULE_DOM_INTERVAL	(5 * HZ)
+#define IXGBE_MODULE_RETRY_INTERVAL	(HZ / 10)
+
+struct ixgbe_module_cache {
+	spinlock_t lock;		/* protects everything below */
+	bool valid;
+	u32 type;			/* ETH_MODULE_SFF_8079 or _8472 */
+	u32 len;
+	unsigned long static_jiffies;	/* when the static pages were read */
+	unsigned long dom_jiffies;	/* when the diagnostics were read */
+	u8 data[ETH_MODULE_SFF_8472_LEN];
+};
+
+#endif /* ETHTOOL_GMODULEINFO */
+enum ixgbe_link_phase {
+	IXGBE_LINK_PHASE_SFP_DETECT,	/* module event until identified */
+	IXGBE_LINK_PHASE_SFP_SETUP,	/* module setup (setup_sfp) */
+	IXGBE_LINK_PHASE_LINK_CONFIG,	/* link setup until link is up */
+	IXGBE_LINK_PHASE_NUM
+};
+
+struct ixgbe_link_timing {
+	ktime_t start;			/* module event or link (re)config */
+	ktime_t phase_start;
+	u32 phase_usecs[IXGBE_LINK_PHASE_NUM];
+	u32 total_usecs;		/* last bring-up, start to carrier on */
+	u32 count;			/* number of completed bring-ups */
+};
+
+/* Software copy of configuration registers that only the driver writes.
+ * Read-modify-write sequences on these are served from memory instead of
+ * uncached MMIO reads, and writes that would not change the register are
+ * dropped.  The copy is invalidated whenever the MAC is reset.
+ */
+enum ixgbe_shadow_reg {
+	IXGBE_SHADOW_SRRCTL,
+	IXGBE_SHADOW_RXDCTL,
+	IXGBE_SHADOW_PSRTYPE,
+	IXGBE_SHADOW_VMOLR,
+	IXGBE_SHADOW_RETA,		/* RETA followed by ERETA */
+	IXGBE_SHADOW_RSSRK,
+	IXGBE_SHADOW_VLNCTRL,
+	IXGBE_SHADOW_NUM_TYPES
+};
+
+#define IXGBE_SHADOW_SIZE	(128 + 128 + 64 + 64 + 128 + 10 + 1)
+
+struct ixgbe_reg_shadow {
+	spinlock_t lock;		/* keeps register and copy in sync */
+	u32 val[IXGBE_SHADOW_SIZE];
+	DECLARE_BITMAP(valid, IXGBE_SHADOW_SIZE);
+};
+
 #define IXGBE_PRIMARY_ABORT_LIMIT	5
 
+/* MAC loopback throughput benchmark, triggered through debugfs */
+#define IXGBE_LB_BENCH_MIN_FRAME	64
+#define IXGBE_LB_BENCH_MAX_FRAME	1514
+#define IXGBE_LB_BENCH_MAX_MSECS	10000
+#define IXGBE_LB_BENCH_LAT_SAMPLES	64
+#define IXGBE_LB_BENCH_MAX_QUEUES	64
+
+struct ixgbe_lb_bench_queue {
+	u64 packets;		/* frames received back */
+	u64 bytes;
+	u64 elapsed_ns;
+	u64 cycles;		/* CPU cycles spent posting and cleaning */
+	u32 lat_min_ns;		/* single frame Tx post to Rx writeback */
+	u32 lat_avg_ns;
+	u32 lat_max_ns;
+};
+
+struct ixgbe_lb_bench {
+	u32 frame_size;
+	u32 duration_ms;	/* per queue pair */
+	int status;		/* 0 or negative errno of the last run */
+	u32 num_queues;		/* queue pairs with a result below */
+	struct ixgbe_lb_bench_queue queue[IXGBE_LB_BENCH_MAX_QUEUES];
+};
+
+/* failure points that can be armed through the kernel fault-injection
+ * framework, see ixgbe_dbg_fault_init
+ */
+enum ixgbe_fault_type {
+	IXGBE_FAULT_DMA_MAP,		/* Tx map and Rx page map */
+	IXGBE_FAULT_PAGE_ALLOC,		/* Rx page allocation */
+	IXGBE_FAULT_REG_READ,		/* MMIO read returns all ones */
+	IXGBE_FAULT_ACI_TIMEOUT,	/* E610 admin command times out */
+	IXGBE_FAULT_NUM_TYPES
+};
+
+#ifdef CONFIG_FAULT_INJECTION
+extern struct fault_attr ixgbe_fault_attr[IXGBE_FAULT_NUM_TYPES];
+
+static inline bool ixgbe_should_fail(enum ixgbe_fault_type type)
+{
+	return should_fail(&ixgbe_fault_attr[type], 1);
+}
+#else
+static inline bool ixgbe_should_fail(enum ixgbe_fault_type type)
+{
+	return false;
+}
+#endif /* CONFIG_FAULT_INJECTION */
+
+/* a Tx queue that hangs again this soon after being recovered on its own
+ * gets a full adapter reset instead
+ */
+#define IXGBE_TX_RECOVERY_INTERVAL	(30 * HZ)
+
 enum ixgbe_state_t {
 	__IXGBE_TESTING,
 	__IXGBE_RESETTING,
@@ -860,9 +1043,68 @@ enum ixgbe_state_t {
 	__IXGBE_PTP_TX_IN_PROGRESS,
 #endif
 	__IXGBE_RESET_REQUESTED,
+	__IXGBE_TX_RECOVERY_REQUESTED,
 	__IXGBE_STATE_T_NUM /* Must be last */
 };
 
+/* ethtool ether-proto rule held in one of the ETQF/ETQS slots */
+struct ixgbe_etype_filter {
+	u16 sw_idx;
+	u16 etype;
+	u16 ring;	/* Rx ring the matching frames are steered to */
+	bool lli;	/* raise a low latency interrupt on match */
+	bool used;
+};
+
+#ifdef HAVE_PTP_1588_CLOCK
+/* Software definable pins usable for Timesync clock out and aux timestamps */
+#define IXGBE_PTP_N_PINS	4
+#define IXGBE_PTP_N_PEROUT	2
+#define IXGBE_PTP_N_EXTTS	2
+
+/* periodic output request, in PHC nanoseconds */
+struct ixgbe_ptp_perout {
+	u64 start;
+	u64 period;
+};
+
+#define IXGBE_PTP_HOLDOVER_TIMEOUT	10	/* seconds without servo */
+
+/* Scaled ppm is ppm with a 16-bit binary fractional field, so
+ *
+ *    scaled_ppm = ppb * 2^16 / 1000
+ *
+ * which simplifies to
+ *
+ *    scaled_ppm = ppb * 2^13 / 125
+ */
+#define IXGBE_PPB_TO_SCALED_PPM(ppb)	(((long)(ppb) << 13) / 125)
+#define IXGBE_SCALED_PPM_TO_PPB(sppm)	(((long)(sppm) * 125) / 8192)
+
+/* PHC holdover: frequency learned from the servo, replayed when it stops */
+struct ixgbe_ptp_holdover {
+	bool enabled;
+	bool active;
+	bool temp_valid;
+	u32 timeout;		/* seconds without adjfine before holdover */
+	s32 tempco;		/* ppb per degree C applied in holdover */
+	s32 temp;		/* last thermal sensor reading, degrees C */
+	s32 ref_temp;		/* temperature at the last servo update */
+	u32 samples;
+	long last_scaled_ppm;	/* last correction from the servo */
+	long avg_scaled_ppm;	/* smoothed servo correction */
+	long applied_scaled_ppm; /* correction applied in holdover */
+	unsigned long last_update;
+	unsigned long last_temp_read;	/* jiffies of the last I2C sensor read */
+	unsigned long start;
+	u32 entries;
+	u64 total_secs;
+	s64 last_step_ns;	/* servo step ending the last holdover */
+	s64 max_step_ns;
+};
+
+#endif /* HAVE_PTP_1588_CLOCK */
+
 /* board specific private data structure */
 struct ixgbe_adapter {
 #if defined(NETIF_F_HW_VLAN_TX) || defined(NETIF_F_HW_VLAN_CTAG_TX)
@@ -958,9 +1200,15 @@ struct ixgbe_adapter {
 #define IXGBE_FLAG2_VLAN_PROMISC		(u32)(1 << 18)
 #define IXGBE_FLAG2_RX_LEGACY			(u32)(1 << 19)
 #define IXGBE_FLAG2_AUTO_DISABLE_VF		BIT(20)
+#define IXGBE_FLAG2_RINGS_RETAINED		BIT(21)
+#define IXGBE_FLAG2_RX_IDLE_SHRINK		BIT(22)
+#define IXGBE_FLAG2_IPSEC_ENABLED		BIT(23)
 #define IXGBE_FLAG2_PHY_FW_LOAD_FAILED		BIT(24)
 #define IXGBE_FLAG2_NO_MEDIA			BIT(25)
 #define IXGBE_FLAG2_FWLOG_CAPABLE		BIT(26)
+#define IXGBE_FLAG2_MACSEC_ENABLED		BIT(27)
+#define IXGBE_FLAG2_FWD_POOLS			BIT(28)
+#define IXGBE_FLAG2_RSC_LOW_ITR			BIT(29)
 
 	/* Tx fast path data */
 	int num_tx_queues;
@@ -989,19 +1237,27 @@ struct ixgbe_adapter {
 	u64 restart_queue;
 	u64 lsc_int;
 	u32 tx_timeout_count;
+	u32 tx_queue_recovery_count;
 
 	/* RX */
 	struct ixgbe_ring *rx_ring[MAX_RX_QUEUES];
 	int num_rx_pools; /* does not include pools assigned to VFs */
+	unsigned long rx_fill_review;	/* jiffies of last fill target review */
 	int num_rx_queues_per_pool;
 	u64 hw_csum_rx_error;
 	u64 hw_rx_no_dma_resources;
 	u64 rsc_total_count;
 	u64 rsc_total_flush;
+	u64 rsc_total_hist[IXGBE_RSC_HIST_BUCKETS];
+	u8 rsc_maxdesc[MAX_RX_QUEUES];	/* 0 sizes it from the Rx buffer */
 	u64 non_eop_descs;
 	u32 alloc_rx_page;
 	u32 alloc_rx_page_failed;
 	u32 alloc_rx_buff_failed;
+#ifdef HAVE_IXGBE_IPSEC
+	u64 rx_ipsec;
+	u64 tx_ipsec;
+#endif /* HAVE_IXGBE_IPSEC */
 
 	struct ixgbe_q_vector *q_vector[MAX_MSIX_Q_VECTORS];
 
@@ -1058,6 +1314,21 @@ struct ixgbe_adapter {
 	unsigned long sfp_poll_time;
 	unsigned long link_check_timeout;
 
+	/* multispeed fiber link bring-up, see enum ixgbe_msf_state */
+	struct hrtimer msf_timer;
+	enum ixgbe_msf_state msf_state;
+	ixgbe_link_speed msf_speed;	/* speeds not yet tried */
+	ixgbe_link_speed msf_try;	/* speed currently being tried */
+	ixgbe_link_speed msf_highest;	/* fall back to this speed */
+	bool msf_fallback;
+	ktime_t msf_deadline;
+	struct ixgbe_link_timing link_timing;
+	struct ixgbe_reg_shadow reg_shadow;
+#ifdef ETHTOOL_GMODULEINFO
+	struct ixgbe_module_cache module_cache;
+	struct delayed_work module_task;
+#endif
+
 	struct timer_list service_timer;
 	struct work_struct service_task;
 
@@ -1065,6 +1336,8 @@ struct ixgbe_adapter {
 	unsigned long fdir_overflow; /* number of times ATR was backed off */
 	union ixgbe_atr_input fdir_mask;
 	int fdir_filter_count;
+	struct ixgbe_etype_filter etype_filter[IXGBE_MAX_ETQF_FILTERS];
+	int etype_filter_count;
 	u32 fdir_pballoc;
 	u32 atr_sample_rate;
 	spinlock_t fdir_perfect_lock;
@@ -1072,6 +1345,16 @@ struct ixgbe_adapter {
 #if IS_ENABLED(CONFIG_FCOE)
 	struct ixgbe_fcoe fcoe;
 #endif /* CONFIG_FCOE */
+#ifdef HAVE_IXGBE_IPSEC
+	struct ixgbe_ipsec *ipsec;
+#endif /* HAVE_IXGBE_IPSEC */
+#ifdef HAVE_IXGBE_MACSEC
+	struct ixgbe_macsec *macsec;
+#endif /* HAVE_IXGBE_MACSEC */
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+	/* offloaded macvlans, indexed by VMDq pool; pool 0 is the PF */
+	struct ixgbe_fwd_adapter *fwd_priv[IXGBE_MAX_MACVLANS + 1];
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 	u8 __iomem *io_addr;	/* Mainly for iounmap use */
 	u32 wol;
 
@@ -1098,7 +1381,9 @@ struct ixgbe_adapter {
 	unsigned long ptp_tx_start;
 	unsigned long last_overflow_check;
 	unsigned long last_rx_ptp_check;
-	spinlock_t tmreg_lock;
+	spinlock_t tmreg_lock;	/* serializes writers of hw_cc/hw_tc */
+	seqcount_t hw_tc_seq;	/* lets readers of hw_cc/hw_tc skip the lock */
+	spinlock_t tslatch_lock; /* latching SYSTIME/AUXSTMP register reads */
 	struct cyclecounter hw_cc;
 	struct timecounter hw_tc;
 	u32 base_incval;
@@ -1106,6 +1391,16 @@ struct ixgbe_adapter {
 	u32 tx_hwtstamp_skipped;
 	u32 rx_hwtstamp_cleared;
 	void (*ptp_setup_sdp) (struct ixgbe_adapter *);
+	void (*ptp_set_rate)(struct ixgbe_adapter *, long scaled_ppm);
+	struct ixgbe_ptp_holdover ptp_holdover;
+	struct ixgbe_ptp_perout ptp_perout[IXGBE_PTP_N_PEROUT];
+	u8 ptp_perout_ena;	/* bitmap of enabled periodic outputs */
+	u8 ptp_extts_ena;	/* bitmap of enabled aux timestamp channels */
+	unsigned long ptp_sdps;	/* bitmap of SDPs left free for Timesync */
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+	struct ptp_pin_desc ptp_pins[IXGBE_PTP_N_PINS];
+	u8 ptp_pin_sdp[IXGBE_PTP_N_PINS];	/* SDP behind each pin */
+#endif
 #endif /* HAVE_PTP_1588_CLOCK */
 
 	DECLARE_BITMAP(active_vfs, IXGBE_MAX_VF_FUNCTIONS);
@@ -1146,6 +1441,7 @@ struct ixgbe_adapter {
 	struct dentry *ixgbe_dbg_adapter_fw_cluster;
 	void *ixgbe_cluster_blk;
 	u16 fw_dump_cluster_id;
+	struct ixgbe_lb_bench lb_bench;
 #endif /*HAVE_IXGBE_DEBUG_FS*/
 	u8 default_up;
 #ifdef HAVE_TC_SETUP_CLSU32
@@ -1224,6 +1520,32 @@ static inline u8 ixgbe_max_rss_indices(struct ixgbe_adapter *adapter)
 	}
 }
 
+/* While macvlans are offloaded the netdev carries a single traffic class
+ * that only fences the PF into pool 0.  It is not DCB and must not be
+ * handed back to ixgbe_setup_tc().
+ */
+static inline u8 ixgbe_dcb_tcs(struct ixgbe_adapter *adapter)
+{
+	if (adapter->flags2 & IXGBE_FLAG2_FWD_POOLS)
+		return 0;
+
+	return netdev_get_num_tc(adapter->netdev);
+}
+
+/* RSC is turned off while Rx interrupts fire faster than
+ * IXGBE_MIN_RSC_ITR, unless the rsc-low-itr private flag keeps it on for
+ * any non-zero interval.  Dynamic ITR (1) always keeps it on.
+ */
+static inline bool ixgbe_rsc_itr_ok(struct ixgbe_adapter *adapter)
+{
+	if (adapter->rx_itr_setting == 1)
+		return true;
+	if (adapter->flags2 & IXGBE_FLAG2_RSC_LOW_ITR)
+		return !!adapter->rx_itr_setting;
+
+	return adapter->rx_itr_setting > IXGBE_MIN_RSC_ITR;
+}
+
 struct ixgbe_fdir_filter {
 	struct  hlist_node fdir_node;
 	union ixgbe_atr_input filter;
@@ -1231,6 +1553,16 @@ struct ixgbe_fdir_filter {
 	u64 action;
 };
 
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+/* macvlan upper device whose traffic runs on its own VMDq pool */
+struct ixgbe_fwd_adapter {
+	struct net_device *netdev;
+	unsigned int tx_base_queue;
+	unsigned int rx_base_queue;
+	int pool;
+};
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 struct ixgbe_cb {
 #ifdef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
 	union {				/* Union defining head/tail partner */
@@ -1315,6 +1647,9 @@ void ixgbe_clear_udp_tunnel_port(struct ixgbe_adapter *, u32);
 int ixgbe_update_ethtool_fdir_entry(struct ixgbe_adapter *adapter,
 				    struct ixgbe_fdir_filter *input,
 				    u16 sw_idx);
+u8 ixgbe_etype_filter_reserved(struct ixgbe_adapter *adapter);
+bool ixgbe_etype_filter_owned(struct ixgbe_adapter *adapter, u16 etype);
+void ixgbe_etype_filter_write(struct ixgbe_adapter *adapter, int idx);
 void ixgbe_set_rx_mode(struct net_device *netdev);
 int ixgbe_write_mc_addr_list(struct net_device *netdev);
 int ixgbe_setup_tc(struct net_device *dev, u8 tc);
@@ -1365,10 +1700,33 @@ int ixgbe_fcoe_get_wwn(struct net_device *netdev, u64 *wwn, int type);
 #endif
 #endif /* CONFIG_FCOE */
 
+#ifdef HAVE_IXGBE_IPSEC
+void ixgbe_init_ipsec_offload(struct ixgbe_adapter *adapter);
+void ixgbe_stop_ipsec_offload(struct ixgbe_adapter *adapter);
+void ixgbe_ipsec_restore(struct ixgbe_adapter *adapter);
+void ixgbe_ipsec_rx(struct ixgbe_ring *rx_ring,
+		    union ixgbe_adv_rx_desc *rx_desc,
+		    struct sk_buff *skb);
+int ixgbe_ipsec_tx(struct ixgbe_ring *tx_ring, struct ixgbe_tx_buffer *first,
+		   struct ixgbe_ipsec_tx_data *itd);
+#endif /* HAVE_IXGBE_IPSEC */
+
+#ifdef HAVE_IXGBE_MACSEC
+void ixgbe_init_macsec_offload(struct ixgbe_adapter *adapter);
+void ixgbe_stop_macsec_offload(struct ixgbe_adapter *adapter);
+void ixgbe_macsec_restore(struct ixgbe_adapter *adapter);
+void ixgbe_macsec_save_pn(struct ixgbe_adapter *adapter);
+void ixgbe_macsec_update_stats(struct ixgbe_adapter *adapter);
+bool ixgbe_macsec_rx_drop(struct ixgbe_ring *rx_ring,
+			  union ixgbe_adv_rx_desc *rx_desc);
+#endif /* HAVE_IXGBE_MACSEC */
+
 #ifdef HAVE_IXGBE_DEBUG_FS
 void ixgbe_dbg_adapter_init(struct ixgbe_adapter *adapter);
 void ixgbe_dbg_adapter_exit(struct ixgbe_adapter *adapter);
 void ixgbe_dbg_init(void);
+int ixgbe_lb_bench_run(struct ixgbe_adapter *adapter, u32 frame_size,
+		       u32 duration_ms);
 void ixgbe_dbg_exit(void);
 #endif /* HAVE_IXGBE_DEBUG_FS */
 
@@ -1439,6 +1797,9 @@ int ixgbe_ptp_set_ts_config(struct ixgbe_adapter *adapter, struct ifreq *ifr);
 void ixgbe_ptp_start_cyclecounter(struct ixgbe_adapter *adapter);
 void ixgbe_ptp_reset(struct ixgbe_adapter *adapter);
 void ixgbe_ptp_check_pps_event(struct ixgbe_adapter *adapter);
+void ixgbe_ptp_check_extts(struct ixgbe_adapter *adapter);
+void ixgbe_ptp_holdover_check(struct ixgbe_adapter *adapter);
+void ixgbe_ptp_holdover_enable(struct ixgbe_adapter *adapter, bool enable);
 #endif /* HAVE_PTP_1588_CLOCK */
 #ifdef CONFIG_PCI_IOV
 void ixgbe_sriov_reinit(struct ixgbe_adapter *adapter);
@@ -1448,6 +1809,15 @@ void ixgbe_store_key(struct ixgbe_adapter *adapter);
 void ixgbe_store_reta(struct ixgbe_adapter *adapter);
 
 void ixgbe_set_rx_drop_en(struct ixgbe_adapter *adapter);
+u32 ixgbe_shadow_read(struct ixgbe_adapter *adapter,
+		      enum ixgbe_shadow_reg type, u32 idx);
+void ixgbe_shadow_write(struct ixgbe_adapter *adapter,
+			enum ixgbe_shadow_reg type, u32 idx, u32 value);
+void ixgbe_reg_shadow_invalidate(struct ixgbe_adapter *adapter);
+#ifdef ETHTOOL_GMODULEINFO
+int ixgbe_read_module_eeprom(struct ixgbe_adapter *adapter, u32 offset,
+			     u32 len, u8 *data);
+#endif
 
 bool ixgbe_fwlog_ring_full(struct ixgbe_fwlog_ring *rings);
 bool ixgbe_fwlog_ring_empty(struct ixgbe_fwlog_ring *rings);
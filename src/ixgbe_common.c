@@ -5077,11 +5077,12 @@ s32 ixgbe_setup_mac_link_multispeed_fiber(struct ixgbe_hw *hw,
 
 		/* Wait for the controller to acquire link.  Per IEEE 802.3ap,
 		 * Section 73.10.2, we may have to wait up to 500ms if KR is
-		 * attempted.  82599 uses the same timing for 10g SFI.
+		 * attempted.  82599 uses the same timing for 10g SFI.  Poll
+		 * in small steps so that we return as soon as link is up.
 		 */
-		for (i = 0; i < 5; i++) {
+		for (i = 0; i < 50; i++) {
 			/* Wait for the link partner to also set speed */
-			msec_delay(100);
+			msec_delay(10);
 
 			/* If we have link, just jump out */
 			status = ixgbe_check_link(hw, &link_speed,
@@ -5125,16 +5126,19 @@ s32 ixgbe_setup_mac_link_multispeed_fiber(struct ixgbe_hw *hw,
 		/* Flap the Tx laser if it has not already been done */
 		ixgbe_flap_tx_laser(hw);
 
-		/* Wait for the link partner to also set speed */
-		msec_delay(100);
+		for (i = 0; i < 10; i++) {
+			/* Wait for the link partner to also set speed */
+			msec_delay(10);
 
-		/* If we have link, just jump out */
-		status = ixgbe_check_link(hw, &link_speed, &link_up, false);
-		if (status != IXGBE_SUCCESS)
-			return status;
+			/* If we have link, just jump out */
+			status = ixgbe_check_link(hw, &link_speed,
+						  &link_up, false);
+			if (status != IXGBE_SUCCESS)
+				return status;
 
-		if (link_up)
-			goto out;
+			if (link_up)
+				goto out;
+		}
 	}
 
 	/* We didn't get link.  Configure back to the highest speed we tried,
@@ -255,6 +255,8 @@ static ssize_t ixgbe_dbg_reg_ops_write(struct file *filp,
 		/* check format and bounds check register access */
 		if (cnt == 2 && reg <= IXGBE_HFDR) {
 			IXGBE_WRITE_REG(&adapter->hw, reg, value);
+			/* the register may be one the driver shadows */
+			ixgbe_reg_shadow_invalidate(adapter);
 			value = IXGBE_READ_REG(&adapter->hw, reg);
 			e_dev_info("write: 0x%08x = 0x%08x\n", reg, value);
 		} else {
@@ -382,6 +384,545 @@ static struct file_operations ixgbe_dbg_netdev_ops_fops = {
 	.write = ixgbe_dbg_netdev_ops_write,
 };
 
+/**
+ * ixgbe_dbg_link_timing_read - read link bring-up timing
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ **/
+static ssize_t ixgbe_dbg_link_timing_read(struct file *filp,
+					  char __user *buffer,
+					  size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	struct ixgbe_link_timing *lt = &adapter->link_timing;
+	char *buf;
+	int len;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	buf = kasprintf(GFP_KERNEL,
+			"count: %u\ntotal_us: %u\nsfp_detect_us: %u\n"
+			"sfp_setup_us: %u\nlink_config_us: %u\n",
+			lt->count, lt->total_usecs,
+			lt->phase_usecs[IXGBE_LINK_PHASE_SFP_DETECT],
+			lt->phase_usecs[IXGBE_LINK_PHASE_SFP_SETUP],
+			lt->phase_usecs[IXGBE_LINK_PHASE_LINK_CONFIG]);
+	if (!buf)
+		return -ENOMEM;
+
+	if (count < strlen(buf)) {
+		kfree(buf);
+		return -ENOSPC;
+	}
+
+	len = simple_read_from_buffer(buffer, count, ppos, buf, strlen(buf));
+
+	kfree(buf);
+	return len;
+}
+
+static const struct file_operations ixgbe_dbg_link_timing_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_link_timing_read,
+};
+
+#ifdef ETHTOOL_GMODULEINFO
+/**
+ * ixgbe_dbg_module_cache_read - read module EEPROM cache state
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ **/
+static ssize_t ixgbe_dbg_module_cache_read(struct file *filp,
+					   char __user *buffer,
+					   size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
+	unsigned int static_age, dom_age, len;
+	bool valid;
+	char *buf;
+	int ret;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	spin_lock_bh(&mc->lock);
+	valid = mc->valid;
+	len = mc->len;
+	static_age = jiffies_to_msecs(jiffies - mc->static_jiffies);
+	dom_age = jiffies_to_msecs(jiffies - mc->dom_jiffies);
+	spin_unlock_bh(&mc->lock);
+
+	if (valid)
+		buf = kasprintf(GFP_KERNEL,
+				"valid: 1\nlen: %u\nstatic_age_ms: %u\n"
+				"dom_age_ms: %u\n",
+				len, static_age, dom_age);
+	else
+		buf = kasprintf(GFP_KERNEL, "valid: 0\n");
+	if (!buf)
+		return -ENOMEM;
+
+	if (count < strlen(buf)) {
+		kfree(buf);
+		return -ENOSPC;
+	}
+
+	ret = simple_read_from_buffer(buffer, count, ppos, buf, strlen(buf));
+
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations ixgbe_dbg_module_cache_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_module_cache_read,
+};
+
+#endif /* ETHTOOL_GMODULEINFO */
+/**
+ * ixgbe_dbg_lb_bench_read - report the last loopback benchmark result
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ **/
+static ssize_t ixgbe_dbg_lb_bench_read(struct file *filp, char __user *buffer,
+				       size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	struct ixgbe_lb_bench *res = &adapter->lb_bench;
+	size_t size, len;
+	unsigned int q;
+	char *buf;
+	int ret;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	/* header plus one line of ten key=value fields per queue */
+	size = 128 + res->num_queues * 320;
+	buf = kzalloc(size, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	len = scnprintf(buf, size,
+			"frame_size: %u\nduration_ms: %u\nstatus: %d\n"
+			"queues: %u\n",
+			res->frame_size, res->duration_ms, res->status,
+			res->num_queues);
+
+	for (q = 0; q < res->num_queues; q++) {
+		struct ixgbe_lb_bench_queue *qres = &res->queue[q];
+		u64 kpps = 0, mbps = 0, cpp = 0;
+
+		if (qres->elapsed_ns) {
+			kpps = div64_u64(qres->packets * USEC_PER_SEC,
+					 qres->elapsed_ns);
+			mbps = div64_u64(qres->bytes * 8 * MSEC_PER_SEC,
+					 qres->elapsed_ns);
+		}
+		if (qres->packets)
+			cpp = div64_u64(qres->cycles, qres->packets);
+
+		len += scnprintf(buf + len, size - len,
+				 "queue=%u packets=%llu bytes=%llu elapsed_ns=%llu kpps=%llu mbps=%llu cycles_per_pkt=%llu lat_min_ns=%u lat_avg_ns=%u lat_max_ns=%u\n",
+				 q, qres->packets, qres->bytes,
+				 qres->elapsed_ns, kpps, mbps, cpp,
+				 qres->lat_min_ns, qres->lat_avg_ns,
+				 qres->lat_max_ns);
+	}
+
+	if (count < len) {
+		kfree(buf);
+		return -ENOSPC;
+	}
+
+	ret = simple_read_from_buffer(buffer, count, ppos, buf, len);
+
+	kfree(buf);
+	return ret;
+}
+
+/**
+ * ixgbe_dbg_lb_bench_write - start a loopback benchmark
+ * @filp: the opened file
+ * @buffer: where to find the user's data
+ * @count: the length of the user's data
+ * @ppos: file position offset
+ *
+ * Expects "<frame_size> <duration_ms>", the duration applying to each
+ * queue pair.  The interface is taken offline for the whole run.
+ **/
+static ssize_t ixgbe_dbg_lb_bench_write(struct file *filp,
+					const char __user *buffer,
+					size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	u32 frame_size, duration_ms;
+	char kbuf[32] = { 0 };
+	ssize_t len;
+	int err;
+
+	/* don't allow partial writes */
+	if (*ppos != 0)
+		return 0;
+
+	len = simple_write_to_buffer(kbuf, sizeof(kbuf) - 1, ppos, buffer,
+				     count);
+	if (len < 0)
+		return len;
+
+	if (sscanf(kbuf, "%u %u", &frame_size, &duration_ms) != 2)
+		return -EINVAL;
+
+	rtnl_lock();
+	err = ixgbe_lb_bench_run(adapter, frame_size, duration_ms);
+	rtnl_unlock();
+
+	return err ? err : count;
+}
+
+static const struct file_operations ixgbe_dbg_lb_bench_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_lb_bench_read,
+	.write = ixgbe_dbg_lb_bench_write,
+};
+
+/**
+ * ixgbe_dbg_rx_pages - bytes of Rx pages currently held by a ring
+ * @rx_ring: rx descriptor ring
+ *
+ * Counts buffers posted to hardware plus pages parked for reuse.  Pages
+ * already handed up the stack belong to the stack and are not included.
+ **/
+static u64 ixgbe_dbg_rx_pages(struct ixgbe_ring *rx_ring)
+{
+	int held;
+
+#ifdef HAVE_AF_XDP_ZC_SUPPORT
+	/* zero-copy buffers belong to the umem */
+	if (rx_ring->xsk_pool)
+		return 0;
+#endif
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+	held = READ_ONCE(rx_ring->next_to_alloc) -
+	       READ_ONCE(rx_ring->next_to_clean);
+	if (held < 0)
+		held += rx_ring->count;
+
+	return (u64)held * ixgbe_rx_pg_size(rx_ring);
+#else
+	held = rx_ring->count - 1 - ixgbe_desc_unused(rx_ring);
+
+	return (u64)held * rx_ring->rx_buf_len;
+#endif
+}
+
+/**
+ * ixgbe_dbg_memory_read - report the adapter's memory footprint
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ *
+ * Sizes are derived from the live driver state, in bytes.
+ **/
+static ssize_t ixgbe_dbg_memory_read(struct file *filp, char __user *buffer,
+				     size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	u64 desc = 0, buf_info = 0, rx_pages = 0, q_vectors = 0;
+	u64 vf = 0, fcoe = 0, fwlog = 0, total;
+	struct ixgbe_hw *hw = &adapter->hw;
+	char *buf;
+	int i, ret;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	/* rings, vectors and the fwlog ring only change under rtnl */
+	rtnl_lock();
+	for (i = 0; i < adapter->num_tx_queues; i++) {
+		struct ixgbe_ring *ring = adapter->tx_ring[i];
+
+		if (!ring || !ring->desc)
+			continue;
+		desc += ring->size;
+		buf_info += sizeof(struct ixgbe_tx_buffer) * ring->count;
+	}
+	for (i = 0; i < adapter->num_xdp_queues; i++) {
+		struct ixgbe_ring *ring = adapter->xdp_ring[i];
+
+		if (!ring || !ring->desc)
+			continue;
+		desc += ring->size;
+		buf_info += sizeof(struct ixgbe_tx_buffer) * ring->count;
+	}
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		struct ixgbe_ring *ring = adapter->rx_ring[i];
+
+		if (!ring || !ring->desc)
+			continue;
+		desc += ring->size;
+		buf_info += sizeof(struct ixgbe_rx_buffer) * ring->count;
+		rx_pages += ixgbe_dbg_rx_pages(ring);
+	}
+	for (i = 0; i < adapter->num_q_vectors; i++) {
+		struct ixgbe_q_vector *q_vector = adapter->q_vector[i];
+
+		if (!q_vector)
+			continue;
+		q_vectors += struct_size(q_vector, ring,
+					 q_vector->tx.count +
+					 q_vector->rx.count);
+	}
+
+	if (adapter->vfinfo)
+		vf += sizeof(struct vf_data_storage) * adapter->num_vfs;
+	if (adapter->mv_list) {
+		struct list_head *pos;
+
+		list_for_each(pos, &adapter->vf_mvs.l)
+			vf += sizeof(struct vf_macvlans);
+	}
+#if IS_ENABLED(CONFIG_FCOE)
+
+	if (adapter->fcoe.extra_ddp_buffer)
+		fcoe += IXGBE_FCBUFF_MIN;
+	for (i = 0; i < IXGBE_FCOE_DDP_MAX_X550; i++) {
+		if (adapter->fcoe.ddp[i].udl)
+			fcoe += IXGBE_FCPTR_MAX;
+	}
+#endif /* CONFIG_FCOE */
+
+	/* each ring entry owns a PAGE_SIZE buffer; data_size only tracks the
+	 * length of the last message copied into it
+	 */
+	if (hw->fwlog_ring.rings)
+		fwlog = sizeof(*hw->fwlog_ring.rings) *
+			IXGBE_FWLOG_RING_SIZE_DFLT +
+			(u64)hw->fwlog_ring.size * PAGE_SIZE;
+	rtnl_unlock();
+
+	total = sizeof(*adapter) + desc + buf_info + rx_pages + q_vectors +
+		vf + fcoe + fwlog;
+
+	buf = kasprintf(GFP_KERNEL,
+			"adapter: %zu\ndesc_rings: %llu\nbuffer_info: %llu\n"
+			"rx_pages: %llu\nq_vectors: %llu\nvf_state: %llu\n"
+			"fcoe_ddp: %llu\nfwlog: %llu\ntotal: %llu\n",
+			sizeof(*adapter), desc, buf_info, rx_pages, q_vectors,
+			vf, fcoe, fwlog, total);
+	if (!buf)
+		return -ENOMEM;
+
+	if (count < strlen(buf)) {
+		kfree(buf);
+		return -ENOSPC;
+	}
+
+	ret = simple_read_from_buffer(buffer, count, ppos, buf, strlen(buf));
+
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations ixgbe_dbg_memory_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_memory_read,
+};
+
+/* "queue %d: " plus four u64 counters with separators and a newline */
+#define IXGBE_DBG_RSC_LINE_LEN	(18 + 4 * 21 + 1)
+
+/**
+ * ixgbe_dbg_rsc_read - report the RSC aggregation histogram
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ *
+ * One line per Rx queue with the count of aggregations of 2-3, 4-7, 8-15
+ * and 16 or more segments.
+ **/
+static ssize_t ixgbe_dbg_rsc_read(struct file *filp, char __user *buffer,
+				  size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	size_t size, len;
+	char *buf;
+	int i, ret;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	/* rings only change under rtnl */
+	rtnl_lock();
+	size = 64 + IXGBE_DBG_RSC_LINE_LEN * adapter->num_rx_queues;
+	buf = kzalloc(size, GFP_KERNEL);
+	if (!buf) {
+		rtnl_unlock();
+		return -ENOMEM;
+	}
+
+	len = scnprintf(buf, size, "enabled: %d\n",
+			!!(adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED));
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		struct ixgbe_ring *ring = adapter->rx_ring[i];
+		u64 *hist;
+
+		if (!ring)
+			continue;
+
+		hist = ring->rx_stats.rsc_hist;
+		len += scnprintf(buf + len, size - len,
+				 "queue %d: %llu %llu %llu %llu\n",
+				 i, hist[0], hist[1], hist[2], hist[3]);
+	}
+	rtnl_unlock();
+
+	if (count < len) {
+		kfree(buf);
+		return -ENOSPC;
+	}
+
+	ret = simple_read_from_buffer(buffer, count, ppos, buf, len);
+
+	kfree(buf);
+	return ret;
+}
+
+static const struct file_operations ixgbe_dbg_rsc_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_rsc_read,
+};
+
+#ifdef HAVE_PTP_1588_CLOCK
+/**
+ * ixgbe_dbg_ptp_holdover_read - report the PHC holdover state
+ * @filp: the opened file
+ * @buffer: where to write the data for the user to read
+ * @count: the size of the user's buffer
+ * @ppos: file position offset
+ *
+ * Frequencies are in ppb from the nominal clock rate. The step is the
+ * offset the servo corrected when it ended the last holdover, which is
+ * the drift accumulated while free running.
+ **/
+static ssize_t ixgbe_dbg_ptp_holdover_read(struct file *filp,
+					   char __user *buffer,
+					   size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
+	char buf[512];
+	int len;
+
+	/* don't allow partial reads */
+	if (*ppos != 0)
+		return 0;
+
+	len = scnprintf(buf, sizeof(buf),
+			"enabled: %d\nactive: %d\ntimeout_secs: %u\n"
+			"tempco_ppb_per_c: %d\n"
+			"servo_freq_ppb: %ld\nservo_avg_freq_ppb: %ld\n"
+			"holdover_freq_ppb: %ld\n",
+			ho->enabled, ho->active, ho->timeout, ho->tempco,
+			IXGBE_SCALED_PPM_TO_PPB(ho->last_scaled_ppm),
+			IXGBE_SCALED_PPM_TO_PPB(ho->avg_scaled_ppm),
+			IXGBE_SCALED_PPM_TO_PPB(ho->applied_scaled_ppm));
+	if (ho->temp_valid)
+		len += scnprintf(buf + len, sizeof(buf) - len,
+				 "temp_c: %d\nref_temp_c: %d\n",
+				 ho->temp, ho->ref_temp);
+	else
+		len += scnprintf(buf + len, sizeof(buf) - len,
+				 "temp_c: unavailable\n");
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "entries: %u\ntotal_secs: %llu\n"
+			 "last_step_ns: %lld\nmax_step_ns: %lld\n",
+			 ho->entries, ho->total_secs,
+			 ho->last_step_ns, ho->max_step_ns);
+
+	return simple_read_from_buffer(buffer, count, ppos, buf, len);
+}
+
+/**
+ * ixgbe_dbg_ptp_holdover_write - configure the PHC holdover assistance
+ * @filp: the opened file
+ * @buffer: where to find the user's data
+ * @count: the length of the user's data
+ * @ppos: file position offset
+ *
+ * Expects "enable <0|1>", "timeout <secs>" for how long the servo may be
+ * silent before holdover starts, or "tempco <ppb>" for the frequency
+ * change per degree C applied during holdover.
+ **/
+static ssize_t ixgbe_dbg_ptp_holdover_write(struct file *filp,
+					    const char __user *buffer,
+					    size_t count, loff_t *ppos)
+{
+	struct ixgbe_adapter *adapter = filp->private_data;
+	char kbuf[32] = { 0 };
+	ssize_t len;
+	u32 val;
+	s32 sval;
+
+	/* don't allow partial writes */
+	if (*ppos != 0)
+		return 0;
+
+	if (!adapter->ptp_clock)
+		return -EOPNOTSUPP;
+
+	len = simple_write_to_buffer(kbuf, sizeof(kbuf) - 1, ppos, buffer,
+				     count);
+	if (len < 0)
+		return len;
+
+	if (sscanf(kbuf, "enable %u", &val) == 1) {
+		if (val > 1)
+			return -EINVAL;
+		ixgbe_ptp_holdover_enable(adapter, val);
+	} else if (sscanf(kbuf, "timeout %u", &val) == 1) {
+		if (!val || val > 3600)
+			return -EINVAL;
+		adapter->ptp_holdover.timeout = val;
+	} else if (sscanf(kbuf, "tempco %d", &sval) == 1) {
+		if (sval < -1000 || sval > 1000)
+			return -EINVAL;
+		adapter->ptp_holdover.tempco = sval;
+	} else {
+		return -EINVAL;
+	}
+
+	return count;
+}
+
+static const struct file_operations ixgbe_dbg_ptp_holdover_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.read = ixgbe_dbg_ptp_holdover_read,
+	.write = ixgbe_dbg_ptp_holdover_write,
+};
+
+#endif /* HAVE_PTP_1588_CLOCK */
 struct ixgbe_cluster_header {
 	u32 cluster_id;
 	u32 table_id;
@@ -911,7 +1452,9 @@ static ssize_t ixgbe_debugfs_nr_buffs_write(struct file *file, const char __user
 		}
 
 		/* free all the buffers and the tracking info and resize */
+		rtnl_lock();
 		ixgbe_fwlog_realloc_rings(hw, nr_buffs);
+		rtnl_unlock();
 	} else {
 		dev_info(dev, "unknown or invalid command '%s'\n", argv[0]);
 		ret = -EINVAL;
@@ -1273,6 +1816,58 @@ void ixgbe_dbg_adapter_init(struct ixgbe_adapter *adapter)
 		goto create_failed;
 	}
 
+	if (!debugfs_create_file("link_timing", 0400,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_link_timing_fops)) {
+		e_dev_err("debugfs link_timing for %s failed\n", name);
+		goto create_failed;
+	}
+
+#ifdef ETHTOOL_GMODULEINFO
+	if (!debugfs_create_file("module_cache", 0400,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_module_cache_fops)) {
+		e_dev_err("debugfs module_cache for %s failed\n", name);
+		goto create_failed;
+	}
+#endif
+
+	if (!debugfs_create_file("loopback_bench", 0600,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_lb_bench_fops)) {
+		e_dev_err("debugfs loopback_bench for %s failed\n", name);
+		goto create_failed;
+	}
+
+	if (!debugfs_create_file("memory", 0400,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_memory_fops)) {
+		e_dev_err("debugfs memory for %s failed\n", name);
+		goto create_failed;
+	}
+
+	if (!debugfs_create_file("rsc", 0400,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_rsc_fops)) {
+		e_dev_err("debugfs rsc for %s failed\n", name);
+		goto create_failed;
+	}
+
+#ifdef HAVE_PTP_1588_CLOCK
+	if (!debugfs_create_file("ptp_holdover", 0600,
+				 adapter->ixgbe_dbg_adapter_pf,
+				 adapter,
+				 &ixgbe_dbg_ptp_holdover_fops)) {
+		e_dev_err("debugfs ptp_holdover for %s failed\n", name);
+		goto create_failed;
+	}
+#endif
+
 	return;
 
 create_failed:
@@ -1294,14 +1889,50 @@ void ixgbe_dbg_adapter_exit(struct ixgbe_adapter *adapter)
 	adapter->ixgbe_cluster_blk = NULL;
 }
 
+#ifdef CONFIG_FAULT_INJECTION_DEBUG_FS
+static const char * const ixgbe_fault_names[IXGBE_FAULT_NUM_TYPES] = {
+	[IXGBE_FAULT_DMA_MAP]		= "fail_dma_map",
+	[IXGBE_FAULT_PAGE_ALLOC]	= "fail_page_alloc",
+	[IXGBE_FAULT_REG_READ]		= "fail_reg_read",
+	[IXGBE_FAULT_ACI_TIMEOUT]	= "fail_aci_timeout",
+};
+
+/**
+ * ixgbe_dbg_fault_init - expose the driver's fault injection points
+ *
+ * Each point gets the standard fault-inject attribute directory
+ * (probability, interval, times, ...) under the driver's debugfs root.
+ * The points are shared by all ports handled by the driver.
+ **/
+static void ixgbe_dbg_fault_init(void)
+{
+	struct dentry *dir;
+	int i;
+
+	for (i = 0; i < IXGBE_FAULT_NUM_TYPES; i++) {
+		dir = fault_create_debugfs_attr(ixgbe_fault_names[i],
+						ixgbe_dbg_root,
+						&ixgbe_fault_attr[i]);
+		if (IS_ERR(dir))
+			pr_err("debugfs %s failed\n", ixgbe_fault_names[i]);
+	}
+}
+
+#endif /* CONFIG_FAULT_INJECTION_DEBUG_FS */
 /**
  * ixgbe_dbg_init - create root directory for debugfs entries
  **/
 void ixgbe_dbg_init(void)
 {
 	ixgbe_dbg_root = debugfs_create_dir(ixgbe_driver_name, NULL);
-	if (ixgbe_dbg_root == NULL)
+	if (ixgbe_dbg_root == NULL) {
 		pr_err("init of debugfs failed\n");
+		return;
+	}
+#ifdef CONFIG_FAULT_INJECTION_DEBUG_FS
+
+	ixgbe_dbg_fault_init();
+#endif
 }
 
 /**
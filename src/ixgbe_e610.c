@@ -205,7 +205,7 @@ ixgbe_aci_send_cmd_execute(struct ixgbe_hw *hw, struct ixgbe_aci_desc *desc,
 		}
 
 		/* Handle timeout and invalid state of HICR register */
-		if (hicr & PF_HICR_C) {
+		if ((hicr & PF_HICR_C) || IXGBE_INJECT_ACI_TIMEOUT(hw)) {
 			status = IXGBE_ERR_ACI_TIMEOUT;
 			break;
 		} else if (!(hicr & PF_HICR_SV) && !(hicr & PF_HICR_EV)) {
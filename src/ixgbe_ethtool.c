@@ -86,6 +86,7 @@ static struct ixgbe_stats ixgbe_gstrings_stats[] = {
 	IXGBE_STAT("broadcast", stats.bprc),
 	IXGBE_STAT("rx_no_buffer_count", stats.rnbc[0]) ,
 	IXGBE_STAT("tx_timeout_count", tx_timeout_count),
+	IXGBE_STAT("tx_queue_recovery_count", tx_queue_recovery_count),
 	IXGBE_STAT("tx_restart_queue", restart_queue),
 	IXGBE_STAT("rx_length_errors", stats.rlec),
 	IXGBE_STAT("rx_long_length_errors", stats.roc),
@@ -101,6 +102,14 @@ static struct ixgbe_stats ixgbe_gstrings_stats[] = {
 	IXGBE_STAT("rx_no_dma_resources", hw_rx_no_dma_resources),
 	IXGBE_STAT("hw_rsc_aggregated", rsc_total_count),
 	IXGBE_STAT("hw_rsc_flushed", rsc_total_flush),
+	IXGBE_STAT("hw_rsc_agg_2_3", rsc_total_hist[0]),
+	IXGBE_STAT("hw_rsc_agg_4_7", rsc_total_hist[1]),
+	IXGBE_STAT("hw_rsc_agg_8_15", rsc_total_hist[2]),
+	IXGBE_STAT("hw_rsc_agg_16_up", rsc_total_hist[3]),
+#ifdef HAVE_IXGBE_IPSEC
+	IXGBE_STAT("tx_ipsec", tx_ipsec),
+	IXGBE_STAT("rx_ipsec", rx_ipsec),
+#endif /* HAVE_IXGBE_IPSEC */
 #ifdef HAVE_TX_MQ
 	IXGBE_STAT("fdir_match", stats.fdirmatch),
 	IXGBE_STAT("fdir_miss", stats.fdirmiss),
@@ -187,6 +196,12 @@ static const char ixgbe_priv_flags_strings[][ETH_GSTRING_LEN] = {
 #endif
 #define IXGBE_PRIV_FLAGS_AUTO_DISABLE_VF	BIT(2)
 	"mdd-disable-vf",
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+#define IXGBE_PRIV_FLAGS_RX_IDLE_SHRINK	BIT(3)
+	"rx-idle-shrink",
+#endif
+#define IXGBE_PRIV_FLAGS_RSC_LOW_ITR	BIT(4)
+	"rsc-low-itr",
 };
 
 #define IXGBE_PRIV_FLAGS_STR_LEN ARRAY_SIZE(ixgbe_priv_flags_strings)
@@ -794,6 +809,8 @@ static int ixgbe_set_link_ksettings(struct net_device *netdev,
 		while (test_and_set_bit(__IXGBE_IN_SFP_INIT, adapter->state))
 			usleep_range(1000, 2000);
 
+		/* stop any multispeed fiber bring-up from the service task */
+		adapter->msf_state = IXGBE_MSF_IDLE;
 		hw->mac.autotry_restart = true;
 		err = hw->mac.ops.setup_link(hw, advertised, true);
 		if (err) {
@@ -860,6 +877,8 @@ static int ixgbe_set_settings(struct net_device *netdev,
 		while (test_and_set_bit(__IXGBE_IN_SFP_INIT, adapter->state))
 			usleep_range(1000, 2000);
 
+		/* stop any multispeed fiber bring-up from the service task */
+		adapter->msf_state = IXGBE_MSF_IDLE;
 		hw->mac.autotry_restart = true;
 		err = hw->mac.ops.setup_link(hw, advertised, true);
 		if (err) {
@@ -2523,7 +2542,8 @@ static void ixgbe_free_desc_rings(struct ixgbe_adapter *adapter)
 	ixgbe_free_rx_resources(&adapter->test_rx_ring);
 }
 
-static int ixgbe_setup_desc_rings(struct ixgbe_adapter *adapter)
+static int ixgbe_setup_desc_rings(struct ixgbe_adapter *adapter,
+				  unsigned int queue)
 {
 	struct ixgbe_ring *tx_ring = &adapter->test_tx_ring;
 	struct ixgbe_ring *rx_ring = &adapter->test_rx_ring;
@@ -2533,10 +2553,10 @@ static int ixgbe_setup_desc_rings(struct ixgbe_adapter *adapter)
 
 	/* Setup Tx descriptor ring and Tx buffers */
 	tx_ring->count = IXGBE_DEFAULT_TXD;
-	tx_ring->queue_index = 0;
+	tx_ring->queue_index = queue;
 	tx_ring->dev = ixgbe_pf_to_dev(adapter);
 	tx_ring->netdev = adapter->netdev;
-	tx_ring->reg_idx = adapter->tx_ring[0]->reg_idx;
+	tx_ring->reg_idx = adapter->tx_ring[queue]->reg_idx;
 
 	err = ixgbe_setup_tx_resources(tx_ring);
 	if (err)
@@ -2562,10 +2582,10 @@ static int ixgbe_setup_desc_rings(struct ixgbe_adapter *adapter)
 
 	/* Setup Rx Descriptor ring and Rx buffers */
 	rx_ring->count = IXGBE_DEFAULT_RXD;
-	rx_ring->queue_index = 0;
+	rx_ring->queue_index = queue;
 	rx_ring->dev = ixgbe_pf_to_dev(adapter);
 	rx_ring->netdev = adapter->netdev;
-	rx_ring->reg_idx = adapter->rx_ring[0]->reg_idx;
+	rx_ring->reg_idx = adapter->rx_ring[queue]->reg_idx;
 #ifdef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
 	rx_ring->rx_buf_len = IXGBE_RXBUFFER_2K;
 #endif
@@ -2859,7 +2879,7 @@ static int ixgbe_run_loopback_test(struct ixgbe_adapter *adapter)
 
 static int ixgbe_loopback_test(struct ixgbe_adapter *adapter, u64 *data)
 {
-	*data = ixgbe_setup_desc_rings(adapter);
+	*data = ixgbe_setup_desc_rings(adapter, 0);
 	if (*data)
 		goto out;
 	*data = ixgbe_setup_loopback_test(adapter);
@@ -2874,6 +2894,307 @@ out:
 	return *data;
 }
 
+#ifdef HAVE_IXGBE_DEBUG_FS
+/**
+ * ixgbe_clean_bench_rings - reclaim completed loopback benchmark frames
+ * @rx_ring: test Rx ring
+ * @tx_ring: test Tx ring
+ * @bytes: incremented by the length of every received frame
+ *
+ * Unlike ixgbe_clean_test_rings the payload is not inspected, the Rx
+ * buffers are handed straight back to hardware.
+ *
+ * Returns the number of frames received
+ **/
+static u16 ixgbe_clean_bench_rings(struct ixgbe_ring *rx_ring,
+				   struct ixgbe_ring *tx_ring, u64 *bytes)
+{
+	union ixgbe_adv_rx_desc *rx_desc;
+	u16 rx_ntc, tx_ntc, count = 0;
+
+	rx_ntc = rx_ring->next_to_clean;
+	tx_ntc = tx_ring->next_to_clean;
+	rx_desc = IXGBE_RX_DESC(rx_ring, rx_ntc);
+
+	while (tx_ntc != tx_ring->next_to_use) {
+		union ixgbe_adv_tx_desc *tx_desc;
+		struct ixgbe_tx_buffer *tx_buffer;
+
+		tx_desc = IXGBE_TX_DESC(tx_ring, tx_ntc);
+		if (!(tx_desc->wb.status & cpu_to_le32(IXGBE_TXD_STAT_DD)))
+			break;
+
+		tx_buffer = &tx_ring->tx_buffer_info[tx_ntc];
+		dev_kfree_skb_any(tx_buffer->skb);
+		dma_unmap_single(tx_ring->dev,
+				 dma_unmap_addr(tx_buffer, dma),
+				 dma_unmap_len(tx_buffer, len),
+				 DMA_TO_DEVICE);
+		dma_unmap_len_set(tx_buffer, len, 0);
+
+		tx_ntc++;
+		if (tx_ntc == tx_ring->count)
+			tx_ntc = 0;
+	}
+
+	while (rx_desc->wb.upper.length) {
+		*bytes += le16_to_cpu(rx_desc->wb.upper.length);
+		count++;
+
+		rx_ntc++;
+		if (rx_ntc == rx_ring->count)
+			rx_ntc = 0;
+		rx_desc = IXGBE_RX_DESC(rx_ring, rx_ntc);
+	}
+
+	ixgbe_alloc_rx_buffers(rx_ring, count);
+	rx_ring->next_to_clean = rx_ntc;
+	tx_ring->next_to_clean = tx_ntc;
+
+	return count;
+}
+
+/**
+ * ixgbe_run_lb_bench - drive the test rings for the benchmark
+ * @adapter: board private structure
+ * @res: parameters of the run
+ * @qres: results for the queue pair the test rings are set up on
+ *
+ * Keeps the Tx ring full for res->duration_ms and counts what comes back,
+ * then times IXGBE_LB_BENCH_LAT_SAMPLES single frame round trips. Only
+ * the cycles spent posting and cleaning are counted in qres->cycles, the
+ * scheduler breaks in between are left out.
+ **/
+static int ixgbe_run_lb_bench(struct ixgbe_adapter *adapter,
+			      struct ixgbe_lb_bench *res,
+			      struct ixgbe_lb_bench_queue *qres)
+{
+	struct ixgbe_ring *tx_ring = &adapter->test_tx_ring;
+	struct ixgbe_ring *rx_ring = &adapter->test_rx_ring;
+	u32 flags_orig = adapter->flags;
+	unsigned long deadline, last_rx;
+	ktime_t start;
+	u64 lat_sum = 0, bytes = 0;
+	unsigned int samples = 0;
+	struct sk_buff *skb;
+	int err = 0;
+
+	/* DCB can modify the frames on Tx */
+	adapter->flags &= ~IXGBE_FLAG_DCB_ENABLED;
+
+	skb = alloc_skb(res->frame_size, GFP_KERNEL);
+	if (!skb) {
+		err = -ENOMEM;
+		goto out;
+	}
+	ixgbe_create_lbtest_frame(skb, res->frame_size);
+	skb_put(skb, res->frame_size);
+
+	start = ktime_get();
+	last_rx = jiffies;
+	deadline = jiffies + msecs_to_jiffies(res->duration_ms);
+
+	do {
+		cycles_t cycles = get_cycles();
+		u16 done;
+
+		while (ixgbe_desc_unused(tx_ring) > 2 * DESC_NEEDED) {
+			skb_get(skb);
+			if (ixgbe_xmit_frame_ring(skb, adapter, tx_ring) !=
+			    NETDEV_TX_OK) {
+				kfree_skb(skb);
+				break;
+			}
+		}
+
+		done = ixgbe_clean_bench_rings(rx_ring, tx_ring, &bytes);
+		qres->cycles += get_cycles() - cycles;
+		qres->packets += done;
+
+		if (done) {
+			last_rx = jiffies;
+		} else if (time_after(jiffies, last_rx + HZ / 5)) {
+			err = -ETIMEDOUT;
+			break;
+		}
+
+		cond_resched();
+	} while (time_before(jiffies, deadline));
+
+	qres->elapsed_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	qres->bytes = bytes;
+
+	/* let the frames still in flight drain before timing single ones */
+	msleep(20);
+	ixgbe_clean_bench_rings(rx_ring, tx_ring, &bytes);
+
+	qres->lat_min_ns = U32_MAX;
+	while (!err && samples < IXGBE_LB_BENCH_LAT_SAMPLES) {
+		unsigned long timeout = jiffies + msecs_to_jiffies(10) + 1;
+		ktime_t t0 = ktime_get();
+		u32 lat;
+
+		skb_get(skb);
+		if (ixgbe_xmit_frame_ring(skb, adapter, tx_ring) !=
+		    NETDEV_TX_OK) {
+			kfree_skb(skb);
+			err = -EBUSY;
+			break;
+		}
+
+		while (!ixgbe_clean_bench_rings(rx_ring, tx_ring, &bytes)) {
+			if (time_after(jiffies, timeout)) {
+				err = -ETIMEDOUT;
+				break;
+			}
+			cpu_relax();
+		}
+		if (err)
+			break;
+
+		lat = (u32)ktime_to_ns(ktime_sub(ktime_get(), t0));
+		qres->lat_min_ns = min(qres->lat_min_ns, lat);
+		qres->lat_max_ns = max(qres->lat_max_ns, lat);
+		lat_sum += lat;
+		samples++;
+	}
+	if (samples)
+		qres->lat_avg_ns = (u32)div_u64(lat_sum, samples);
+	else
+		qres->lat_min_ns = 0;
+
+	kfree_skb(skb);
+out:
+	adapter->flags = flags_orig;
+
+	return err;
+}
+
+/**
+ * ixgbe_lb_bench_steer - send the looped back frames to one Rx queue
+ * @adapter: board private structure
+ * @etqf: free EtherType filter slot to use
+ *
+ * The test frames carry EtherType 0xFFFF. Without a filter they would all
+ * land on Rx queue 0, so match them and steer them to the test Rx ring.
+ **/
+static void ixgbe_lb_bench_steer(struct ixgbe_adapter *adapter, int etqf)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+
+	IXGBE_WRITE_REG(hw, IXGBE_ETQF(etqf), IXGBE_ETQF_FILTER_EN | 0xFFFF);
+	IXGBE_WRITE_REG(hw, IXGBE_ETQS(etqf), IXGBE_ETQS_QUEUE_EN |
+			(adapter->test_rx_ring.reg_idx <<
+			 IXGBE_ETQS_RX_QUEUE_SHIFT));
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_lb_bench_run - run a MAC loopback throughput benchmark
+ * @adapter: board private structure
+ * @frame_size: frame length in bytes, without CRC
+ * @duration_ms: how long to keep each Tx ring full
+ *
+ * Takes the interface offline the same way the ethtool offline self-test
+ * does and drives every active queue pair in MAC loopback in turn, up to
+ * IXGBE_LB_BENCH_MAX_QUEUES. Without a free EtherType filter to steer
+ * the frames with, as on 82598, only queue pair 0 is run. The outcome is stored
+ * in adapter->lb_bench.  Must be called with rtnl held.
+ *
+ * Returns 0 on success, negative errno on failure
+ **/
+int ixgbe_lb_bench_run(struct ixgbe_adapter *adapter, u32 frame_size,
+		       u32 duration_ms)
+{
+	struct ixgbe_lb_bench *res = &adapter->lb_bench;
+	struct net_device *netdev = adapter->netdev;
+	struct ixgbe_hw *hw = &adapter->hw;
+	unsigned int num_queues, q;
+	bool if_running;
+	int etqf = -1;
+	int err = 0;
+
+	ASSERT_RTNL();
+
+	if (IXGBE_REMOVED(hw->hw_addr))
+		return -ENODEV;
+
+	/* same restriction as the MAC loopback self-test */
+	if (adapter->flags & (IXGBE_FLAG_SRIOV_ENABLED |
+			      IXGBE_FLAG_VMDQ_ENABLED))
+		return -EOPNOTSUPP;
+
+	if (frame_size < IXGBE_LB_BENCH_MIN_FRAME ||
+	    frame_size > IXGBE_LB_BENCH_MAX_FRAME ||
+	    !duration_ms || duration_ms > IXGBE_LB_BENCH_MAX_MSECS)
+		return -EINVAL;
+
+	num_queues = min_t(unsigned int, adapter->num_tx_queues,
+			   adapter->num_rx_queues);
+	num_queues = min_t(unsigned int, num_queues,
+			   IXGBE_LB_BENCH_MAX_QUEUES);
+	if (hw->mac.type != ixgbe_mac_82598EB)
+		etqf = ffz(ixgbe_etype_filter_reserved(adapter));
+	if (etqf < 0 || etqf >= IXGBE_MAX_ETQF_FILTERS) {
+		etqf = -1;
+		num_queues = 1;
+	}
+
+	if (test_and_set_bit(__IXGBE_TESTING, adapter->state))
+		return -EBUSY;
+
+	memset(res, 0, sizeof(*res));
+	res->frame_size = frame_size;
+	res->duration_ms = duration_ms;
+
+	if_running = netif_running(netdev);
+	if (if_running)
+		ixgbe_close(netdev);
+	else
+		ixgbe_reset(adapter);
+
+	for (q = 0; q < num_queues; q++) {
+		if (ixgbe_setup_desc_rings(adapter, q)) {
+			err = -ENOMEM;
+			break;
+		}
+
+		if (ixgbe_setup_loopback_test(adapter)) {
+			ixgbe_free_desc_rings(adapter);
+			err = -EOPNOTSUPP;
+			break;
+		}
+
+		if (etqf >= 0)
+			ixgbe_lb_bench_steer(adapter, etqf);
+
+		err = ixgbe_run_lb_bench(adapter, res, &res->queue[q]);
+
+		if (etqf >= 0) {
+			IXGBE_WRITE_REG(hw, IXGBE_ETQF(etqf), 0);
+			IXGBE_WRITE_REG(hw, IXGBE_ETQS(etqf), 0);
+		}
+		ixgbe_loopback_cleanup(adapter);
+		ixgbe_free_desc_rings(adapter);
+		if (err)
+			break;
+
+		res->num_queues++;
+	}
+
+	ixgbe_reset(adapter);
+	res->status = err;
+
+	clear_bit(__IXGBE_TESTING, adapter->state);
+	if (if_running)
+		ixgbe_open(netdev);
+	else if (hw->mac.ops.disable_tx_laser)
+		hw->mac.ops.disable_tx_laser(hw);
+
+	return err;
+}
+
+#endif /* HAVE_IXGBE_DEBUG_FS */
 #ifndef HAVE_ETHTOOL_GET_SSET_COUNT
 static int ixgbe_diag_test_count(struct net_device __always_unused *netdev)
 {
@@ -3206,8 +3527,7 @@ static bool ixgbe_update_rsc(struct ixgbe_adapter *adapter)
 		return false;
 
 	/* check the feature flag value and enable RSC if necessary */
-	if (adapter->rx_itr_setting == 1 ||
-	    adapter->rx_itr_setting > IXGBE_MIN_RSC_ITR) {
+	if (ixgbe_rsc_itr_ok(adapter)) {
 		if (!(adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED)) {
 			adapter->flags2 |= IXGBE_FLAG2_RSC_ENABLED;
 			e_info(probe, "rx-usecs value high enough "
@@ -3238,6 +3558,10 @@ static int ixgbe_set_coalesce(struct net_device *netdev,
 	u16  tx_itr_prev;
 	bool need_reset = false;
 
+	/* rx-frames is the per queue RSC limit, see --per-queue */
+	if (ec->rx_max_coalesced_frames)
+		return -EOPNOTSUPP;
+
 	if (adapter->q_vector[0]->tx.count && adapter->q_vector[0]->rx.count) {
 		/* reject Tx specific changes in case of mixed RxTx vectors */
 		if (ec->tx_coalesce_usecs)
@@ -3325,6 +3649,81 @@ static int ixgbe_set_coalesce(struct net_device *netdev,
 	return 0;
 }
 
+#ifdef ETHTOOL_PERQUEUE
+/**
+ * ixgbe_get_per_queue_coalesce - report coalescing for one Rx queue
+ * @netdev: network interface device structure
+ * @queue: Rx queue index
+ * @ec: coalesce settings to fill in
+ *
+ * Interrupt moderation is global, so only rx-frames differs between
+ * queues.  It reports the RSC descriptor limit, 0 meaning the limit is
+ * sized from the Rx buffer.
+ **/
+static int ixgbe_get_per_queue_coalesce(struct net_device *netdev, u32 queue,
+					struct ethtool_coalesce *ec)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(netdev);
+
+	if (queue >= adapter->num_rx_queues)
+		return -EINVAL;
+
+#ifdef HAVE_ETHTOOL_COALESCE_EXTACK
+	ixgbe_get_coalesce(netdev, ec, NULL, NULL);
+#else
+	ixgbe_get_coalesce(netdev, ec);
+#endif
+	/* the Tx work limit is not a per queue setting */
+	ec->tx_max_coalesced_frames_irq = 0;
+	ec->rx_max_coalesced_frames = adapter->rsc_maxdesc[queue];
+
+	return 0;
+}
+
+/**
+ * ixgbe_set_per_queue_coalesce - set the RSC limit for one Rx queue
+ * @netdev: network interface device structure
+ * @queue: Rx queue index
+ * @ec: requested coalesce settings
+ *
+ * rx-frames caps the descriptors per RSC aggregation at 1, 4, 8 or 16, or
+ * 0 to size it from the Rx buffer.  A smaller cap closes aggregations
+ * sooner at the cost of more frames for the stack.  The interrupt
+ * settings are global and must be changed without --per-queue.
+ **/
+static int ixgbe_set_per_queue_coalesce(struct net_device *netdev, u32 queue,
+					struct ethtool_coalesce *ec)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(netdev);
+	struct ethtool_coalesce cur = { 0 };
+	u32 maxdesc = ec->rx_max_coalesced_frames;
+	int err;
+
+	err = ixgbe_get_per_queue_coalesce(netdev, queue, &cur);
+	if (err)
+		return err;
+
+	if (ec->rx_coalesce_usecs != cur.rx_coalesce_usecs ||
+	    ec->tx_coalesce_usecs != cur.tx_coalesce_usecs)
+		return -EINVAL;
+
+	if (maxdesc != 0 && maxdesc != 1 && maxdesc != 4 && maxdesc != 8 &&
+	    maxdesc != 16)
+		return -EINVAL;
+
+	if (adapter->rsc_maxdesc[queue] == maxdesc)
+		return 0;
+
+	adapter->rsc_maxdesc[queue] = maxdesc;
+
+	/* RSCCTL is only written while the rings are configured */
+	if (adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED)
+		ixgbe_do_reset(netdev);
+
+	return 0;
+}
+
+#endif /* ETHTOOL_PERQUEUE */
 #ifndef HAVE_NDO_SET_FEATURES
 static u32 ixgbe_get_rx_csum(struct net_device *netdev)
 {
@@ -3515,8 +3914,7 @@ static int ixgbe_set_flags(struct net_device *netdev, u32 data)
 		adapter->flags2 &= ~IXGBE_FLAG2_RSC_ENABLED;
 	} else if ((adapter->flags2 & IXGBE_FLAG2_RSC_CAPABLE) &&
 		   !(adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED)) {
-		if (adapter->rx_itr_setting == 1 ||
-		    adapter->rx_itr_setting > IXGBE_MIN_RSC_ITR) {
+		if (ixgbe_rsc_itr_ok(adapter)) {
 			adapter->flags2 |= IXGBE_FLAG2_RSC_ENABLED;
 			need_reset = true;
 		} else if (changed & ETH_FLAG_LRO) {
@@ -3576,6 +3974,44 @@ static int ixgbe_set_flags(struct net_device *netdev, u32 data)
 #endif /* ETHTOOL_GFLAGS */
 #endif /* HAVE_NDO_SET_FEATURES */
 #ifdef ETHTOOL_GRXRINGS
+/* user-def bit of an ether-proto rule requesting a low latency interrupt */
+#define IXGBE_ETYPE_USER_DEF_LLI	0x1
+
+static int ixgbe_etype_filter_find(struct ixgbe_adapter *adapter, u32 sw_idx)
+{
+	int i;
+
+	for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++)
+		if (adapter->etype_filter[i].used &&
+		    adapter->etype_filter[i].sw_idx == sw_idx)
+			return i;
+
+	return -ENOENT;
+}
+
+static void ixgbe_get_ethtool_etype_entry(struct ixgbe_adapter *adapter,
+					  struct ethtool_rx_flow_spec *fsp,
+					  int idx)
+{
+	struct ixgbe_etype_filter *filter = &adapter->etype_filter[idx];
+
+	fsp->flow_type = ETHER_FLOW;
+	memset(&fsp->h_u, 0, sizeof(fsp->h_u));
+	memset(&fsp->m_u, 0, sizeof(fsp->m_u));
+	memset(&fsp->h_ext, 0, sizeof(fsp->h_ext));
+	memset(&fsp->m_ext, 0, sizeof(fsp->m_ext));
+	fsp->h_u.ether_spec.h_proto = htons(filter->etype);
+	fsp->m_u.ether_spec.h_proto = htons(0xffff);
+
+	if (filter->lli) {
+		fsp->flow_type |= FLOW_EXT;
+		fsp->h_ext.data[1] = htonl(IXGBE_ETYPE_USER_DEF_LLI);
+		fsp->m_ext.data[1] = htonl(IXGBE_ETYPE_USER_DEF_LLI);
+	}
+
+	fsp->ring_cookie = filter->ring;
+}
+
 static int ixgbe_get_ethtool_fdir_entry(struct ixgbe_adapter *adapter,
 					struct ethtool_rxnfc *cmd)
 {
@@ -3584,10 +4020,17 @@ static int ixgbe_get_ethtool_fdir_entry(struct ixgbe_adapter *adapter,
 		(struct ethtool_rx_flow_spec *)&cmd->fs;
 	struct hlist_node *node2;
 	struct ixgbe_fdir_filter *rule = NULL;
+	int idx;
 
 	/* report total rule count */
 	cmd->data = (1024 << adapter->fdir_pballoc) - 2;
 
+	idx = ixgbe_etype_filter_find(adapter, fsp->location);
+	if (idx >= 0) {
+		ixgbe_get_ethtool_etype_entry(adapter, fsp, idx);
+		return 0;
+	}
+
 	hlist_for_each_entry_safe(rule, node2,
 				  &adapter->fdir_filter_list, fdir_node) {
 		if (fsp->location <= rule->sw_idx)
@@ -3670,6 +4113,7 @@ static int ixgbe_get_ethtool_fdir_all(struct ixgbe_adapter *adapter,
 	struct hlist_node *node2;
 	struct ixgbe_fdir_filter *rule;
 	int cnt = 0;
+	int i;
 
 	/* report total rule count */
 	cmd->data = (1024 << adapter->fdir_pballoc) - 2;
@@ -3682,6 +4126,15 @@ static int ixgbe_get_ethtool_fdir_all(struct ixgbe_adapter *adapter,
 		cnt++;
 	}
 
+	for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++) {
+		if (!adapter->etype_filter[i].used)
+			continue;
+		if (cnt == cmd->rule_cnt)
+			return -EMSGSIZE;
+		rule_locs[cnt] = adapter->etype_filter[i].sw_idx;
+		cnt++;
+	}
+
 	cmd->rule_cnt = cnt;
 
 	return 0;
@@ -3745,7 +4198,8 @@ static int ixgbe_get_rxnfc(struct net_device *dev, struct ethtool_rxnfc *cmd,
 		ret = 0;
 		break;
 	case ETHTOOL_GRXCLSRLCNT:
-		cmd->rule_cnt = adapter->fdir_filter_count;
+		cmd->rule_cnt = adapter->fdir_filter_count +
+				adapter->etype_filter_count;
 		ret = 0;
 		break;
 	case ETHTOOL_GRXCLSRULE:
@@ -3940,6 +4394,11 @@ static int ixgbe_add_ethtool_fdir_entry(struct ixgbe_adapter *adapter,
 		return -EINVAL;
 	}
 
+	if (ixgbe_etype_filter_find(adapter, fsp->location) >= 0) {
+		e_err(drv, "Location is in use by an EtherType filter\n");
+		return -EBUSY;
+	}
+
 	input = kzalloc(sizeof(*input), GFP_ATOMIC);
 	if (!input)
 		return -ENOMEM;
@@ -4067,15 +4526,151 @@ err_out:
 	return -EINVAL;
 }
 
+/**
+ * ixgbe_add_ethtool_etype_entry - add an ether-proto rule to a free ETQF slot
+ * @adapter: board private structure
+ * @cmd: ethtool rxnfc command
+ *
+ * Matching frames are steered to the rule's Rx ring. Setting bit 0 of
+ * user-def additionally raises a low latency interrupt for them. Unlike
+ * perfect filters this needs no Flow Director mode and no packet buffer.
+ **/
+static int ixgbe_add_ethtool_etype_entry(struct ixgbe_adapter *adapter,
+					 struct ethtool_rxnfc *cmd)
+{
+	struct ethtool_rx_flow_spec *fsp =
+		(struct ethtool_rx_flow_spec *)&cmd->fs;
+	u8 reserved = ixgbe_etype_filter_reserved(adapter);
+	struct ixgbe_etype_filter *filter;
+	struct ixgbe_fdir_filter *rule;
+	struct hlist_node *node2;
+	bool lli = false;
+	u16 etype;
+	u32 ring;
+	int idx, i;
+
+	if (adapter->hw.mac.type == ixgbe_mac_82598EB)
+		return -EOPNOTSUPP;
+
+	if (fsp->ring_cookie == RX_CLS_FLOW_DISC ||
+	    ethtool_get_flow_spec_ring_vf(fsp->ring_cookie)) {
+		e_err(drv, "EtherType filters can only steer to a PF Rx queue\n");
+		return -EINVAL;
+	}
+
+	ring = ethtool_get_flow_spec_ring(fsp->ring_cookie);
+	if (ring >= adapter->num_rx_queues)
+		return -EINVAL;
+
+	if (fsp->location >= ((1024 << adapter->fdir_pballoc) - 2)) {
+		e_err(drv, "Location out of range\n");
+		return -EINVAL;
+	}
+
+	if (fsp->m_u.ether_spec.h_proto != htons(0xffff) ||
+	    !is_zero_ether_addr(fsp->m_u.ether_spec.h_source) ||
+	    !is_zero_ether_addr(fsp->m_u.ether_spec.h_dest)) {
+		e_err(drv, "EtherType filters only match the full EtherType\n");
+		return -EINVAL;
+	}
+
+	/* IP and VLAN tagged traffic must stay with RSS and the VLAN filters */
+	etype = ntohs(fsp->h_u.ether_spec.h_proto);
+	if (etype == ETH_P_IP || etype == ETH_P_IPV6 ||
+	    etype == ETH_P_8021Q || etype == ETH_P_8021AD) {
+		e_err(drv, "EtherType 0x%04x cannot be filtered\n", etype);
+		return -EINVAL;
+	}
+
+	/* so must the EtherTypes the driver already filters for a feature */
+	if (ixgbe_etype_filter_owned(adapter, etype)) {
+		e_err(drv, "EtherType 0x%04x is filtered by the driver\n", etype);
+		return -EBUSY;
+	}
+
+	if (fsp->flow_type & FLOW_EXT) {
+		u32 user_def = ntohl(fsp->h_ext.data[1] & fsp->m_ext.data[1]);
+
+		if (fsp->m_ext.vlan_tci || fsp->m_ext.vlan_etype ||
+		    (fsp->h_ext.data[0] & fsp->m_ext.data[0]) ||
+		    (user_def & ~IXGBE_ETYPE_USER_DEF_LLI)) {
+			e_err(drv, "EtherType filters only take the LLI user-def bit\n");
+			return -EINVAL;
+		}
+		lli = !!(user_def & IXGBE_ETYPE_USER_DEF_LLI);
+	}
+
+	spin_lock(&adapter->fdir_perfect_lock);
+
+	hlist_for_each_entry_safe(rule, node2,
+				  &adapter->fdir_filter_list, fdir_node) {
+		if (rule->sw_idx == fsp->location) {
+			spin_unlock(&adapter->fdir_perfect_lock);
+			e_err(drv, "Location is in use by a perfect filter\n");
+			return -EBUSY;
+		}
+	}
+
+	/* a rule at an existing location replaces it in place */
+	idx = ixgbe_etype_filter_find(adapter, fsp->location);
+
+	for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++) {
+		if (i != idx && adapter->etype_filter[i].used &&
+		    adapter->etype_filter[i].etype == etype) {
+			spin_unlock(&adapter->fdir_perfect_lock);
+			e_err(drv, "EtherType 0x%04x is already filtered\n",
+			      etype);
+			return -EEXIST;
+		}
+	}
+
+	if (idx < 0) {
+		for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++) {
+			if (!(reserved & BIT(i)) &&
+			    !adapter->etype_filter[i].used)
+				break;
+		}
+		if (i == IXGBE_MAX_ETQF_FILTERS) {
+			spin_unlock(&adapter->fdir_perfect_lock);
+			e_err(drv, "No free EtherType filter\n");
+			return -ENOSPC;
+		}
+		idx = i;
+		adapter->etype_filter_count++;
+	}
+
+	filter = &adapter->etype_filter[idx];
+	filter->sw_idx = fsp->location;
+	filter->etype = etype;
+	filter->ring = ring;
+	filter->lli = lli;
+	filter->used = true;
+	ixgbe_etype_filter_write(adapter, idx);
+
+	spin_unlock(&adapter->fdir_perfect_lock);
+
+	return 0;
+}
+
 static int ixgbe_del_ethtool_fdir_entry(struct ixgbe_adapter *adapter,
 					struct ethtool_rxnfc *cmd)
 {
 	struct ethtool_rx_flow_spec *fsp =
 		(struct ethtool_rx_flow_spec *)&cmd->fs;
-	int err;
+	int err, idx;
 
 	spin_lock(&adapter->fdir_perfect_lock);
-	err = ixgbe_update_ethtool_fdir_entry(adapter, NULL, fsp->location);
+	idx = ixgbe_etype_filter_find(adapter, fsp->location);
+	if (idx >= 0) {
+		memset(&adapter->etype_filter[idx], 0,
+		       sizeof(adapter->etype_filter[idx]));
+		adapter->etype_filter_count--;
+		ixgbe_etype_filter_write(adapter, idx);
+		err = 0;
+	} else {
+		err = ixgbe_update_ethtool_fdir_entry(adapter, NULL,
+						      fsp->location);
+	}
 	spin_unlock(&adapter->fdir_perfect_lock);
 
 	return err;
@@ -4217,7 +4812,10 @@ static int ixgbe_set_rxnfc(struct net_device *dev, struct ethtool_rxnfc *cmd)
 
 	switch (cmd->cmd) {
 	case ETHTOOL_SRXCLSRLINS:
-		ret = ixgbe_add_ethtool_fdir_entry(adapter, cmd);
+		if ((cmd->fs.flow_type & ~FLOW_EXT) == ETHER_FLOW)
+			ret = ixgbe_add_ethtool_etype_entry(adapter, cmd);
+		else
+			ret = ixgbe_add_ethtool_fdir_entry(adapter, cmd);
 		break;
 	case ETHTOOL_SRXCLSRLDEL:
 		ret = ixgbe_del_ethtool_fdir_entry(adapter, cmd);
@@ -4538,7 +5136,7 @@ static int ixgbe_set_channels(struct net_device *dev,
 #endif /* CONFIG_FCOE */
 
 	/* use setup TC to update any traffic class queue mapping */
-	return ixgbe_setup_tc(dev, netdev_get_num_tc(dev));
+	return ixgbe_setup_tc(dev, ixgbe_dcb_tcs(adapter));
 }
 #endif /* ETHTOOL_SCHANNELS */
 
@@ -4547,11 +5145,21 @@ static int ixgbe_get_module_info(struct net_device *dev,
 				       struct ethtool_modinfo *modinfo)
 {
 	struct ixgbe_adapter *adapter = netdev_priv(dev);
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
 	struct ixgbe_hw *hw = &adapter->hw;
 	u32 status;
 	u8 sff8472_rev, addr_mode;
 	bool page_swap = false;
 
+	spin_lock_bh(&mc->lock);
+	if (mc->valid) {
+		modinfo->type = mc->type;
+		modinfo->eeprom_len = mc->len;
+		spin_unlock_bh(&mc->lock);
+		return 0;
+	}
+	spin_unlock_bh(&mc->lock);
+
 	/* Check whether we support SFF-8472 or not */
 	status = hw->phy.ops.read_i2c_eeprom(hw,
 					     IXGBE_SFF_SFF_8472_COMP,
@@ -4589,31 +5197,21 @@ static int ixgbe_get_module_eeprom(struct net_device *dev,
 					 u8 *data)
 {
 	struct ixgbe_adapter *adapter = netdev_priv(dev);
-	struct ixgbe_hw *hw = &adapter->hw;
-	u32 status = IXGBE_ERR_PHY_ADDR_INVALID;
-	u8 databyte = 0xFF;
-	int i = 0;
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
 
 	if (ee->len == 0)
 		return -EINVAL;
 
-	for (i = ee->offset; i < ee->offset + ee->len; i++) {
-		/* I2C reads can take long time */
-		if (test_bit(__IXGBE_IN_SFP_INIT, adapter->state))
-			return -EBUSY;
-
-		if (i < ETH_MODULE_SFF_8079_LEN)
-			status = hw->phy.ops.read_i2c_eeprom(hw, i, &databyte);
-		else
-			status = hw->phy.ops.read_i2c_sff8472(hw, i, &databyte);
-
-		if (status != 0)
-			return -EIO;
-
-		data[i - ee->offset] = databyte;
+	/* serve from the cache filled at module insertion when possible */
+	spin_lock_bh(&mc->lock);
+	if (mc->valid && ee->offset + ee->len <= mc->len) {
+		memcpy(data, mc->data + ee->offset, ee->len);
+		spin_unlock_bh(&mc->lock);
+		return 0;
 	}
+	spin_unlock_bh(&mc->lock);
 
-	return 0;
+	return ixgbe_read_module_eeprom(adapter, ee->offset, ee->len, data);
 }
 #endif /* ETHTOOL_GMODULEINFO */
 
@@ -4913,6 +5511,12 @@ static u32 ixgbe_get_priv_flags(struct net_device *netdev)
 #endif
 	if (adapter->flags2 & IXGBE_FLAG2_AUTO_DISABLE_VF)
 		priv_flags |= IXGBE_PRIV_FLAGS_AUTO_DISABLE_VF;
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+	if (adapter->flags2 & IXGBE_FLAG2_RX_IDLE_SHRINK)
+		priv_flags |= IXGBE_PRIV_FLAGS_RX_IDLE_SHRINK;
+#endif
+	if (adapter->flags2 & IXGBE_FLAG2_RSC_LOW_ITR)
+		priv_flags |= IXGBE_PRIV_FLAGS_RSC_LOW_ITR;
 
 	return priv_flags;
 }
@@ -4970,6 +5574,21 @@ static int ixgbe_set_priv_flags(struct net_device *netdev, u32 priv_flags)
 			return -EOPNOTSUPP;
 		}
 	}
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+
+	/* rings start out full again when the flag changes */
+	flags2 &= ~IXGBE_FLAG2_RX_IDLE_SHRINK;
+	if (priv_flags & IXGBE_PRIV_FLAGS_RX_IDLE_SHRINK)
+		flags2 |= IXGBE_FLAG2_RX_IDLE_SHRINK;
+#endif
+
+	/* keep HW RSC enabled at Rx interrupt intervals below the default */
+	flags2 &= ~IXGBE_FLAG2_RSC_LOW_ITR;
+	if (priv_flags & IXGBE_PRIV_FLAGS_RSC_LOW_ITR) {
+		if (!(adapter->flags2 & IXGBE_FLAG2_RSC_CAPABLE))
+			return -EOPNOTSUPP;
+		flags2 |= IXGBE_FLAG2_RSC_LOW_ITR;
+	}
 
 	if (flags != adapter->flags) {
 		adapter->flags = flags;
@@ -4979,6 +5598,9 @@ static int ixgbe_set_priv_flags(struct net_device *netdev, u32 priv_flags)
 	} else if (flags2 != adapter->flags2) {
 		adapter->flags2 = flags2;
 
+		/* the RSC gate may have moved across rx-usecs */
+		ixgbe_update_rsc(adapter);
+
 		/* reset interface to repopulate queues */
 		if (netif_running(netdev))
 			ixgbe_reinit_locked(adapter);
@@ -5037,8 +5659,13 @@ static struct ethtool_ops ixgbe_ethtool_ops = {
 #endif
 	.get_coalesce		= ixgbe_get_coalesce,
 	.set_coalesce		= ixgbe_set_coalesce,
+#ifdef ETHTOOL_PERQUEUE
+	.get_per_queue_coalesce	= ixgbe_get_per_queue_coalesce,
+	.set_per_queue_coalesce	= ixgbe_set_per_queue_coalesce,
+#endif
 #ifdef ETHTOOL_COALESCE_USECS
-	.supported_coalesce_params = ETHTOOL_COALESCE_USECS,
+	.supported_coalesce_params = ETHTOOL_COALESCE_USECS |
+				     ETHTOOL_COALESCE_RX_MAX_FRAMES,
 #endif
 #ifndef HAVE_NDO_SET_FEATURES
 	.get_rx_csum		= ixgbe_get_rx_csum,
@@ -0,0 +1,1099 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* Copyright (C) 1999 - 2025 Intel Corporation */
+
+#include "ixgbe.h"
+
+#ifdef HAVE_IXGBE_IPSEC
+#include <net/esp.h>
+#include <net/ipv6.h>
+#include <linux/if_bridge.h>
+
+static const char aes_gcm_name[] = "rfc4106(gcm(aes))";
+
+/**
+ * ixgbe_ipsec_set_tx_sa - set the Tx SA registers
+ * @hw: hw specific details
+ * @idx: register index to write
+ * @key: key byte array
+ * @salt: salt bytes
+ **/
+static void ixgbe_ipsec_set_tx_sa(struct ixgbe_hw *hw, u16 idx,
+				  u32 key[], u32 salt)
+{
+	u32 reg;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		IXGBE_WRITE_REG(hw, IXGBE_IPSTXKEY(i),
+				(__force u32)cpu_to_be32(key[3 - i]));
+	IXGBE_WRITE_REG(hw, IXGBE_IPSTXSALT, (__force u32)cpu_to_be32(salt));
+	IXGBE_WRITE_FLUSH(hw);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_IPSTXIDX);
+	reg &= IXGBE_RXTXIDX_IPS_EN;
+	reg |= idx << IXGBE_RXTXIDX_IDX_SHIFT | IXGBE_RXTXIDX_WRITE;
+	IXGBE_WRITE_REG(hw, IXGBE_IPSTXIDX, reg);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_ipsec_set_rx_item - set an Rx table item
+ * @hw: hw specific details
+ * @idx: register index to write
+ * @tbl: table selector
+ *
+ * Trigger the device to store into a particular Rx table the
+ * data that has already been loaded into the input register
+ **/
+static void ixgbe_ipsec_set_rx_item(struct ixgbe_hw *hw, u16 idx, u32 tbl)
+{
+	u32 reg;
+
+	reg = IXGBE_READ_REG(hw, IXGBE_IPSRXIDX);
+	reg &= IXGBE_RXTXIDX_IPS_EN;
+	reg |= tbl | idx << IXGBE_RXTXIDX_IDX_SHIFT | IXGBE_RXTXIDX_WRITE;
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXIDX, reg);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_ipsec_set_rx_sa - set up the register bits to save SA info
+ * @hw: hw specific details
+ * @idx: register index to write
+ * @spi: security parameter index
+ * @key: key byte array
+ * @salt: salt bytes
+ * @mode: rx decrypt control bits
+ * @ip_idx: index into IP table for related IP address
+ **/
+static void ixgbe_ipsec_set_rx_sa(struct ixgbe_hw *hw, u16 idx, __be32 spi,
+				  u32 key[], u32 salt, u32 mode, u32 ip_idx)
+{
+	int i;
+
+	/* store the SPI (in bigendian) and IPidx */
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXSPI,
+			(__force u32)cpu_to_le32((__force u32)spi));
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXIPIDX, ip_idx);
+	IXGBE_WRITE_FLUSH(hw);
+
+	ixgbe_ipsec_set_rx_item(hw, idx, IXGBE_RXIDX_TBL_SPI);
+
+	/* store the key, salt, and mode */
+	for (i = 0; i < 4; i++)
+		IXGBE_WRITE_REG(hw, IXGBE_IPSRXKEY(i),
+				(__force u32)cpu_to_be32(key[3 - i]));
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXSALT, (__force u32)cpu_to_be32(salt));
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXMOD, mode);
+	IXGBE_WRITE_FLUSH(hw);
+
+	ixgbe_ipsec_set_rx_item(hw, idx, IXGBE_RXIDX_TBL_KEY);
+}
+
+/**
+ * ixgbe_ipsec_set_rx_ip - set up the register bits to save SA IP addr info
+ * @hw: hw specific details
+ * @idx: register index to write
+ * @addr: IP address byte array
+ **/
+static void ixgbe_ipsec_set_rx_ip(struct ixgbe_hw *hw, u16 idx, __be32 addr[])
+{
+	int i;
+
+	/* store the ip address */
+	for (i = 0; i < 4; i++)
+		IXGBE_WRITE_REG(hw, IXGBE_IPSRXIPADDR(i),
+				(__force u32)cpu_to_le32((__force u32)addr[i]));
+	IXGBE_WRITE_FLUSH(hw);
+
+	ixgbe_ipsec_set_rx_item(hw, idx, IXGBE_RXIDX_TBL_IP);
+}
+
+/**
+ * ixgbe_ipsec_clear_hw_tables - because some tables don't get cleared on reset
+ * @adapter: board private structure
+ **/
+static void ixgbe_ipsec_clear_hw_tables(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 buf[4] = {0, 0, 0, 0};
+	u16 idx;
+
+	/* disable Rx and Tx SA lookup */
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXIDX, 0);
+	IXGBE_WRITE_REG(hw, IXGBE_IPSTXIDX, 0);
+
+	/* scrub the tables - split the loops for the max of the IP table */
+	for (idx = 0; idx < IXGBE_IPSEC_MAX_RX_IP_COUNT; idx++) {
+		ixgbe_ipsec_set_tx_sa(hw, idx, buf, 0);
+		ixgbe_ipsec_set_rx_sa(hw, idx, 0, buf, 0, 0, 0);
+		ixgbe_ipsec_set_rx_ip(hw, idx, (__be32 *)buf);
+	}
+	for (; idx < IXGBE_IPSEC_MAX_SA_COUNT; idx++) {
+		ixgbe_ipsec_set_tx_sa(hw, idx, buf, 0);
+		ixgbe_ipsec_set_rx_sa(hw, idx, 0, buf, 0, 0, 0);
+	}
+}
+
+/**
+ * ixgbe_ipsec_stop_data - halt the security block data paths
+ * @adapter: board private structure
+ *
+ * Waits for the Tx and Rx security FIFOs to drain. Without link the Tx
+ * FIFO cannot empty on its own, so MAC loopback is briefly forced on to
+ * flush it.
+ **/
+static void ixgbe_ipsec_stop_data(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	bool link = adapter->link_up;
+	u32 t_rdy, r_rdy;
+	u32 limit;
+	u32 reg;
+
+	/* halt data paths */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXCTRL);
+	reg |= IXGBE_SECTXCTRL_TX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECRXCTRL);
+	reg |= IXGBE_SECRXCTRL_RX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, reg);
+
+	/* If both Tx and Rx are ready there are no packets that we need to
+	 * flush so the loopback configuration below is not necessary.
+	 */
+	t_rdy = IXGBE_READ_REG(hw, IXGBE_SECTXSTAT) &
+		IXGBE_SECTXSTAT_SECTX_RDY;
+	r_rdy = IXGBE_READ_REG(hw, IXGBE_SECRXSTAT) &
+		IXGBE_SECRXSTAT_SECRX_RDY;
+	if (t_rdy && r_rdy)
+		return;
+
+	/* If the Tx FIFO doesn't have link, but still has data, we can't
+	 * clear the Tx sec block. Set the MAC loopback before block clear.
+	 */
+	if (!link) {
+		reg = IXGBE_READ_REG(hw, IXGBE_MACC);
+		reg |= IXGBE_MACC_FLU;
+		IXGBE_WRITE_REG(hw, IXGBE_MACC, reg);
+
+		reg = IXGBE_READ_REG(hw, IXGBE_HLREG0);
+		reg |= IXGBE_HLREG0_LPBK;
+		IXGBE_WRITE_REG(hw, IXGBE_HLREG0, reg);
+
+		IXGBE_WRITE_FLUSH(hw);
+		mdelay(3);
+	}
+
+	/* wait for the paths to empty */
+	limit = 20;
+	do {
+		mdelay(10);
+		t_rdy = IXGBE_READ_REG(hw, IXGBE_SECTXSTAT) &
+			IXGBE_SECTXSTAT_SECTX_RDY;
+		r_rdy = IXGBE_READ_REG(hw, IXGBE_SECRXSTAT) &
+			IXGBE_SECRXSTAT_SECRX_RDY;
+	} while (!(t_rdy && r_rdy) && limit--);
+
+	/* undo loopback if we played with it earlier */
+	if (!link) {
+		reg = IXGBE_READ_REG(hw, IXGBE_MACC);
+		reg &= ~IXGBE_MACC_FLU;
+		IXGBE_WRITE_REG(hw, IXGBE_MACC, reg);
+
+		reg = IXGBE_READ_REG(hw, IXGBE_HLREG0);
+		reg &= ~IXGBE_HLREG0_LPBK;
+		IXGBE_WRITE_REG(hw, IXGBE_HLREG0, reg);
+
+		IXGBE_WRITE_FLUSH(hw);
+	}
+}
+
+/**
+ * ixgbe_ipsec_stop_engine - disable the inline IPsec engine
+ * @adapter: board private structure
+ **/
+static void ixgbe_ipsec_stop_engine(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 reg;
+
+	ixgbe_ipsec_stop_data(adapter);
+
+	/* disable Rx and Tx SA lookup */
+	IXGBE_WRITE_REG(hw, IXGBE_IPSTXIDX, 0);
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXIDX, 0);
+
+	/* disable the Rx and Tx engines and full packet store-n-forward */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXCTRL);
+	reg |= IXGBE_SECTXCTRL_SECTX_DIS;
+	reg &= ~IXGBE_SECTXCTRL_STORE_FORWARD;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECRXCTRL);
+	reg |= IXGBE_SECRXCTRL_SECRX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, reg);
+
+	/* restore the "tx security buffer almost full threshold" to 0x250 */
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXBUFFAF, 0x250);
+
+	/* Set minimum IFG between packets back to the default 0x1 */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXMINIFG);
+	reg = (reg & 0xfffffff0) | 0x1;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXMINIFG, reg);
+
+	/* final set for normal (no ipsec offload) processing */
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, IXGBE_SECTXCTRL_SECTX_DIS);
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, IXGBE_SECRXCTRL_SECRX_DIS);
+
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_ipsec_start_engine - enable the inline IPsec engine
+ * @adapter: board private structure
+ *
+ * NOTE: this increases power consumption whether being used or not
+ **/
+static void ixgbe_ipsec_start_engine(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 reg;
+
+	ixgbe_ipsec_stop_data(adapter);
+
+	/* Set minimum IFG between packets to 3 */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXMINIFG);
+	reg = (reg & 0xfffffff0) | 0x3;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXMINIFG, reg);
+
+	/* Set "tx security buffer almost full threshold" to 0x15 so that the
+	 * almost full indication is generated only after buffer contains at
+	 * least an entire jumbo packet.
+	 */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXBUFFAF);
+	reg = (reg & 0xfffffc00) | 0x15;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXBUFFAF, reg);
+
+	/* restart the data paths by clearing the DISABLE bits */
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, 0);
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, IXGBE_SECTXCTRL_STORE_FORWARD);
+
+	/* enable Rx and Tx SA lookup */
+	IXGBE_WRITE_REG(hw, IXGBE_IPSTXIDX, IXGBE_RXTXIDX_IPS_EN);
+	IXGBE_WRITE_REG(hw, IXGBE_IPSRXIDX, IXGBE_RXTXIDX_IPS_EN);
+
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_ipsec_restore - restore the IPsec HW settings after a reset
+ * @adapter: board private structure
+ *
+ * Reload the HW tables from the SW tables after they've been bashed
+ * by a chip reset.
+ **/
+void ixgbe_ipsec_restore(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	int i;
+
+	if (!(adapter->flags2 & IXGBE_FLAG2_IPSEC_ENABLED))
+		return;
+
+	/* clean up and restart the engine */
+	ixgbe_ipsec_stop_engine(adapter);
+	ixgbe_ipsec_clear_hw_tables(adapter);
+	ixgbe_ipsec_start_engine(adapter);
+
+	/* reload the Rx and Tx keys, skipping Rx entries already deleted
+	 * from the stack and only waiting on their final free
+	 */
+	for (i = 0; i < IXGBE_IPSEC_MAX_SA_COUNT; i++) {
+		struct rx_sa *r = &ipsec->rx_tbl[i];
+		struct tx_sa *t = &ipsec->tx_tbl[i];
+
+		if (r->used && (r->mode & IXGBE_RXMOD_VALID))
+			ixgbe_ipsec_set_rx_sa(hw, i, r->xs->id.spi, r->key,
+					      r->salt, r->mode, r->iptbl_ind);
+
+		if (t->used)
+			ixgbe_ipsec_set_tx_sa(hw, i, t->key, t->salt);
+	}
+
+	/* reload the IP addrs */
+	for (i = 0; i < IXGBE_IPSEC_MAX_RX_IP_COUNT; i++) {
+		struct rx_ip_sa *ipsa = &ipsec->ip_tbl[i];
+
+		if (ipsa->used)
+			ixgbe_ipsec_set_rx_ip(hw, i, ipsa->ipaddr);
+	}
+}
+
+/**
+ * ixgbe_ipsec_find_empty_idx - find the first unused security parameter index
+ * @ipsec: pointer to ipsec struct
+ * @rxtable: true if we need to look in the Rx table
+ *
+ * Returns the first unused index in either the Rx or Tx SA table
+ **/
+static int ixgbe_ipsec_find_empty_idx(struct ixgbe_ipsec *ipsec, bool rxtable)
+{
+	u32 i;
+
+	if (rxtable) {
+		if (ipsec->num_rx_sa == IXGBE_IPSEC_MAX_SA_COUNT)
+			return -ENOSPC;
+
+		/* search rx sa table */
+		for (i = 0; i < IXGBE_IPSEC_MAX_SA_COUNT; i++) {
+			if (!ipsec->rx_tbl[i].used)
+				return i;
+		}
+	} else {
+		if (ipsec->num_tx_sa == IXGBE_IPSEC_MAX_SA_COUNT)
+			return -ENOSPC;
+
+		/* search tx sa table */
+		for (i = 0; i < IXGBE_IPSEC_MAX_SA_COUNT; i++) {
+			if (!ipsec->tx_tbl[i].used)
+				return i;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+/**
+ * ixgbe_ipsec_find_rx_state - find the state that matches
+ * @ipsec: pointer to ipsec struct
+ * @daddr: inbound address to match
+ * @proto: protocol to match
+ * @spi: SPI to match
+ * @ip4: true if using an ipv4 address
+ *
+ * Returns a pointer to the matching SA state information
+ **/
+static struct xfrm_state *ixgbe_ipsec_find_rx_state(struct ixgbe_ipsec *ipsec,
+						    __be32 *daddr, u8 proto,
+						    __be32 spi, bool ip4)
+{
+	struct xfrm_state *ret = NULL;
+	struct rx_sa *rsa;
+
+	rcu_read_lock();
+	hash_for_each_possible_rcu(ipsec->rx_sa_list, rsa, hlist,
+				   (__force u32)spi) {
+		if (spi == rsa->xs->id.spi &&
+		    ((ip4 && *daddr == rsa->xs->id.daddr.a4) ||
+		     (!ip4 && !memcmp(daddr, &rsa->xs->id.daddr.a6,
+				      sizeof(rsa->xs->id.daddr.a6)))) &&
+		    proto == rsa->xs->id.proto) {
+			ret = rsa->xs;
+			xfrm_state_hold(ret);
+			break;
+		}
+	}
+	rcu_read_unlock();
+	return ret;
+}
+
+/**
+ * ixgbe_ipsec_parse_proto_keys - find the key and salt based on the protocol
+ * @xs: pointer to xfrm_state struct
+ * @mykey: pointer to key array to populate
+ * @mysalt: pointer to salt value to populate
+ * @extack: extended ACK for error reporting, may be NULL
+ *
+ * This copies the protocol keys and salt to our own data tables.  The
+ * 82599 family only supports the one algorithm.
+ **/
+static int ixgbe_ipsec_parse_proto_keys(struct xfrm_state *xs,
+					u32 *mykey, u32 *mysalt,
+					struct netlink_ext_ack *extack)
+{
+	unsigned char *key_data;
+	int key_len;
+
+	if (!xs->aead) {
+		NL_SET_ERR_MSG_MOD(extack, "Unsupported IPsec algorithm");
+		return -EINVAL;
+	}
+
+	if (xs->aead->alg_icv_len != IXGBE_IPSEC_AUTH_BITS) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "IPsec offload requires 128 bit authentication");
+		return -EINVAL;
+	}
+
+	if (strcmp(xs->aead->alg_name, aes_gcm_name)) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Unsupported IPsec algorithm - please use rfc4106(gcm(aes))");
+		return -EINVAL;
+	}
+
+	key_data = &xs->aead->alg_key[0];
+	key_len = xs->aead->alg_key_len;
+
+	/* The key bytes come down in a bigendian array of bytes, so
+	 * we don't need to do any byteswapping.
+	 * 160 accounts for 16 byte key and 4 byte salt
+	 */
+	if (key_len != 160) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "IPsec hw offload only supports 128 bit keys with a 32 bit salt");
+		return -EINVAL;
+	}
+
+	*mysalt = ((u32 *)key_data)[4];
+	memcpy(mykey, key_data, 16);
+
+	return 0;
+}
+
+/**
+ * ixgbe_ipsec_is_rx - check the offload direction of a state
+ * @xs: pointer to xfrm_state struct
+ **/
+static bool ixgbe_ipsec_is_rx(struct xfrm_state *xs)
+{
+#ifdef HAVE_XFRM_DEV_OFFLOAD_DIR
+	return xs->xso.dir == XFRM_DEV_OFFLOAD_IN;
+#else
+	return !!(xs->xso.flags & XFRM_OFFLOAD_INBOUND);
+#endif /* HAVE_XFRM_DEV_OFFLOAD_DIR */
+}
+
+/**
+ * ixgbe_ipsec_add_rx_ip - reference or claim an Rx IP table entry
+ * @adapter: board private structure
+ * @rsa: Rx SA being added, its ipaddr is used for the lookup
+ *
+ * The HW does not have a 1:1 mapping from keys to IP addrs, so share a
+ * matching IP table entry if one exists, else claim the first free one.
+ **/
+static int ixgbe_ipsec_add_rx_ip(struct ixgbe_adapter *adapter,
+				 struct rx_sa *rsa)
+{
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	int first = -1;
+	int i;
+
+	for (i = 0; i < IXGBE_IPSEC_MAX_RX_IP_COUNT; i++) {
+		struct rx_ip_sa *ipsa = &ipsec->ip_tbl[i];
+
+		if (!ipsa->used) {
+			if (first < 0)
+				first = i;
+			continue;
+		}
+
+		if (!memcmp(ipsa->ipaddr, rsa->ipaddr, sizeof(rsa->ipaddr))) {
+			ipsa->ref_cnt++;
+			rsa->iptbl_ind = i;
+			return 0;
+		}
+	}
+
+	if (first < 0)
+		return -ENOSPC;
+
+	memcpy(ipsec->ip_tbl[first].ipaddr, rsa->ipaddr, sizeof(rsa->ipaddr));
+	ipsec->ip_tbl[first].ref_cnt = 1;
+	ipsec->ip_tbl[first].used = true;
+	rsa->iptbl_ind = first;
+
+	ixgbe_ipsec_set_rx_ip(&adapter->hw, first, rsa->ipaddr);
+
+	return 0;
+}
+
+/**
+ * ixgbe_ipsec_add_sa - program device with a security association
+ * @dev: pointer to device to program
+ * @xs: pointer to transformer state struct
+ * @extack: extended ACK for error reporting, may be NULL
+ **/
+static int ixgbe_ipsec_add_sa(struct net_device *dev, struct xfrm_state *xs,
+			      struct netlink_ext_ack *extack)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(dev);
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	int ret, sa_idx;
+
+	if (xs->id.proto != IPPROTO_ESP) {
+		NL_SET_ERR_MSG_MOD(extack, "Only ESP is supported for IPsec offload");
+		return -EINVAL;
+	}
+
+	if (xs->calg || xs->encap) {
+		NL_SET_ERR_MSG_MOD(extack,
+				   "Compression and UDP encapsulation are not supported for IPsec offload");
+		return -EINVAL;
+	}
+
+	if (xs->props.flags & XFRM_STATE_ESN) {
+		NL_SET_ERR_MSG_MOD(extack, "ESN is not supported for IPsec offload");
+		return -EINVAL;
+	}
+
+#ifdef HAVE_XFRM_DEV_OFFLOAD_DIR
+	if (xs->xso.type != XFRM_DEV_OFFLOAD_CRYPTO) {
+		NL_SET_ERR_MSG_MOD(extack, "Unsupported IPsec offload type");
+		return -EINVAL;
+	}
+
+#endif /* HAVE_XFRM_DEV_OFFLOAD_DIR */
+	/* IPsec and MACsec share the security block */
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED) {
+		NL_SET_ERR_MSG_MOD(extack, "Security block is in use by MACsec offload");
+		return -EBUSY;
+	}
+
+	if (ixgbe_ipsec_is_rx(xs)) {
+		struct rx_sa rsa;
+
+		ret = ixgbe_ipsec_find_empty_idx(ipsec, true);
+		if (ret < 0) {
+			NL_SET_ERR_MSG_MOD(extack, "No space for SA in Rx table");
+			return ret;
+		}
+		sa_idx = ret;
+
+		memset(&rsa, 0, sizeof(rsa));
+		rsa.used = true;
+		rsa.xs = xs;
+		rsa.decrypt = true;
+
+		ret = ixgbe_ipsec_parse_proto_keys(xs, rsa.key, &rsa.salt,
+						   extack);
+		if (ret)
+			return ret;
+
+		if (xs->props.family == AF_INET6)
+			memcpy(rsa.ipaddr, &xs->id.daddr.a6, 16);
+		else
+			memcpy(&rsa.ipaddr[3], &xs->id.daddr.a4, 4);
+
+		ret = ixgbe_ipsec_add_rx_ip(adapter, &rsa);
+		if (ret) {
+			NL_SET_ERR_MSG_MOD(extack, "No space for SA in Rx IP SA table");
+			return ret;
+		}
+
+		rsa.mode = IXGBE_RXMOD_VALID | IXGBE_RXMOD_PROTO_ESP |
+			   IXGBE_RXMOD_DECRYPT;
+		if (xs->props.family == AF_INET6)
+			rsa.mode |= IXGBE_RXMOD_IPV6;
+
+		/* the preparations worked, so save the info */
+		memcpy(&ipsec->rx_tbl[sa_idx], &rsa, sizeof(rsa));
+
+		ixgbe_ipsec_set_rx_sa(hw, sa_idx, xs->id.spi, rsa.key,
+				      rsa.salt, rsa.mode, rsa.iptbl_ind);
+		xs->xso.offload_handle = sa_idx + IXGBE_IPSEC_BASE_RX_INDEX;
+
+		ipsec->num_rx_sa++;
+
+		/* hash the new entry for faster search in Rx path */
+		hash_add_rcu(ipsec->rx_sa_list, &ipsec->rx_tbl[sa_idx].hlist,
+			     (__force u32)xs->id.spi);
+	} else {
+		struct tx_sa tsa;
+
+#ifdef HAVE_BRIDGE_ATTRIBS
+		if (adapter->num_vfs &&
+		    adapter->bridge_mode != BRIDGE_MODE_VEPA) {
+			NL_SET_ERR_MSG_MOD(extack,
+					   "Tx IPsec offload requires VEPA mode while VFs are active");
+			return -EOPNOTSUPP;
+		}
+
+#endif /* HAVE_BRIDGE_ATTRIBS */
+		ret = ixgbe_ipsec_find_empty_idx(ipsec, false);
+		if (ret < 0) {
+			NL_SET_ERR_MSG_MOD(extack, "No space for SA in Tx table");
+			return ret;
+		}
+		sa_idx = ret;
+
+		memset(&tsa, 0, sizeof(tsa));
+		tsa.used = true;
+		tsa.xs = xs;
+		tsa.encrypt = true;
+
+		ret = ixgbe_ipsec_parse_proto_keys(xs, tsa.key, &tsa.salt,
+						   extack);
+		if (ret)
+			return ret;
+
+		/* save the info and write to the HW table */
+		memcpy(&ipsec->tx_tbl[sa_idx], &tsa, sizeof(tsa));
+
+		ixgbe_ipsec_set_tx_sa(hw, sa_idx, tsa.key, tsa.salt);
+		xs->xso.offload_handle = sa_idx + IXGBE_IPSEC_BASE_TX_INDEX;
+
+		ipsec->num_tx_sa++;
+	}
+
+	/* enable the engine if not already warmed up */
+	if (!(adapter->flags2 & IXGBE_FLAG2_IPSEC_ENABLED)) {
+		ixgbe_ipsec_start_engine(adapter);
+		adapter->flags2 |= IXGBE_FLAG2_IPSEC_ENABLED;
+	}
+
+	return 0;
+}
+
+/**
+ * ixgbe_ipsec_del_rx_sa - remove an Rx SA from the HW and the lookup hash
+ * @adapter: board private structure
+ * @rsa: Rx SA being removed
+ * @sa_idx: index of @rsa in the Rx SA table
+ *
+ * The table slot itself stays claimed until the state is freed, since
+ * the Rx path may still be walking the hash under RCU.
+ **/
+static void ixgbe_ipsec_del_rx_sa(struct ixgbe_adapter *adapter,
+				  struct rx_sa *rsa, u16 sa_idx)
+{
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 zerobuf[4] = {0, 0, 0, 0};
+	u8 ipi;
+
+	ixgbe_ipsec_set_rx_sa(hw, sa_idx, 0, zerobuf, 0, 0, 0);
+	hash_del_rcu(&rsa->hlist);
+
+	/* if the IP table entry is referenced by only this SA,
+	 * i.e. ref_cnt is only 1, clear the IP table entry as well
+	 */
+	ipi = rsa->iptbl_ind;
+	if (ipsec->ip_tbl[ipi].ref_cnt > 0) {
+		ipsec->ip_tbl[ipi].ref_cnt--;
+
+		if (!ipsec->ip_tbl[ipi].ref_cnt) {
+			memset(&ipsec->ip_tbl[ipi], 0,
+			       sizeof(struct rx_ip_sa));
+			ixgbe_ipsec_set_rx_ip(hw, ipi, (__be32 *)zerobuf);
+		}
+	}
+
+	rsa->mode = 0;
+}
+
+/**
+ * ixgbe_ipsec_del_sa - clear out this specific SA
+ * @dev: pointer to device owning the SA
+ * @xs: pointer to transformer state struct
+ *
+ * Called in atomic context, so only the HW entries are dropped here.
+ **/
+static void ixgbe_ipsec_del_sa(struct net_device *dev, struct xfrm_state *xs)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(dev);
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 zerobuf[4] = {0, 0, 0, 0};
+	u16 sa_idx;
+
+	if (ixgbe_ipsec_is_rx(xs)) {
+		struct rx_sa *rsa;
+
+		sa_idx = xs->xso.offload_handle - IXGBE_IPSEC_BASE_RX_INDEX;
+		rsa = &ipsec->rx_tbl[sa_idx];
+
+		if (!rsa->used || rsa->xs != xs) {
+			netdev_err(dev, "Invalid Rx SA selected sa_idx=%d offload_handle=%lu\n",
+				   sa_idx, xs->xso.offload_handle);
+			return;
+		}
+
+		if (rsa->mode & IXGBE_RXMOD_VALID)
+			ixgbe_ipsec_del_rx_sa(adapter, rsa, sa_idx);
+	} else {
+		sa_idx = xs->xso.offload_handle - IXGBE_IPSEC_BASE_TX_INDEX;
+
+		if (!ipsec->tx_tbl[sa_idx].used ||
+		    ipsec->tx_tbl[sa_idx].xs != xs) {
+			netdev_err(dev, "Invalid Tx SA selected sa_idx=%d offload_handle=%lu\n",
+				   sa_idx, xs->xso.offload_handle);
+			return;
+		}
+
+		ixgbe_ipsec_set_tx_sa(hw, sa_idx, zerobuf, 0);
+		memset(&ipsec->tx_tbl[sa_idx], 0, sizeof(struct tx_sa));
+		ipsec->num_tx_sa--;
+	}
+}
+
+/**
+ * ixgbe_ipsec_free_sa - release the SW state of an SA
+ * @dev: pointer to device owning the SA
+ * @xs: pointer to transformer state struct
+ *
+ * Runs once no Rx lookup can reference the state any longer, so the Rx
+ * table slot can be recycled. Stops the engine when no SAs remain.
+ **/
+static void ixgbe_ipsec_free_sa(struct net_device *dev, struct xfrm_state *xs)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(dev);
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+
+	if (ixgbe_ipsec_is_rx(xs)) {
+		u16 sa_idx = xs->xso.offload_handle - IXGBE_IPSEC_BASE_RX_INDEX;
+		struct rx_sa *rsa = &ipsec->rx_tbl[sa_idx];
+
+		if (!rsa->used || rsa->xs != xs)
+			return;
+
+		if (rsa->mode & IXGBE_RXMOD_VALID)
+			ixgbe_ipsec_del_rx_sa(adapter, rsa, sa_idx);
+
+		memset(rsa, 0, sizeof(struct rx_sa));
+		ipsec->num_rx_sa--;
+	}
+
+	/* if there are no SAs left, stop the engine to save energy */
+	if (!ipsec->num_rx_sa && !ipsec->num_tx_sa &&
+	    (adapter->flags2 & IXGBE_FLAG2_IPSEC_ENABLED)) {
+		adapter->flags2 &= ~IXGBE_FLAG2_IPSEC_ENABLED;
+		ixgbe_ipsec_stop_engine(adapter);
+	}
+}
+
+/**
+ * ixgbe_ipsec_offload_ok - can this packet use the xfrm hw offload
+ * @skb: current data packet
+ * @xs: pointer to transformer state struct
+ **/
+static bool ixgbe_ipsec_offload_ok(struct sk_buff *skb, struct xfrm_state *xs)
+{
+	/* tunnel mode adds a plain outer header the HW can always parse */
+	if (xs->props.mode == XFRM_MODE_TUNNEL)
+		return true;
+
+	if (xs->props.family == AF_INET) {
+		/* Offload with IPv4 options is not supported yet */
+		if (ip_hdr(skb)->ihl != 5)
+			return false;
+	} else {
+		/* Offload with IPv6 extension headers is not support yet */
+		if (ipv6_ext_hdr(ipv6_hdr(skb)->nexthdr))
+			return false;
+	}
+
+	return true;
+}
+
+#ifdef HAVE_XDO_DEV_STATE_NETDEV
+static int ixgbe_xdo_dev_state_add(struct net_device *dev,
+				   struct xfrm_state *xs,
+				   struct netlink_ext_ack *extack)
+{
+	return ixgbe_ipsec_add_sa(dev, xs, extack);
+}
+
+static void ixgbe_xdo_dev_state_delete(struct net_device *dev,
+				       struct xfrm_state *xs)
+{
+	ixgbe_ipsec_del_sa(dev, xs);
+}
+
+static void ixgbe_xdo_dev_state_free(struct net_device *dev,
+				     struct xfrm_state *xs)
+{
+	ixgbe_ipsec_free_sa(dev, xs);
+}
+#else
+#ifdef HAVE_XDO_DEV_STATE_ADD_EXTACK
+static int ixgbe_xdo_dev_state_add(struct xfrm_state *xs,
+				   struct netlink_ext_ack *extack)
+{
+	return ixgbe_ipsec_add_sa(xs->xso.real_dev, xs, extack);
+}
+#else
+static int ixgbe_xdo_dev_state_add(struct xfrm_state *xs)
+{
+	return ixgbe_ipsec_add_sa(xs->xso.real_dev, xs, NULL);
+}
+#endif /* HAVE_XDO_DEV_STATE_ADD_EXTACK */
+
+static void ixgbe_xdo_dev_state_delete(struct xfrm_state *xs)
+{
+	ixgbe_ipsec_del_sa(xs->xso.real_dev, xs);
+}
+
+static void ixgbe_xdo_dev_state_free(struct xfrm_state *xs)
+{
+	ixgbe_ipsec_free_sa(xs->xso.real_dev, xs);
+}
+#endif /* HAVE_XDO_DEV_STATE_NETDEV */
+
+static const struct xfrmdev_ops ixgbe_xfrmdev_ops = {
+	.xdo_dev_state_add = ixgbe_xdo_dev_state_add,
+	.xdo_dev_state_delete = ixgbe_xdo_dev_state_delete,
+	.xdo_dev_state_free = ixgbe_xdo_dev_state_free,
+	.xdo_dev_offload_ok = ixgbe_ipsec_offload_ok,
+};
+
+/**
+ * ixgbe_ipsec_tx - setup Tx flags for IPsec offload
+ * @tx_ring: outgoing context
+ * @first: current data packet
+ * @itd: ipsec Tx data for later use in building context descriptor
+ *
+ * Returns 1 if the frame can be offloaded, 0 if it must be dropped.
+ **/
+int ixgbe_ipsec_tx(struct ixgbe_ring *tx_ring,
+		   struct ixgbe_tx_buffer *first,
+		   struct ixgbe_ipsec_tx_data *itd)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(tx_ring->netdev);
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct xfrm_state *xs;
+	struct sec_path *sp;
+	struct tx_sa *tsa;
+
+	sp = skb_sec_path(first->skb);
+	if (unlikely(!sp || !sp->len)) {
+		netdev_err(tx_ring->netdev, "%s: no xfrm state\n", __func__);
+		return 0;
+	}
+
+	xs = xfrm_input_state(first->skb);
+	if (unlikely(!xs)) {
+		netdev_err(tx_ring->netdev, "%s: no xfrm_input_state() xs = %p\n",
+			   __func__, xs);
+		return 0;
+	}
+
+	itd->sa_idx = xs->xso.offload_handle - IXGBE_IPSEC_BASE_TX_INDEX;
+	if (unlikely(itd->sa_idx >= IXGBE_IPSEC_MAX_SA_COUNT)) {
+		netdev_err(tx_ring->netdev, "%s: bad sa_idx=%d handle=%lu\n",
+			   __func__, itd->sa_idx, xs->xso.offload_handle);
+		return 0;
+	}
+
+	tsa = &ipsec->tx_tbl[itd->sa_idx];
+	if (unlikely(!tsa->used)) {
+		netdev_err(tx_ring->netdev, "%s: unused sa_idx=%d\n",
+			   __func__, itd->sa_idx);
+		return 0;
+	}
+
+	first->tx_flags |= IXGBE_TX_FLAGS_IPSEC | IXGBE_TX_FLAGS_CC;
+
+	itd->flags |= IXGBE_ADVTXD_TUCMD_IPSEC_TYPE_ESP |
+		      IXGBE_ADVTXD_TUCMD_L4T_TCP;
+	if (first->protocol == htons(ETH_P_IP))
+		itd->flags |= IXGBE_ADVTXD_TUCMD_IPV4;
+
+	/* The actual trailer length is authlen (16 bytes) plus 2 bytes for
+	 * the proto and the padlen values, plus padlen bytes of padding.
+	 * This ends up not the same as the static value found in
+	 * xs->props.trailer_len (21).
+	 *
+	 * ... but if we're doing GSO, don't bother as the stack doesn't add
+	 * a trailer for those.
+	 */
+	if (!skb_is_gso(first->skb)) {
+		const int authlen = IXGBE_IPSEC_AUTH_BITS / 8;
+		struct sk_buff *skb = first->skb;
+		u8 padlen;
+		int ret;
+
+		ret = skb_copy_bits(skb, skb->len - (authlen + 2),
+				    &padlen, 1);
+		if (unlikely(ret))
+			return 0;
+		itd->trailer_len = authlen + 2 + padlen;
+	}
+
+	if (tsa->encrypt)
+		itd->flags |= IXGBE_ADVTXD_TUCMD_IPSEC_ENCRYPT_EN;
+
+	adapter->tx_ipsec++;
+
+	return 1;
+}
+
+/**
+ * ixgbe_ipsec_rx - decode ipsec bits from Rx descriptor
+ * @rx_ring: receiving ring
+ * @rx_desc: receive data descriptor
+ * @skb: current data packet
+ *
+ * Determine if there was an ipsec encapsulation noticed, and if so set up
+ * the resulting status for later in the receive stack.
+ **/
+void ixgbe_ipsec_rx(struct ixgbe_ring *rx_ring,
+		    union ixgbe_adv_rx_desc *rx_desc,
+		    struct sk_buff *skb)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(rx_ring->netdev);
+	__le16 pkt_info = rx_desc->wb.lower.lo_dword.hs_rss.pkt_info;
+	__le16 ipv4_pkt_types = cpu_to_le16(IXGBE_RXDADV_PKTTYPE_IPV4 |
+					     IXGBE_RXDADV_PKTTYPE_IPV4_EX);
+	__le16 ipv6_pkt_types = cpu_to_le16(IXGBE_RXDADV_PKTTYPE_IPV6 |
+					     IXGBE_RXDADV_PKTTYPE_IPV6_EX);
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+	struct xfrm_offload *xo = NULL;
+	struct xfrm_state *xs = NULL;
+	struct ipv6hdr *ip6 = NULL;
+	struct iphdr *ip4 = NULL;
+	struct sec_path *sp;
+	void *daddr;
+	__be32 spi;
+	u8 *c_hdr;
+	u32 err;
+
+	/* Find the ip and crypto headers in the data. We can assume no vlan
+	 * header in the way, b/c the hw won't recognize the IPsec packet and
+	 * anyway the currently vlan device doesn't support xfrm offload.
+	 */
+	if (pkt_info & ipv4_pkt_types) {
+		ip4 = (struct iphdr *)(skb->data + ETH_HLEN);
+		daddr = &ip4->daddr;
+		c_hdr = (u8 *)ip4 + ip4->ihl * 4;
+	} else if (pkt_info & ipv6_pkt_types) {
+		ip6 = (struct ipv6hdr *)(skb->data + ETH_HLEN);
+		daddr = &ip6->daddr;
+		c_hdr = (u8 *)ip6 + sizeof(struct ipv6hdr);
+	} else {
+		return;
+	}
+
+	if (!(pkt_info & cpu_to_le16(IXGBE_RXDADV_PKTTYPE_IPSEC_ESP)))
+		return;
+
+	spi = ((struct ip_esp_hdr *)c_hdr)->spi;
+
+	xs = ixgbe_ipsec_find_rx_state(ipsec, daddr, IPPROTO_ESP, spi, !!ip4);
+	if (unlikely(!xs))
+		return;
+
+	sp = secpath_set(skb);
+	if (unlikely(!sp)) {
+		xfrm_state_put(xs);
+		return;
+	}
+
+	sp->xvec[sp->len++] = xs;
+	sp->olen++;
+	xo = xfrm_offload(skb);
+	xo->flags = CRYPTO_DONE;
+
+	/* let the stack account and drop frames the engine rejected */
+	err = le32_to_cpu(rx_desc->wb.upper.status_error) &
+	      IXGBE_RXDADV_IPSEC_ERROR_BIT_MASK;
+	switch (err) {
+	case 0:
+		xo->status = CRYPTO_SUCCESS;
+		break;
+	case IXGBE_RXDADV_IPSEC_ERROR_AUTH_FAILED:
+		xo->status = CRYPTO_TRANSPORT_ESP_AUTH_FAILED;
+		break;
+	case IXGBE_RXDADV_IPSEC_ERROR_INVALID_LENGTH:
+		xo->status = CRYPTO_INVALID_PACKET_SYNTAX;
+		break;
+	default:
+		xo->status = CRYPTO_INVALID_PROTOCOL;
+		break;
+	}
+
+	adapter->rx_ipsec++;
+}
+
+/**
+ * ixgbe_init_ipsec_offload - initialize security registers for IPSec operation
+ * @adapter: board private structure
+ **/
+void ixgbe_init_ipsec_offload(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	struct ixgbe_ipsec *ipsec;
+	u32 t_dis, r_dis;
+	size_t size;
+
+	switch (hw->mac.type) {
+	case ixgbe_mac_82599EB:
+	case ixgbe_mac_X540:
+	case ixgbe_mac_X550:
+	case ixgbe_mac_X550EM_x:
+	case ixgbe_mac_X550EM_a:
+		break;
+	default:
+		return;
+	}
+
+	/* If there is no support for either Tx or Rx offload
+	 * we should not be advertising support for IPsec.
+	 */
+	t_dis = IXGBE_READ_REG(hw, IXGBE_SECTXSTAT) &
+		IXGBE_SECTXSTAT_SECTX_OFF_DIS;
+	r_dis = IXGBE_READ_REG(hw, IXGBE_SECRXSTAT) &
+		IXGBE_SECRXSTAT_SECRX_OFF_DIS;
+	if (t_dis || r_dis)
+		return;
+
+	ipsec = kzalloc(sizeof(*ipsec), GFP_KERNEL);
+	if (!ipsec)
+		goto err1;
+	hash_init(ipsec->rx_sa_list);
+
+	size = sizeof(struct rx_sa) * IXGBE_IPSEC_MAX_SA_COUNT;
+	ipsec->rx_tbl = kzalloc(size, GFP_KERNEL);
+	if (!ipsec->rx_tbl)
+		goto err2;
+
+	size = sizeof(struct tx_sa) * IXGBE_IPSEC_MAX_SA_COUNT;
+	ipsec->tx_tbl = kzalloc(size, GFP_KERNEL);
+	if (!ipsec->tx_tbl)
+		goto err2;
+
+	size = sizeof(struct rx_ip_sa) * IXGBE_IPSEC_MAX_RX_IP_COUNT;
+	ipsec->ip_tbl = kzalloc(size, GFP_KERNEL);
+	if (!ipsec->ip_tbl)
+		goto err2;
+
+	ipsec->num_rx_sa = 0;
+	ipsec->num_tx_sa = 0;
+
+	adapter->ipsec = ipsec;
+	ixgbe_ipsec_stop_engine(adapter);
+	ixgbe_ipsec_clear_hw_tables(adapter);
+
+	adapter->netdev->xfrmdev_ops = &ixgbe_xfrmdev_ops;
+
+	return;
+
+err2:
+	kfree(ipsec->ip_tbl);
+	kfree(ipsec->rx_tbl);
+	kfree(ipsec->tx_tbl);
+	kfree(ipsec);
+err1:
+	e_dev_err("Unable to allocate memory for SA tables\n");
+}
+
+/**
+ * ixgbe_stop_ipsec_offload - tear down the ipsec offload
+ * @adapter: board private structure
+ **/
+void ixgbe_stop_ipsec_offload(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_ipsec *ipsec = adapter->ipsec;
+
+	adapter->ipsec = NULL;
+	if (ipsec) {
+		kfree(ipsec->ip_tbl);
+		kfree(ipsec->rx_tbl);
+		kfree(ipsec->tx_tbl);
+		kfree(ipsec);
+	}
+}
+#endif /* HAVE_IXGBE_IPSEC */
@@ -0,0 +1,1072 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* Copyright (C) 1999 - 2025 Intel Corporation */
+
+/* KUnit cases for the pure-logic helpers on the Tx/Rx and flow director
+ * paths. Only linked into ixgbe.ko by "make kunit", see src/Makefile.
+ */
+
+#include "ixgbe.h"
+#include "ixgbe_sriov.h"
+
+#include <kunit/test.h>
+#include <linux/kthread.h>
+
+#ifdef HAVE_KUNIT_SUITES_FOR_MODULE
+#error "kunit_test_suites() defines module_init here, needs kernel 6.0+"
+#endif
+
+static int kunit_bench_cpu = -1;
+module_param(kunit_bench_cpu, int, 0444);
+MODULE_PARM_DESC(kunit_bench_cpu, "CPU the KUnit benchmark cases are pinned to, -1 = do not pin");
+
+#define IXGBE_KUNIT_BENCH_ITERS		1000000
+#define IXGBE_KUNIT_RING_COUNT		512
+
+/* keeps the compiler from dropping the benchmarked work */
+static u32 ixgbe_kunit_sink;
+
+/* affinity of the case thread before ixgbe_kunit_bench_start() pinned it */
+static struct cpumask ixgbe_kunit_saved_mask;
+static bool ixgbe_kunit_pinned;
+
+/* flow_vm_vlan: vm_pool 0, TCPv4 flow, VLAN 100 */
+#define IXGBE_KUNIT_ATR_INPUT		0x00110064
+/* 10.0.0.1 -> 192.168.1.1, sport 8080, dport 80 */
+#define IXGBE_KUNIT_ATR_SRC_IP		0x0a000001
+#define IXGBE_KUNIT_ATR_DST_IP		0xc0a80101
+#define IXGBE_KUNIT_ATR_PORTS		0x1f900050
+#define IXGBE_KUNIT_ATR_COMMON		(IXGBE_KUNIT_ATR_SRC_IP ^ \
+					 IXGBE_KUNIT_ATR_DST_IP ^ \
+					 IXGBE_KUNIT_ATR_PORTS)
+
+static void ixgbe_kunit_atr_fill(union ixgbe_atr_input *input)
+{
+	memset(input, 0, sizeof(*input));
+	input->dword_stream[0] = cpu_to_be32(IXGBE_KUNIT_ATR_INPUT);
+	input->formatted.dst_ip[0] = cpu_to_be32(IXGBE_KUNIT_ATR_DST_IP);
+	input->formatted.src_ip[0] = cpu_to_be32(IXGBE_KUNIT_ATR_SRC_IP);
+	input->formatted.src_port = cpu_to_be16(IXGBE_KUNIT_ATR_PORTS >> 16);
+	input->formatted.dst_port = cpu_to_be16(IXGBE_KUNIT_ATR_PORTS & 0xFFFF);
+}
+
+static u32 ixgbe_kunit_sig_hash(u32 input, u32 common)
+{
+	union ixgbe_atr_hash_dword in = { .dword = cpu_to_be32(input) };
+	union ixgbe_atr_hash_dword cm = { .dword = cpu_to_be32(common) };
+
+	return ixgbe_atr_compute_sig_hash_82599(in, cm);
+}
+
+static void ixgbe_kunit_atr_sig_hash(struct kunit *test)
+{
+	const u32 mask = IXGBE_ATR_HASH_MASK | (IXGBE_ATR_HASH_MASK << 16);
+	u32 i;
+
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_sig_hash(0, 0), (u32)0);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_sig_hash(IXGBE_KUNIT_ATR_INPUT,
+						   IXGBE_KUNIT_ATR_SRC_IP),
+			(u32)0x796e6b82);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_sig_hash(0x02060000, 0xcaf805d1),
+			(u32)0x5c667fa4);
+
+	/* bucket and signature halves are both 15 bits wide */
+	for (i = 0; i < 1024; i++) {
+		u32 hash = ixgbe_kunit_sig_hash(i * 0x9e3779b9, ~i);
+
+		KUNIT_EXPECT_EQ(test, hash & ~mask, (u32)0);
+	}
+}
+
+/* the perfect hash stores the bucket in CPU order despite the __be16 type */
+static u32 ixgbe_kunit_bkt_hash(union ixgbe_atr_input *input)
+{
+	return (__force u16)input->formatted.bkt_hash;
+}
+
+static void ixgbe_kunit_atr_perfect_hash(struct kunit *test)
+{
+	union ixgbe_atr_input input, mask;
+	u32 sig;
+
+	/* with a full mask the bucket must match the signature filter's */
+	ixgbe_kunit_atr_fill(&input);
+	memset(&mask, 0xFF, sizeof(mask));
+	ixgbe_atr_compute_perfect_hash_82599(&input, &mask);
+	sig = ixgbe_kunit_sig_hash(IXGBE_KUNIT_ATR_INPUT,
+				   IXGBE_KUNIT_ATR_COMMON);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_bkt_hash(&input),
+			(u32)0x529);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_bkt_hash(&input),
+			sig & 0x1FFF);
+
+	/* masked out fields are cleared and do not feed the hash */
+	ixgbe_kunit_atr_fill(&input);
+	memset(&mask, 0, sizeof(mask));
+	mask.dword_stream[0] = cpu_to_be32(0xFFFFFFFF);
+	ixgbe_atr_compute_perfect_hash_82599(&input, &mask);
+	KUNIT_EXPECT_EQ(test, (u32)be32_to_cpu(input.formatted.src_ip[0]),
+			(u32)0);
+	KUNIT_EXPECT_EQ(test, (u32)be16_to_cpu(input.formatted.dst_port),
+			(u32)0);
+	sig = ixgbe_kunit_sig_hash(IXGBE_KUNIT_ATR_INPUT, 0);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_bkt_hash(&input), sig & 0x1FFF);
+}
+
+static void ixgbe_kunit_dcb_credits_check(struct kunit *test, u8 *bw,
+					  int max_frame_size,
+					  const u16 *refill_exp,
+					  const u16 *max_exp)
+{
+	u16 refill[IXGBE_DCB_MAX_TRAFFIC_CLASS];
+	u16 max[IXGBE_DCB_MAX_TRAFFIC_CLASS];
+	int i;
+
+	KUNIT_ASSERT_EQ(test, ixgbe_dcb_calculate_tc_credits(bw, refill, max,
+							     max_frame_size),
+			(s32)0);
+	for (i = 0; i < IXGBE_DCB_MAX_TRAFFIC_CLASS; i++) {
+		KUNIT_EXPECT_EQ(test, refill[i], refill_exp[i]);
+		KUNIT_EXPECT_EQ(test, max[i], max_exp[i]);
+		KUNIT_EXPECT_LE(test, refill[i],
+				(u16)IXGBE_DCB_MAX_CREDIT_REFILL);
+	}
+}
+
+static void ixgbe_kunit_dcb_credits(struct kunit *test)
+{
+	u8 even[] = { 12, 12, 12, 12, 13, 13, 13, 13 };
+	const u16 even_refill[] = { 24, 24, 24, 24, 26, 26, 26, 26 };
+	const u16 even_max[] = { 491, 491, 491, 491, 532, 532, 532, 532 };
+	u8 one[] = { 100, 0, 0, 0, 0, 0, 0, 0 };
+	const u16 one_refill[] = { 100, 76, 76, 76, 76, 76, 76, 76 };
+	const u16 one_max[] = { 4095, 76, 76, 76, 76, 76, 76, 76 };
+	u8 two[] = { 50, 50, 0, 0, 0, 0, 0, 0 };
+	const u16 two_refill[] = { 50, 50, 12, 12, 12, 12, 12, 12 };
+	const u16 two_max[] = { 2047, 2047, 12, 12, 12, 12, 12, 12 };
+
+	ixgbe_kunit_dcb_credits_check(test, even, ETH_FRAME_LEN + 18,
+				      even_refill, even_max);
+	/* jumbo frames raise the minimum credit of the idle TCs */
+	ixgbe_kunit_dcb_credits_check(test, one, 9728, one_refill, one_max);
+	ixgbe_kunit_dcb_credits_check(test, two, 1536, two_refill, two_max);
+}
+
+static struct ixgbe_ring *ixgbe_kunit_ring(struct kunit *test)
+{
+	struct ixgbe_ring *ring;
+
+	ring = kunit_kzalloc(test, sizeof(*ring), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ring);
+	ring->count = IXGBE_KUNIT_RING_COUNT;
+
+	return ring;
+}
+
+static u16 ixgbe_kunit_unused(struct ixgbe_ring *ring, u16 ntc, u16 ntu)
+{
+	ring->next_to_clean = ntc;
+	ring->next_to_use = ntu;
+
+	return ixgbe_desc_unused(ring);
+}
+
+static void ixgbe_kunit_desc_unused(struct kunit *test)
+{
+	struct ixgbe_ring *ring = ixgbe_kunit_ring(test);
+	const u16 count = IXGBE_KUNIT_RING_COUNT;
+	u16 i;
+
+	/* one descriptor is always held back so tail never meets head */
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, 0, 0), (u16)(count - 1));
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, 0, 10),
+			(u16)(count - 11));
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, 10, 9), (u16)0);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, 5, count - 12), (u16)16);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, count - 1, 0),
+			(u16)(count - 2));
+
+	/* used + unused always accounts for the whole ring less one */
+	for (i = 0; i < count; i++) {
+		u16 ntc = (i * 7) % count;
+		u16 used = (ntc <= i) ? i - ntc : count - ntc + i;
+
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_unused(ring, ntc, i) + used,
+				count - 1);
+	}
+}
+
+static void ixgbe_kunit_txd_use_count(struct kunit *test)
+{
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(0), 0);
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(1), 1);
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(IXGBE_MAX_DATA_PER_TXD), 1);
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(IXGBE_MAX_DATA_PER_TXD + 1), 2);
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(IXGBE_MAX_DATA_PER_TXD * 4), 4);
+	KUNIT_EXPECT_EQ(test, TXD_USE_COUNT(65535), 4);
+
+	/* ixgbe_xmit_frame_ring() stops the queue at count + 3 descriptors;
+	 * a frame whose head and frags each fit one data descriptor must
+	 * never need more than DESC_NEEDED, or the wake threshold is wrong.
+	 */
+	KUNIT_EXPECT_LE(test, (int)(MAX_SKB_FRAGS + 1) + 3, (int)DESC_NEEDED);
+}
+
+static struct kunit_case ixgbe_kunit_cases[] = {
+	KUNIT_CASE(ixgbe_kunit_atr_sig_hash),
+	KUNIT_CASE(ixgbe_kunit_atr_perfect_hash),
+	KUNIT_CASE(ixgbe_kunit_dcb_credits),
+	KUNIT_CASE(ixgbe_kunit_desc_unused),
+	KUNIT_CASE(ixgbe_kunit_txd_use_count),
+	{}
+};
+
+static struct kunit_suite ixgbe_kunit_suite = {
+	.name = "ixgbe",
+	.test_cases = ixgbe_kunit_cases,
+};
+
+/* E610 admin command interface against a fake BAR. A kthread plays the
+ * firmware: it waits for PF_HICR.C, answers through PF_HIDA/PF_HIBA with
+ * what the case scripted and sets PF_HICR.SV.
+ */
+#define IXGBE_KUNIT_BAR_SIZE		0x100000
+#define IXGBE_KUNIT_ACI_BUF_WORD	0x5a5a0000
+#define IXGBE_KUNIT_ACI_LAT_ITERS	64
+
+struct ixgbe_kunit_fw {
+	struct ixgbe_hw hw;
+	u8 *bar;
+	struct task_struct *task;
+	unsigned int latency_us;	/* delay before each reply */
+	unsigned int busy;		/* replies to send EBUSY first */
+	u16 retval;			/* then reply with this */
+	bool set_params;		/* overwrite desc params with below */
+	u8 params[16];
+	const void *buf;		/* indirect reply, else a pattern */
+	u16 buf_len;
+	atomic_t cmds;			/* commands answered */
+};
+
+static void ixgbe_kunit_fw_reply(struct ixgbe_kunit_fw *fw)
+{
+	struct ixgbe_aci_desc desc;
+	u32 *raw = (u32 *)&desc;
+	u16 retval = fw->retval;
+	u32 hicr;
+	int i;
+
+	if (fw->latency_us)
+		usleep_range(fw->latency_us, fw->latency_us + 10);
+
+	for (i = 0; i < IXGBE_ACI_DESC_SIZE_IN_DWORDS; i++)
+		raw[i] = cpu_to_le32(readl(fw->bar + PF_HIDA(i)));
+
+	if (atomic_inc_return(&fw->cmds) <= fw->busy)
+		retval = IXGBE_ACI_RC_EBUSY;
+	desc.retval = cpu_to_le16(retval);
+	if (fw->set_params)
+		memcpy(desc.params.raw, fw->params, sizeof(fw->params));
+
+	if (desc.flags & cpu_to_le16(IXGBE_ACI_FLAG_BUF)) {
+		u16 len = le16_to_cpu(desc.datalen);
+
+		for (i = 0; i < DIV_ROUND_UP(len, 4); i++) {
+			u32 word = IXGBE_KUNIT_ACI_BUF_WORD | i;
+
+			if (fw->buf) {
+				word = 0;
+				memcpy(&word, (const u8 *)fw->buf + i * 4,
+				       min_t(int, 4, fw->buf_len - i * 4));
+				word = le32_to_cpu((__force __le32)word);
+			}
+			writel(word, fw->bar + PF_HIBA(i));
+		}
+	}
+
+	for (i = 0; i < IXGBE_ACI_DESC_SIZE_IN_DWORDS; i++)
+		writel(le32_to_cpu(raw[i]), fw->bar + PF_HIDA(i));
+
+	hicr = readl(fw->bar + PF_HICR);
+	writel((hicr | PF_HICR_SV) & ~PF_HICR_C, fw->bar + PF_HICR);
+}
+
+static int ixgbe_kunit_fw_thread(void *data)
+{
+	struct ixgbe_kunit_fw *fw = data;
+
+	while (!kthread_should_stop()) {
+		u32 hicr = readl(fw->bar + PF_HICR);
+
+		if ((hicr & PF_HICR_C) &&
+		    !(hicr & (PF_HICR_SV | PF_HICR_EV))) {
+			ixgbe_kunit_fw_reply(fw);
+			continue;
+		}
+		usleep_range(20, 50);
+	}
+
+	return 0;
+}
+
+static int ixgbe_kunit_fw_init(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw;
+
+	fw = kunit_kzalloc(test, sizeof(*fw), GFP_KERNEL);
+	if (!fw)
+		return -ENOMEM;
+	test->priv = fw;
+	ixgbe_init_aci(&fw->hw);
+
+	fw->bar = vzalloc(IXGBE_KUNIT_BAR_SIZE);
+	if (!fw->bar)
+		return -ENOMEM;
+
+	fw->hw.hw_addr = (u8 __force __iomem *)fw->bar;
+	fw->hw.mac.type = ixgbe_mac_E610;
+	writel(PF_HICR_EN, fw->bar + PF_HICR);
+
+	return 0;
+}
+
+static void ixgbe_kunit_fw_exit(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+
+	if (!fw)
+		return;
+
+	if (fw->task)
+		kthread_stop(fw->task);
+#ifdef CONFIG_FAULT_INJECTION
+	/* disarm fail_aci_timeout if ixgbe_kunit_aci_timeout() left it set */
+	ixgbe_fault_attr[IXGBE_FAULT_ACI_TIMEOUT].probability = 0;
+	atomic_set(&ixgbe_fault_attr[IXGBE_FAULT_ACI_TIMEOUT].times, 1);
+#endif /* CONFIG_FAULT_INJECTION */
+	ixgbe_shutdown_aci(&fw->hw);
+	vfree(fw->bar);
+}
+
+static struct ixgbe_kunit_fw *ixgbe_kunit_fw_start(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+
+	fw->task = kthread_run(ixgbe_kunit_fw_thread, fw, "ixgbe_kunit_fw");
+	if (IS_ERR(fw->task)) {
+		fw->task = NULL;
+		KUNIT_FAIL(test, "cannot start the firmware thread");
+	}
+
+	return fw;
+}
+
+static s32 ixgbe_kunit_aci_direct(struct ixgbe_hw *hw, u16 opcode)
+{
+	struct ixgbe_aci_desc desc;
+
+	ixgbe_fill_dflt_direct_cmd_desc(&desc, opcode);
+
+	return ixgbe_aci_send_cmd(hw, &desc, NULL, 0);
+}
+
+static void ixgbe_kunit_aci_csr_state(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+	struct ixgbe_hw *hw = &fw->hw;
+	struct ixgbe_aci_desc desc;
+	u8 buf[4];
+
+	/* nothing answers here, every case must fail before PF_HICR.C */
+	writel(0, fw->bar + PF_HICR);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(hw, ixgbe_aci_opc_get_ver),
+			IXGBE_ERR_ACI_DISABLED);
+
+	writel(PF_HICR_EN | PF_HICR_C, fw->bar + PF_HICR);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(hw, ixgbe_aci_opc_get_ver),
+			IXGBE_ERR_ACI_BUSY);
+	KUNIT_EXPECT_EQ(test, hw->aci.last_status, IXGBE_ACI_RC_EBUSY);
+
+	writel(PF_HICR_EN, fw->bar + PF_HICR);
+	ixgbe_fill_dflt_direct_cmd_desc(&desc, ixgbe_aci_opc_list_func_caps);
+	KUNIT_EXPECT_EQ(test, ixgbe_aci_send_cmd(hw, &desc, buf,
+						 IXGBE_ACI_MAX_BUFFER_SIZE + 4),
+			IXGBE_ERR_PARAM);
+	ixgbe_fill_dflt_direct_cmd_desc(&desc, ixgbe_aci_opc_list_func_caps);
+	desc.flags |= cpu_to_le16(IXGBE_ACI_FLAG_BUF);
+	KUNIT_EXPECT_EQ(test, ixgbe_aci_send_cmd(hw, &desc, NULL, sizeof(buf)),
+			IXGBE_ERR_PARAM);
+
+	KUNIT_EXPECT_EQ(test, readl(fw->bar + PF_HICR), (u32)PF_HICR_EN);
+}
+
+static void ixgbe_kunit_aci_get_fw_ver(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+	struct ixgbe_aci_cmd_get_ver ver = {
+		.fw_build = cpu_to_le32(0x12345678),
+		.fw_major = 1,
+		.fw_minor = 30,
+		.fw_patch = 2,
+		.api_major = 1,
+		.api_minor = 7,
+	};
+
+	memcpy(fw->params, &ver, sizeof(ver));
+	fw->set_params = true;
+	ixgbe_kunit_fw_start(test);
+
+	KUNIT_ASSERT_EQ(test, ixgbe_aci_get_fw_ver(&fw->hw), IXGBE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, fw->hw.fw_build, (u32)0x12345678);
+	KUNIT_EXPECT_EQ(test, fw->hw.fw_maj_ver, (u8)1);
+	KUNIT_EXPECT_EQ(test, fw->hw.fw_min_ver, (u8)30);
+	KUNIT_EXPECT_EQ(test, fw->hw.fw_patch, (u8)2);
+	KUNIT_EXPECT_EQ(test, fw->hw.api_maj_ver, (u8)1);
+	KUNIT_EXPECT_EQ(test, fw->hw.api_min_ver, (u8)7);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 1);
+}
+
+static void ixgbe_kunit_aci_indirect(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+	struct ixgbe_aci_desc desc;
+	u32 buf[6];
+	int i;
+
+	ixgbe_kunit_fw_start(test);
+
+	/* odd lengths are read a dword at a time but copied out exactly */
+	memset(buf, 0, sizeof(buf));
+	ixgbe_fill_dflt_direct_cmd_desc(&desc, ixgbe_aci_opc_list_func_caps);
+	KUNIT_ASSERT_EQ(test, ixgbe_aci_send_cmd(&fw->hw, &desc, buf, 18),
+			IXGBE_SUCCESS);
+	for (i = 0; i < 4; i++)
+		KUNIT_EXPECT_EQ(test, le32_to_cpu((__force __le32)buf[i]),
+				(u32)(IXGBE_KUNIT_ACI_BUF_WORD | i));
+	KUNIT_EXPECT_EQ(test, le32_to_cpu((__force __le32)buf[4]),
+			(u32)(IXGBE_KUNIT_ACI_BUF_WORD | 4) & 0xFFFF);
+	KUNIT_EXPECT_EQ(test, buf[5], (u32)0);
+	KUNIT_EXPECT_EQ(test, le16_to_cpu(desc.datalen), (u16)18);
+}
+
+static void ixgbe_kunit_aci_fw_error(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+
+	fw->retval = IXGBE_ACI_RC_EINVAL;
+	ixgbe_kunit_fw_start(test);
+
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+						     ixgbe_aci_opc_get_ver),
+			IXGBE_ERR_ACI_ERROR);
+	KUNIT_EXPECT_EQ(test, fw->hw.aci.last_status, IXGBE_ACI_RC_EINVAL);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 1);
+}
+
+static void ixgbe_kunit_aci_busy_retry(struct kunit *test)
+{
+	struct ixgbe_kunit_fw *fw = test->priv;
+
+	fw->busy = 1;
+	ixgbe_kunit_fw_start(test);
+
+	/* get_link_status is resent after EBUSY, get_ver is not */
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+				ixgbe_aci_opc_get_link_status),
+			IXGBE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 2);
+
+	atomic_set(&fw->cmds, 0);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+						     ixgbe_aci_opc_get_ver),
+			IXGBE_ERR_ACI_ERROR);
+	KUNIT_EXPECT_EQ(test, fw->hw.aci.last_status, IXGBE_ACI_RC_EBUSY);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 1);
+
+	/* every retry busy: the last EBUSY is what the caller sees */
+	atomic_set(&fw->cmds, 0);
+	fw->busy = IXGBE_ACI_SEND_MAX_EXECUTE;
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+				ixgbe_aci_opc_get_link_status),
+			IXGBE_ERR_ACI_ERROR);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds),
+			IXGBE_ACI_SEND_MAX_EXECUTE);
+}
+
+static void ixgbe_kunit_aci_timeout(struct kunit *test)
+{
+#ifdef CONFIG_FAULT_INJECTION
+	struct fault_attr *attr = &ixgbe_fault_attr[IXGBE_FAULT_ACI_TIMEOUT];
+	struct ixgbe_kunit_fw *fw = test->priv;
+
+	ixgbe_kunit_fw_start(test);
+
+	/* a real timeout takes IXGBE_ACI_SYNC_RESPONSE_TIMEOUT ms, so arm
+	 * fail_aci_timeout for the next completed command instead
+	 */
+	attr->interval = 1;
+	atomic_set(&attr->times, 1);
+	attr->probability = 100;
+
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+				ixgbe_aci_opc_get_link_status),
+			IXGBE_ERR_ACI_TIMEOUT);
+	/* timeouts are not retried even for retryable opcodes */
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 1);
+
+	/* the interface is usable again once the injection is spent */
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_aci_direct(&fw->hw,
+				ixgbe_aci_opc_get_link_status),
+			IXGBE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, atomic_read(&fw->cmds), 2);
+#else
+	kunit_skip(test, "needs CONFIG_FAULT_INJECTION for fail_aci_timeout");
+#endif /* CONFIG_FAULT_INJECTION */
+}
+
+static void ixgbe_kunit_aci_link_info(struct kunit *test)
+{
+	struct ixgbe_aci_cmd_get_link_status_data data = {
+		.link_info = IXGBE_ACI_LINK_UP | IXGBE_ACI_MEDIA_AVAILABLE,
+		.an_info = IXGBE_ACI_AN_COMPLETED | IXGBE_ACI_LINK_PAUSE_TX |
+			   IXGBE_ACI_LINK_PAUSE_RX,
+		.max_frame_size = cpu_to_le16(9728),
+		.link_speed = cpu_to_le16(IXGBE_ACI_LINK_SPEED_10GB),
+	};
+	struct ixgbe_aci_cmd_get_link_status resp = {
+		.cmd_flags = IXGBE_ACI_LSE_IS_ENABLED,
+	};
+	struct ixgbe_kunit_fw *fw = test->priv;
+	struct ixgbe_link_status *li = &fw->hw.link.link_info;
+
+	memcpy(fw->params, &resp, sizeof(resp));
+	fw->set_params = true;
+	fw->buf = &data;
+	fw->buf_len = sizeof(data);
+	fw->hw.link.get_link_info = true;
+	ixgbe_kunit_fw_start(test);
+
+	KUNIT_ASSERT_EQ(test, ixgbe_aci_get_link_info(&fw->hw, true, NULL),
+			IXGBE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, li->link_speed, (u16)IXGBE_ACI_LINK_SPEED_10GB);
+	KUNIT_EXPECT_EQ(test, li->link_info,
+			(u8)(IXGBE_ACI_LINK_UP | IXGBE_ACI_MEDIA_AVAILABLE));
+	KUNIT_EXPECT_EQ(test, li->max_frame_size, (u16)9728);
+	KUNIT_EXPECT_TRUE(test, li->lse_ena);
+	KUNIT_EXPECT_EQ(test, fw->hw.fc.current_mode, ixgbe_fc_full);
+	KUNIT_EXPECT_FALSE(test, fw->hw.link.get_link_info);
+}
+
+static void ixgbe_kunit_aci_latency(struct kunit *test)
+{
+	static const unsigned int latency_us[] = { 0, 100, 1000 };
+	struct ixgbe_kunit_fw *fw = test->priv;
+	unsigned int i, n;
+
+	ixgbe_kunit_fw_start(test);
+
+	/* the driver polls PF_HICR with msleep(1), which dominates */
+	for (i = 0; i < ARRAY_SIZE(latency_us); i++) {
+		u64 start, ns;
+
+		fw->latency_us = latency_us[i];
+		start = ktime_get_ns();
+		for (n = 0; n < IXGBE_KUNIT_ACI_LAT_ITERS; n++)
+			KUNIT_ASSERT_EQ(test, ixgbe_aci_get_fw_ver(&fw->hw),
+					IXGBE_SUCCESS);
+		ns = ktime_get_ns() - start;
+
+		kunit_info(test, "bench: name=aci_get_fw_ver fw_latency_us=%u iters=%u ns=%llu ns_per_op=%llu\n",
+			   latency_us[i], IXGBE_KUNIT_ACI_LAT_ITERS, ns,
+			   div_u64(ns, IXGBE_KUNIT_ACI_LAT_ITERS));
+	}
+}
+
+static struct kunit_case ixgbe_kunit_aci_cases[] = {
+	KUNIT_CASE(ixgbe_kunit_aci_csr_state),
+	KUNIT_CASE(ixgbe_kunit_aci_get_fw_ver),
+	KUNIT_CASE(ixgbe_kunit_aci_indirect),
+	KUNIT_CASE(ixgbe_kunit_aci_fw_error),
+	KUNIT_CASE(ixgbe_kunit_aci_busy_retry),
+	KUNIT_CASE(ixgbe_kunit_aci_timeout),
+	KUNIT_CASE(ixgbe_kunit_aci_link_info),
+	KUNIT_CASE(ixgbe_kunit_aci_latency),
+	{}
+};
+
+static struct kunit_suite ixgbe_kunit_aci_suite = {
+	.name = "ixgbe_aci",
+	.init = ixgbe_kunit_fw_init,
+	.exit = ixgbe_kunit_fw_exit,
+	.test_cases = ixgbe_kunit_aci_cases,
+};
+
+/* PF side of the VF mailbox against a fake BAR, with the case acting as
+ * the VFs. Plain memory has no write-1-to-clear, so a PF clear of a
+ * PFMBICR bit leaves exactly that bit set, and the VFACK bit the PF
+ * clears before a reply reads back as the VF's ack. Cases check what the
+ * PF wrote and then zero the interrupt state as hardware would have.
+ */
+#define IXGBE_KUNIT_NUM_VFS		64
+#define IXGBE_KUNIT_MBX_ROUNDS		100
+
+struct ixgbe_kunit_pf {
+	struct ixgbe_adapter *adapter;
+	u8 *bar;
+};
+
+static int ixgbe_kunit_pf_init(struct kunit *test)
+{
+	struct ixgbe_adapter *adapter;
+	struct ixgbe_kunit_pf *pf;
+
+	pf = kunit_kzalloc(test, sizeof(*pf), GFP_KERNEL);
+	if (!pf)
+		return -ENOMEM;
+	test->priv = pf;
+
+	pf->bar = vzalloc(IXGBE_KUNIT_BAR_SIZE);
+	pf->adapter = vzalloc(sizeof(*pf->adapter));
+	if (!pf->bar || !pf->adapter)
+		return -ENOMEM;
+	adapter = pf->adapter;
+
+	adapter->netdev = alloc_etherdev(0);
+	adapter->vfinfo = kunit_kcalloc(test, IXGBE_KUNIT_NUM_VFS,
+					sizeof(*adapter->vfinfo), GFP_KERNEL);
+	if (!adapter->netdev || !adapter->vfinfo)
+		return -ENOMEM;
+
+	adapter->num_vfs = IXGBE_KUNIT_NUM_VFS;
+	adapter->ring_feature[RING_F_VMDQ].mask = IXGBE_82599_VMDQ_2Q_MASK;
+	adapter->hw.back = adapter;
+	adapter->hw.hw_addr = (u8 __force __iomem *)pf->bar;
+	adapter->hw.mac.type = ixgbe_mac_X550;
+	ixgbe_init_mbx_params_pf(&adapter->hw);
+
+	return 0;
+}
+
+static void ixgbe_kunit_pf_exit(struct kunit *test)
+{
+	struct ixgbe_kunit_pf *pf = test->priv;
+
+	if (!pf)
+		return;
+
+	if (pf->adapter && pf->adapter->netdev)
+		free_netdev(pf->adapter->netdev);
+	vfree(pf->adapter);
+	vfree(pf->bar);
+}
+
+static void ixgbe_kunit_vf_post(struct ixgbe_kunit_pf *pf, u16 vf,
+				const u32 *msg, u16 len)
+{
+	u32 reg = IXGBE_PFMBICR(IXGBE_PFMBICR_INDEX(vf));
+	u16 i;
+
+	for (i = 0; i < len; i++)
+		writel(msg[i], pf->bar + IXGBE_PFMBMEM(vf) + i * 4);
+	writel(readl(pf->bar + reg) |
+	       (IXGBE_PFMBICR_VFREQ_VF1 << IXGBE_PFMBICR_SHIFT(vf)),
+	       pf->bar + reg);
+}
+
+static u32 ixgbe_kunit_vf_word(struct ixgbe_kunit_pf *pf, u16 vf, u16 i)
+{
+	return readl(pf->bar + IXGBE_PFMBMEM(vf) + i * 4);
+}
+
+/* what hardware leaves behind once both sides are done with a message */
+static void ixgbe_kunit_vf_settle(struct ixgbe_kunit_pf *pf)
+{
+	int i;
+
+	for (i = 0; i < 4; i++)
+		writel(0, pf->bar + IXGBE_PFMBICR(i));
+	for (i = 0; i < IXGBE_KUNIT_NUM_VFS; i++)
+		writel(0, pf->bar + IXGBE_PFMAILBOX(i));
+}
+
+static void ixgbe_kunit_mbx_read_write(struct kunit *test)
+{
+	static const u16 vfs[] = { 0, 15, 16, 63 };
+	struct ixgbe_kunit_pf *pf = test->priv;
+	struct ixgbe_hw *hw = &pf->adapter->hw;
+	u32 msg[IXGBE_VFMAILBOX_SIZE];
+	u32 buf[IXGBE_VFMAILBOX_SIZE];
+	int i, j;
+
+	/* this also zeroes the stats, so do it for all VFs up front */
+	for (i = 0; i < ARRAY_SIZE(vfs); i++)
+		ixgbe_upgrade_mbx_params_pf(hw, vfs[i]);
+
+	for (i = 0; i < ARRAY_SIZE(vfs); i++) {
+		u16 vf = vfs[i];
+		u32 bit = IXGBE_PFMBICR_VFREQ_VF1 << IXGBE_PFMBICR_SHIFT(vf);
+
+		for (j = 0; j < IXGBE_VFMAILBOX_SIZE; j++)
+			msg[j] = (vf << 16) | j;
+		ixgbe_kunit_vf_post(pf, vf, msg, IXGBE_VFMAILBOX_SIZE);
+		/* a request from the neighbour VF must survive the read */
+		ixgbe_kunit_vf_post(pf, vf ^ 1, msg, 1);
+
+		KUNIT_ASSERT_EQ(test, ixgbe_read_mbx(hw, buf, ARRAY_SIZE(buf),
+						     vf),
+				IXGBE_SUCCESS);
+		for (j = 0; j < IXGBE_VFMAILBOX_SIZE; j++)
+			KUNIT_EXPECT_EQ(test, buf[j], msg[j]);
+		KUNIT_EXPECT_EQ(test, readl(pf->bar +
+				IXGBE_PFMBICR(IXGBE_PFMBICR_INDEX(vf))), bit);
+		KUNIT_EXPECT_TRUE(test, readl(pf->bar + IXGBE_PFMAILBOX(vf)) &
+				  IXGBE_PFMAILBOX_ACK);
+		ixgbe_kunit_vf_settle(pf);
+
+		KUNIT_EXPECT_EQ(test, ixgbe_read_mbx(hw, buf, ARRAY_SIZE(buf),
+						     vf),
+				IXGBE_ERR_MBX_NOMSG);
+
+		/* no CTS in the message, so the PF does not wait for an ack */
+		msg[0] = IXGBE_PF_CONTROL_MSG;
+		KUNIT_ASSERT_EQ(test, ixgbe_write_mbx(hw, msg, 4, vf),
+				IXGBE_SUCCESS);
+		for (j = 0; j < 4; j++)
+			KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf, j),
+					msg[j]);
+		KUNIT_EXPECT_EQ(test, readl(pf->bar + IXGBE_PFMAILBOX(vf)),
+				(u32)IXGBE_PFMAILBOX_STS);
+		ixgbe_kunit_vf_settle(pf);
+
+		KUNIT_EXPECT_EQ(test, ixgbe_write_mbx(hw, msg,
+						      IXGBE_VFMAILBOX_SIZE + 1,
+						      vf),
+				IXGBE_ERR_PARAM);
+	}
+
+	KUNIT_EXPECT_EQ(test, hw->mbx.stats.msgs_rx, (u32)ARRAY_SIZE(vfs));
+	KUNIT_EXPECT_EQ(test, hw->mbx.stats.msgs_tx, (u32)ARRAY_SIZE(vfs));
+}
+
+static void ixgbe_kunit_mbx_lock_busy(struct kunit *test)
+{
+	struct ixgbe_kunit_pf *pf = test->priv;
+	struct ixgbe_hw *hw = &pf->adapter->hw;
+	u32 msg = IXGBE_PF_CONTROL_MSG;
+
+	ixgbe_upgrade_mbx_params_pf(hw, 3);
+	hw->mbx.timeout = 4;
+	hw->mbx.usec_delay = 10;
+
+	/* somebody else holds PFU, the write gives up without touching
+	 * the buffer
+	 */
+	writel(IXGBE_PFMAILBOX_PFU, pf->bar + IXGBE_PFMAILBOX(3));
+	KUNIT_EXPECT_EQ(test, ixgbe_write_mbx(hw, &msg, 1, 3),
+			IXGBE_ERR_TIMEOUT);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, 3, 0), (u32)0);
+	KUNIT_EXPECT_EQ(test, hw->mbx.stats.msgs_tx, (u32)0);
+}
+
+static void ixgbe_kunit_mbx_vf_reset(struct kunit *test)
+{
+	struct ixgbe_kunit_pf *pf = test->priv;
+	struct ixgbe_hw *hw = &pf->adapter->hw;
+	u32 bit = BIT(IXGBE_PFVFLRE_SHIFT(40));
+
+	writel(bit, pf->bar + IXGBE_PFVFLREC(IXGBE_PFVFLRE_INDEX(40)));
+	KUNIT_EXPECT_EQ(test, ixgbe_check_for_rst(hw, 41), IXGBE_ERR_MBX);
+	KUNIT_EXPECT_EQ(test, ixgbe_check_for_rst(hw, 8), IXGBE_ERR_MBX);
+	KUNIT_EXPECT_EQ(test, ixgbe_check_for_rst(hw, 40), IXGBE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, readl(pf->bar +
+			IXGBE_PFVFLREC(IXGBE_PFVFLRE_INDEX(40))), bit);
+	KUNIT_EXPECT_EQ(test, hw->mbx.stats.rsts, (u32)1);
+}
+
+static void ixgbe_kunit_mbx_msg_task(struct kunit *test)
+{
+	struct ixgbe_kunit_pf *pf = test->priv;
+	struct ixgbe_adapter *adapter = pf->adapter;
+	const u32 ok = IXGBE_VT_MSGTYPE_SUCCESS | IXGBE_VT_MSGTYPE_CTS;
+	u32 msg[2];
+	u16 vf;
+
+	for (vf = 0; vf < IXGBE_KUNIT_NUM_VFS; vf++) {
+		adapter->vfinfo[vf].clear_to_send = true;
+		adapter->vfinfo[vf].vf_api = ixgbe_mbox_api_10;
+
+		msg[0] = IXGBE_VF_API_NEGOTIATE;
+		msg[1] = ixgbe_mbox_api_13;
+		ixgbe_kunit_vf_post(pf, vf, msg, 2);
+		ixgbe_msg_task(adapter);
+		ixgbe_kunit_vf_settle(pf);
+		KUNIT_EXPECT_EQ(test, adapter->vfinfo[vf].vf_api,
+				(unsigned int)ixgbe_mbox_api_13);
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf, 0),
+				IXGBE_VF_API_NEGOTIATE | ok);
+
+		msg[0] = IXGBE_VF_GET_QUEUES;
+		ixgbe_kunit_vf_post(pf, vf, msg, 1);
+		ixgbe_msg_task(adapter);
+		ixgbe_kunit_vf_settle(pf);
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf, 0),
+				IXGBE_VF_GET_QUEUES | ok);
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf,
+							  IXGBE_VF_TX_QUEUES),
+				(u32)2);
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf,
+							  IXGBE_VF_RX_QUEUES),
+				(u32)2);
+		KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, vf,
+							  IXGBE_VF_TRANS_VLAN),
+				(u32)0);
+	}
+
+	/* unknown API versions are refused and leave the old one */
+	msg[0] = IXGBE_VF_API_NEGOTIATE;
+	msg[1] = ixgbe_mbox_api_unknown;
+	ixgbe_kunit_vf_post(pf, 5, msg, 2);
+	ixgbe_msg_task(adapter);
+	ixgbe_kunit_vf_settle(pf);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, 5, 0),
+			IXGBE_VF_API_NEGOTIATE | IXGBE_VT_MSGTYPE_FAILURE |
+			IXGBE_VT_MSGTYPE_CTS);
+	KUNIT_EXPECT_EQ(test, adapter->vfinfo[5].vf_api,
+			(unsigned int)ixgbe_mbox_api_13);
+
+	/* nothing but a reset is served before the VF is clear to send,
+	 * the one word NACK leaves the rest of the buffer alone
+	 */
+	adapter->vfinfo[9].clear_to_send = false;
+	msg[0] = IXGBE_VF_GET_QUEUES;
+	msg[1] = 0x5a5a;
+	ixgbe_kunit_vf_post(pf, 9, msg, 2);
+	ixgbe_msg_task(adapter);
+	ixgbe_kunit_vf_settle(pf);
+	KUNIT_EXPECT_TRUE(test, ixgbe_kunit_vf_word(pf, 9, 0) &
+			  IXGBE_VT_MSGTYPE_FAILURE);
+	KUNIT_EXPECT_FALSE(test, ixgbe_kunit_vf_word(pf, 9, 0) &
+			   IXGBE_VT_MSGTYPE_SUCCESS);
+	KUNIT_EXPECT_EQ(test, ixgbe_kunit_vf_word(pf, 9, IXGBE_VF_TX_QUEUES),
+			(u32)0x5a5a);
+}
+
+static void ixgbe_kunit_mbx_service_time(struct kunit *test)
+{
+	struct ixgbe_kunit_pf *pf = test->priv;
+	struct ixgbe_adapter *adapter = pf->adapter;
+	u32 msg = IXGBE_VF_GET_QUEUES;
+	u64 start, idle_ns = 0, busy_ns = 0;
+	unsigned int round;
+	u16 vf;
+
+	for (vf = 0; vf < IXGBE_KUNIT_NUM_VFS; vf++) {
+		adapter->vfinfo[vf].clear_to_send = true;
+		adapter->vfinfo[vf].vf_api = ixgbe_mbox_api_13;
+	}
+
+	/* one GET_QUEUES per VF per round, each served by its own pass */
+	for (round = 0; round < IXGBE_KUNIT_MBX_ROUNDS; round++) {
+		start = ktime_get_ns();
+		ixgbe_msg_task(adapter);
+		idle_ns += ktime_get_ns() - start;
+
+		for (vf = 0; vf < IXGBE_KUNIT_NUM_VFS; vf++) {
+			ixgbe_kunit_vf_post(pf, vf, &msg, 1);
+			start = ktime_get_ns();
+			ixgbe_msg_task(adapter);
+			busy_ns += ktime_get_ns() - start;
+			ixgbe_kunit_vf_settle(pf);
+		}
+		cond_resched();
+	}
+
+	KUNIT_EXPECT_EQ(test, adapter->hw.mbx.stats.msgs_rx,
+			(u32)(IXGBE_KUNIT_MBX_ROUNDS * IXGBE_KUNIT_NUM_VFS));
+	kunit_info(test, "bench: name=mbx_idle_scan vfs=%u iters=%u ns=%llu ns_per_op=%llu\n",
+		   IXGBE_KUNIT_NUM_VFS, IXGBE_KUNIT_MBX_ROUNDS, idle_ns,
+		   div_u64(idle_ns, IXGBE_KUNIT_MBX_ROUNDS));
+	kunit_info(test, "bench: name=mbx_get_queues vfs=%u iters=%u ns=%llu ns_per_op=%llu\n",
+		   IXGBE_KUNIT_NUM_VFS,
+		   IXGBE_KUNIT_MBX_ROUNDS * IXGBE_KUNIT_NUM_VFS, busy_ns,
+		   div_u64(busy_ns,
+			   IXGBE_KUNIT_MBX_ROUNDS * IXGBE_KUNIT_NUM_VFS));
+}
+
+static struct kunit_case ixgbe_kunit_mbx_cases[] = {
+	KUNIT_CASE(ixgbe_kunit_mbx_read_write),
+	KUNIT_CASE(ixgbe_kunit_mbx_lock_busy),
+	KUNIT_CASE(ixgbe_kunit_mbx_vf_reset),
+	KUNIT_CASE(ixgbe_kunit_mbx_msg_task),
+	KUNIT_CASE(ixgbe_kunit_mbx_service_time),
+	{}
+};
+
+static struct kunit_suite ixgbe_kunit_mbx_suite = {
+	.name = "ixgbe_mbx",
+	.init = ixgbe_kunit_pf_init,
+	.exit = ixgbe_kunit_pf_exit,
+	.test_cases = ixgbe_kunit_mbx_cases,
+};
+
+/**
+ * ixgbe_kunit_bench_start - pin the case and start the clock
+ * @test: KUnit test context
+ *
+ * Pins the case thread to kunit_bench_cpu, saving its old affinity for
+ * ixgbe_kunit_bench_end() to put back. Preemption stays off until then
+ * so the timed loop is not migrated or split.
+ */
+static u64 ixgbe_kunit_bench_start(struct kunit *test)
+{
+	if (kunit_bench_cpu >= 0) {
+		if (kunit_bench_cpu >= nr_cpu_ids ||
+		    !cpu_online(kunit_bench_cpu))
+			kunit_skip(test, "kunit_bench_cpu %d is not online",
+				   kunit_bench_cpu);
+		cpumask_copy(&ixgbe_kunit_saved_mask, current->cpus_ptr);
+		ixgbe_kunit_pinned = !set_cpus_allowed_ptr(current,
+						cpumask_of(kunit_bench_cpu));
+	}
+
+	preempt_disable();
+
+	return ktime_get_ns();
+}
+
+/**
+ * ixgbe_kunit_bench_end - stop the clock and log one result line
+ * @test: KUnit test context
+ * @name: benchmark name, stable across driver versions
+ * @start: value returned by ixgbe_kunit_bench_start()
+ * @sink: result of the timed loop, kept live for the compiler
+ *
+ * Restores the affinity ixgbe_kunit_bench_start() replaced. Result lines
+ * are key=value pairs so "make kunit_run" can pull them out of the KTAP
+ * log as is.
+ */
+static void ixgbe_kunit_bench_end(struct kunit *test, const char *name,
+				  u64 start, u32 sink)
+{
+	u64 ns = ktime_get_ns() - start;
+	int cpu = smp_processor_id();
+
+	preempt_enable();
+
+	if (ixgbe_kunit_pinned) {
+		set_cpus_allowed_ptr(current, &ixgbe_kunit_saved_mask);
+		ixgbe_kunit_pinned = false;
+	}
+
+	WRITE_ONCE(ixgbe_kunit_sink, sink);
+	kunit_info(test, "bench: name=%s iters=%u ns=%llu ps_per_op=%llu cpu=%d\n",
+		   name, IXGBE_KUNIT_BENCH_ITERS, ns,
+		   div_u64(ns * 1000, IXGBE_KUNIT_BENCH_ITERS), cpu);
+}
+
+static void ixgbe_kunit_bench_atr_sig_hash(struct kunit *test)
+{
+	union ixgbe_atr_hash_dword in, common;
+	u32 sink = 0;
+	u64 start;
+	u32 i;
+
+	common.dword = cpu_to_be32(IXGBE_KUNIT_ATR_COMMON);
+	start = ixgbe_kunit_bench_start(test);
+	for (i = 0; i < IXGBE_KUNIT_BENCH_ITERS; i++) {
+		in.dword = cpu_to_be32(IXGBE_KUNIT_ATR_INPUT ^ i);
+		sink ^= ixgbe_atr_compute_sig_hash_82599(in, common);
+	}
+	ixgbe_kunit_bench_end(test, "atr_sig_hash", start, sink);
+}
+
+static void ixgbe_kunit_bench_atr_perfect_hash(struct kunit *test)
+{
+	union ixgbe_atr_input input, mask;
+	u32 sink = 0;
+	u64 start;
+	u32 i;
+
+	memset(&mask, 0xFF, sizeof(mask));
+	ixgbe_kunit_atr_fill(&input);
+	start = ixgbe_kunit_bench_start(test);
+	for (i = 0; i < IXGBE_KUNIT_BENCH_ITERS; i++) {
+		input.formatted.src_port = (__force __be16)i;
+		ixgbe_atr_compute_perfect_hash_82599(&input, &mask);
+		sink ^= (__force u16)input.formatted.bkt_hash;
+	}
+	ixgbe_kunit_bench_end(test, "atr_perfect_hash", start, sink);
+}
+
+static void ixgbe_kunit_bench_dcb_credits(struct kunit *test)
+{
+	u8 bw[IXGBE_DCB_MAX_TRAFFIC_CLASS] = { 12, 12, 12, 12, 13, 13, 13, 13 };
+	u16 refill[IXGBE_DCB_MAX_TRAFFIC_CLASS];
+	u16 max[IXGBE_DCB_MAX_TRAFFIC_CLASS];
+	u32 sink = 0;
+	u64 start;
+	u32 i;
+
+	start = ixgbe_kunit_bench_start(test);
+	for (i = 0; i < IXGBE_KUNIT_BENCH_ITERS; i++) {
+		ixgbe_dcb_calculate_tc_credits(bw, refill, max,
+					       ETH_FRAME_LEN + (i & 0x3FFF));
+		sink ^= refill[0] ^ max[7];
+	}
+	ixgbe_kunit_bench_end(test, "dcb_tc_credits", start, sink);
+}
+
+static void ixgbe_kunit_bench_desc_unused(struct kunit *test)
+{
+	struct ixgbe_ring *ring = ixgbe_kunit_ring(test);
+	u32 sink = 0;
+	u64 start;
+	u32 i;
+
+	start = ixgbe_kunit_bench_start(test);
+	for (i = 0; i < IXGBE_KUNIT_BENCH_ITERS; i++) {
+		WRITE_ONCE(ring->next_to_use, i % IXGBE_KUNIT_RING_COUNT);
+		WRITE_ONCE(ring->next_to_clean,
+			   (i * 7) % IXGBE_KUNIT_RING_COUNT);
+		sink += ixgbe_desc_unused(ring);
+	}
+	ixgbe_kunit_bench_end(test, "desc_unused", start, sink);
+}
+
+static void ixgbe_kunit_bench_txd_use_count(struct kunit *test)
+{
+	u32 sink = 0;
+	u64 start;
+	u32 i;
+
+	/* per-frame descriptor count as done in ixgbe_xmit_frame_ring() */
+	start = ixgbe_kunit_bench_start(test);
+	for (i = 0; i < IXGBE_KUNIT_BENCH_ITERS; i++) {
+		unsigned int size = i & 0xFFFF;
+		u16 count;
+		int f;
+
+		OPTIMIZER_HIDE_VAR(size);
+		count = TXD_USE_COUNT(size);
+		for (f = 0; f < MAX_SKB_FRAGS; f++)
+			count += TXD_USE_COUNT(size + f);
+		sink += (count + 3 > DESC_NEEDED);
+	}
+	ixgbe_kunit_bench_end(test, "txd_use_count", start, sink);
+}
+
+static struct kunit_case ixgbe_kunit_bench_cases[] = {
+	KUNIT_CASE(ixgbe_kunit_bench_atr_sig_hash),
+	KUNIT_CASE(ixgbe_kunit_bench_atr_perfect_hash),
+	KUNIT_CASE(ixgbe_kunit_bench_dcb_credits),
+	KUNIT_CASE(ixgbe_kunit_bench_desc_unused),
+	KUNIT_CASE(ixgbe_kunit_bench_txd_use_count),
+	{}
+};
+
+static struct kunit_suite ixgbe_kunit_bench_suite = {
+	.name = "ixgbe_bench",
+	.test_cases = ixgbe_kunit_bench_cases,
+};
+
+kunit_test_suites(&ixgbe_kunit_suite, &ixgbe_kunit_aci_suite,
+		  &ixgbe_kunit_mbx_suite, &ixgbe_kunit_bench_suite);
@@ -683,6 +683,20 @@ static bool ixgbe_set_vmdq_queues(struct ixgbe_adapter *adapter)
 		adapter->num_rx_queues += fcoe_i;
 	}
 #endif /* CONFIG_FCOE */
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+
+	/* With l2-fwd offload on, pools beyond the first can be handed to
+	 * offloaded macvlans.  A single traffic class limits the PF's own
+	 * Tx hashing to pool 0 so every queue can be reported to the stack.
+	 */
+	if (vmdq_i > 1 && adapter->hw.mac.type != ixgbe_mac_82598EB &&
+	    !(adapter->flags & IXGBE_FLAG_SRIOV_ENABLED) &&
+	    (adapter->netdev->features & NETIF_F_HW_L2FW_DOFFLOAD)) {
+		adapter->flags2 |= IXGBE_FLAG2_FWD_POOLS;
+		netdev_set_num_tc(adapter->netdev, 1);
+		netdev_set_tc_queue(adapter->netdev, 0, rss_i, 0);
+	}
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 	return true;
 }
 
@@ -786,6 +800,14 @@ static void ixgbe_set_num_queues(struct ixgbe_adapter *adapter)
 	adapter->num_rx_pools = adapter->num_rx_queues;
 	adapter->num_rx_queues_per_pool = 1;
 
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+	/* drop the pool 0 fence, ixgbe_set_vmdq_queues puts it back */
+	if (adapter->flags2 & IXGBE_FLAG2_FWD_POOLS) {
+		adapter->flags2 &= ~IXGBE_FLAG2_FWD_POOLS;
+		netdev_reset_tc(adapter->netdev);
+	}
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 #ifdef HAVE_TX_MQ
 	if (ixgbe_set_dcb_vmdq_queues(adapter))
 		return;
@@ -0,0 +1,1062 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* Copyright (C) 1999 - 2025 Intel Corporation */
+
+#include "ixgbe.h"
+
+#ifdef HAVE_IXGBE_MACSEC
+
+#define IXGBE_MAX_SECTX_POLL	20
+
+/**
+ * ixgbe_macsec_prepare - check for the validation pass of a two phase op
+ * @ctx: MACsec offload context
+ *
+ * Older kernels call every offload op twice, first only to validate.
+ **/
+static inline bool ixgbe_macsec_prepare(struct macsec_context *ctx)
+{
+#ifdef HAVE_MACSEC_CTX_PREPARE
+	return ctx->prepare;
+#else
+	return false;
+#endif /* HAVE_MACSEC_CTX_PREPARE */
+}
+
+/**
+ * ixgbe_macsec_write_sci - program a secure channel identifier
+ * @hw: pointer to hardware structure
+ * @reg_l: register taking the low four SCI bytes
+ * @reg_h: register taking the high four SCI bytes
+ * @sci: SCI in network order, MAC address followed by port
+ **/
+static void ixgbe_macsec_write_sci(struct ixgbe_hw *hw, u32 reg_l, u32 reg_h,
+				   sci_t sci)
+{
+	u8 *p = (u8 *)&sci;
+
+	IXGBE_WRITE_REG(hw, reg_l, le32_to_cpup((__le32 *)p));
+	IXGBE_WRITE_REG(hw, reg_h, le32_to_cpup((__le32 *)(p + 4)));
+}
+
+/**
+ * ixgbe_macsec_set_tx_sa - program the key and PN of a Tx SA slot
+ * @hw: pointer to hardware structure
+ * @idx: SA slot, 0 or 1
+ * @sa: SA to program
+ **/
+static void ixgbe_macsec_set_tx_sa(struct ixgbe_hw *hw, int idx,
+				   struct ixgbe_macsec_tx_sa *sa)
+{
+	int i;
+
+	IXGBE_WRITE_REG(hw, idx ? IXGBE_LSECTXPN1 : IXGBE_LSECTXPN0,
+			(__force u32)cpu_to_be32(sa->next_pn));
+
+	for (i = 0; i < 4; i++) {
+		u32 key = le32_to_cpup((__le32 *)&sa->key[i * 4]);
+
+		IXGBE_WRITE_REG(hw, idx ? IXGBE_LSECTXKEY1(i) :
+				IXGBE_LSECTXKEY0(i), key);
+	}
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_macsec_set_rx_sa - program an Rx SA slot
+ * @hw: pointer to hardware structure
+ * @idx: SA slot, 0 or 1
+ * @sa: SA to program
+ * @valid: whether the slot should accept frames
+ **/
+static void ixgbe_macsec_set_rx_sa(struct ixgbe_hw *hw, int idx,
+				   struct ixgbe_macsec_rx_sa *sa, bool valid)
+{
+	int i;
+
+	/* clear the valid bit before touching key and PN */
+	IXGBE_WRITE_REG(hw, IXGBE_LSECRXSA(idx), 0);
+	IXGBE_WRITE_FLUSH(hw);
+	if (!valid)
+		return;
+
+	IXGBE_WRITE_REG(hw, IXGBE_LSECRXPN(idx),
+			(__force u32)cpu_to_be32(sa->next_pn));
+
+	for (i = 0; i < 4; i++) {
+		u32 key = le32_to_cpup((__le32 *)&sa->key[i * 4]);
+
+		IXGBE_WRITE_REG(hw, IXGBE_LSECRXKEY(idx, i), key);
+	}
+
+	IXGBE_WRITE_REG(hw, IXGBE_LSECRXSA(idx),
+			(sa->an & IXGBE_LSECRXSA_AN_MASK) | IXGBE_LSECRXSA_SAV);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_macsec_rx_sa_valid - check whether an Rx SA slot may accept frames
+ * @macsec: MACsec offload state
+ * @idx: SA slot
+ **/
+static bool ixgbe_macsec_rx_sa_valid(struct ixgbe_macsec *macsec, int idx)
+{
+	struct ixgbe_macsec_rx_sa *sa = &macsec->rx_sa[idx];
+
+	return macsec->rx_sc_used && macsec->rx_sc_active &&
+	       sa->used && sa->active;
+}
+
+/**
+ * ixgbe_macsec_select_tx_sa - point the Tx SC at the encoding SA
+ * @adapter: board private structure
+ *
+ * Also decides what happens to frames of the SecY: protected when the
+ * encoding SA is offloaded and active, dropped otherwise, or sent in the
+ * clear when the SecY does not protect frames at all.
+ **/
+static void ixgbe_macsec_select_tx_sa(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_secy *secy = macsec->secy;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u8 tx_state = IXGBE_MACSEC_TX_DROP;
+	u32 reg;
+	int i;
+
+	reg = (macsec->tx_sa[0].an << IXGBE_LSECTXSA_AN0_SHIFT) &
+	      IXGBE_LSECTXSA_AN0_MASK;
+	reg |= (macsec->tx_sa[1].an << IXGBE_LSECTXSA_AN1_SHIFT) &
+	       IXGBE_LSECTXSA_AN1_MASK;
+
+	macsec->tx_sel = -1;
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++) {
+		struct ixgbe_macsec_tx_sa *sa = &macsec->tx_sa[i];
+
+		if (sa->used && sa->active &&
+		    sa->an == secy->tx_sc.encoding_sa) {
+			macsec->tx_sel = i;
+			if (i)
+				reg |= IXGBE_LSECTXSA_SELSA;
+			tx_state = IXGBE_MACSEC_TX_PROTECT;
+			break;
+		}
+	}
+
+	if (!secy->protect_frames)
+		tx_state = IXGBE_MACSEC_TX_CLEAR;
+
+	IXGBE_WRITE_REG(hw, IXGBE_LSECTXSA, reg);
+	IXGBE_WRITE_FLUSH(hw);
+
+	WRITE_ONCE(macsec->tx_state, macsec->running ? tx_state :
+		   IXGBE_MACSEC_TX_DROP);
+}
+
+/**
+ * ixgbe_macsec_write_ctrl - apply the SecY policy to the LinkSec block
+ * @adapter: board private structure
+ **/
+static void ixgbe_macsec_write_ctrl(struct ixgbe_adapter *adapter)
+{
+	struct macsec_secy *secy = adapter->macsec->secy;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 reg;
+
+	reg = IXGBE_READ_REG(hw, IXGBE_LSECTXCTRL);
+	reg &= ~(IXGBE_LSECTXCTRL_EN_MASK | IXGBE_LSECTXCTRL_AISCI |
+		 IXGBE_LSECTXCTRL_PNTHRSH_MASK);
+	if (secy->protect_frames)
+		reg |= secy->tx_sc.encrypt ? IXGBE_LSECTXCTRL_AUTH_ENCRYPT :
+					     IXGBE_LSECTXCTRL_AUTH;
+	if (secy->tx_sc.send_sci)
+		reg |= IXGBE_LSECTXCTRL_AISCI;
+	/* PN exhaustion is left to the key agreement, keep the IRQ quiet */
+	reg |= IXGBE_LSECTXCTRL_PNTHRSH_MASK;
+	IXGBE_WRITE_REG(hw, IXGBE_LSECTXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_LSECRXCTRL);
+	reg &= ~(IXGBE_LSECRXCTRL_EN_MASK | IXGBE_LSECRXCTRL_PLSH |
+		 IXGBE_LSECRXCTRL_RP);
+	switch (secy->validate_frames) {
+	case MACSEC_VALIDATE_STRICT:
+		reg |= IXGBE_LSECRXCTRL_STRICT << IXGBE_LSECRXCTRL_EN_SHIFT;
+		break;
+	case MACSEC_VALIDATE_CHECK:
+		reg |= IXGBE_LSECRXCTRL_CHECK << IXGBE_LSECRXCTRL_EN_SHIFT;
+		break;
+	default:
+		reg |= IXGBE_LSECRXCTRL_DISABLE << IXGBE_LSECRXCTRL_EN_SHIFT;
+		break;
+	}
+	if (secy->replay_protect)
+		reg |= IXGBE_LSECRXCTRL_RP;
+	IXGBE_WRITE_REG(hw, IXGBE_LSECRXCTRL, reg);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+/**
+ * ixgbe_macsec_save_pn - snapshot the hardware packet numbers
+ * @adapter: board private structure
+ *
+ * The PN registers do not survive a reset. Keep the highest PN seen so a
+ * reprogrammed Tx SA never reuses one with the same key.
+ **/
+void ixgbe_macsec_save_pn(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 pn;
+	int i;
+
+	if (!macsec || !(adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED))
+		return;
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++) {
+		if (macsec->tx_sa[i].used) {
+			pn = be32_to_cpu((__force __be32)IXGBE_READ_REG(hw,
+					 i ? IXGBE_LSECTXPN1 : IXGBE_LSECTXPN0));
+			macsec->tx_sa[i].next_pn = max(macsec->tx_sa[i].next_pn,
+						       pn);
+		}
+
+		if (ixgbe_macsec_rx_sa_valid(macsec, i)) {
+			pn = be32_to_cpu((__force __be32)IXGBE_READ_REG(hw,
+					 IXGBE_LSECRXPN(i)));
+			macsec->rx_sa[i].next_pn = max(macsec->rx_sa[i].next_pn,
+						       pn);
+		}
+	}
+}
+
+/**
+ * ixgbe_macsec_stop_tx_path - drain the Tx security block
+ * @hw: pointer to hardware structure
+ **/
+static void ixgbe_macsec_stop_tx_path(struct ixgbe_hw *hw)
+{
+	u32 reg;
+	int i;
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXCTRL);
+	reg |= IXGBE_SECTXCTRL_TX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, reg);
+
+	for (i = 0; i < IXGBE_MAX_SECTX_POLL; i++) {
+		if (IXGBE_READ_REG(hw, IXGBE_SECTXSTAT) &
+		    IXGBE_SECTXSTAT_SECTX_RDY)
+			break;
+		usleep_range(1000, 2000);
+	}
+}
+
+/**
+ * ixgbe_macsec_enable - start the LinkSec engine and load the SecY state
+ * @adapter: board private structure
+ **/
+static void ixgbe_macsec_enable(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 reg;
+	int i;
+
+	hw->mac.ops.disable_sec_rx_path(hw);
+	ixgbe_macsec_stop_tx_path(hw);
+
+	/* the ICV is computed over the frame, so CRC must be handled by HW */
+	reg = IXGBE_READ_REG(hw, IXGBE_HLREG0);
+	reg |= IXGBE_HLREG0_TXCRCEN | IXGBE_HLREG0_RXCRCSTRP;
+	IXGBE_WRITE_REG(hw, IXGBE_HLREG0, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXCTRL);
+	reg &= ~(IXGBE_SECTXCTRL_SECTX_DIS | IXGBE_SECTXCTRL_STORE_FORWARD);
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECRXCTRL);
+	reg &= ~IXGBE_SECRXCTRL_SECRX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXMINIFG);
+	reg = (reg & 0xfffffff0) | 0x3;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXMINIFG, reg);
+
+	ixgbe_macsec_write_ctrl(adapter);
+	ixgbe_macsec_write_sci(hw, IXGBE_LSECTXSCL, IXGBE_LSECTXSCH,
+			       macsec->secy->sci);
+	if (macsec->rx_sc_used)
+		ixgbe_macsec_write_sci(hw, IXGBE_LSECRXSCL, IXGBE_LSECRXSCH,
+				       macsec->rx_sci);
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++) {
+		if (macsec->tx_sa[i].used)
+			ixgbe_macsec_set_tx_sa(hw, i, &macsec->tx_sa[i]);
+		ixgbe_macsec_set_rx_sa(hw, i, &macsec->rx_sa[i],
+				       ixgbe_macsec_rx_sa_valid(macsec, i));
+	}
+	ixgbe_macsec_select_tx_sa(adapter);
+
+	hw->mac.ops.enable_sec_rx_path(hw);
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXCTRL);
+	reg &= ~IXGBE_SECTXCTRL_TX_DIS;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, reg);
+	IXGBE_WRITE_FLUSH(hw);
+
+	adapter->flags2 |= IXGBE_FLAG2_MACSEC_ENABLED;
+}
+
+/**
+ * ixgbe_macsec_disable - stop the LinkSec engine
+ * @adapter: board private structure
+ **/
+static void ixgbe_macsec_disable(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 reg;
+	int i;
+
+	if (!(adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED))
+		return;
+
+	WRITE_ONCE(macsec->tx_state, IXGBE_MACSEC_TX_DROP);
+	ixgbe_macsec_save_pn(adapter);
+
+	hw->mac.ops.disable_sec_rx_path(hw);
+	ixgbe_macsec_stop_tx_path(hw);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_LSECTXCTRL);
+	reg &= ~IXGBE_LSECTXCTRL_EN_MASK;
+	IXGBE_WRITE_REG(hw, IXGBE_LSECTXCTRL, reg);
+
+	reg = IXGBE_READ_REG(hw, IXGBE_LSECRXCTRL);
+	reg &= ~IXGBE_LSECRXCTRL_EN_MASK;
+	IXGBE_WRITE_REG(hw, IXGBE_LSECRXCTRL, reg);
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++)
+		IXGBE_WRITE_REG(hw, IXGBE_LSECRXSA(i), 0);
+
+	/* Set minimum IFG between packets back to the default 0x1 */
+	reg = IXGBE_READ_REG(hw, IXGBE_SECTXMINIFG);
+	reg = (reg & 0xfffffff0) | 0x1;
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXMINIFG, reg);
+
+	/* final set for normal (no security offload) processing */
+	IXGBE_WRITE_REG(hw, IXGBE_SECTXCTRL, IXGBE_SECTXCTRL_SECTX_DIS);
+	IXGBE_WRITE_REG(hw, IXGBE_SECRXCTRL, IXGBE_SECRXCTRL_SECRX_DIS);
+	IXGBE_WRITE_FLUSH(hw);
+
+	/* fold in what the counters saw before they stop */
+	ixgbe_macsec_update_stats(adapter);
+	adapter->flags2 &= ~IXGBE_FLAG2_MACSEC_ENABLED;
+}
+
+/**
+ * ixgbe_macsec_restore - reload the LinkSec block after a reset
+ * @adapter: board private structure
+ **/
+void ixgbe_macsec_restore(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (!macsec || !(adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED))
+		return;
+
+	ixgbe_macsec_enable(adapter);
+}
+
+/**
+ * ixgbe_macsec_update_stats - accumulate the LinkSec counters
+ * @adapter: board private structure
+ *
+ * The counters clear on read. Tx has no per-SA counters, so the packets
+ * are credited to whichever SA slot is currently selected.
+ **/
+void ixgbe_macsec_update_stats(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct ixgbe_hw *hw = &adapter->hw;
+	struct macsec_dev_stats *ds;
+	struct macsec_rx_sc_stats *rs;
+	struct macsec_tx_sc_stats *ts;
+	u32 pkte, pktp;
+	int i;
+
+	if (!macsec || !(adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED))
+		return;
+
+	ds = &macsec->dev_stats;
+	ts = &macsec->tx_sc_stats;
+	rs = &macsec->rx_sc_stats;
+
+	spin_lock(&macsec->stats_lock);
+
+	ds->OutPktsUntagged += IXGBE_READ_REG(hw, IXGBE_LSECTXUT);
+	ds->InPktsUntagged += IXGBE_READ_REG(hw, IXGBE_LSECRXUT);
+	ds->InPktsBadTag += IXGBE_READ_REG(hw, IXGBE_LSECRXBAD);
+	ds->InPktsNoSCI += IXGBE_READ_REG(hw, IXGBE_LSECRXNOSCI);
+	ds->InPktsUnknownSCI += IXGBE_READ_REG(hw, IXGBE_LSECRXUNSCI);
+
+	pkte = IXGBE_READ_REG(hw, IXGBE_LSECTXPKTE);
+	pktp = IXGBE_READ_REG(hw, IXGBE_LSECTXPKTP);
+	ts->OutPktsEncrypted += pkte;
+	ts->OutPktsProtected += pktp;
+	ts->OutOctetsEncrypted += IXGBE_READ_REG(hw, IXGBE_LSECTXOCTE);
+	ts->OutOctetsProtected += IXGBE_READ_REG(hw, IXGBE_LSECTXOCTP);
+	if (macsec->tx_sel >= 0) {
+		macsec->tx_sa[macsec->tx_sel].out_pkts_encrypted += pkte;
+		macsec->tx_sa[macsec->tx_sel].out_pkts_protected += pktp;
+	}
+
+	rs->InOctetsDecrypted += IXGBE_READ_REG(hw, IXGBE_LSECRXOCTD);
+	rs->InOctetsValidated += IXGBE_READ_REG(hw, IXGBE_LSECRXOCTV);
+	rs->InPktsUnchecked += IXGBE_READ_REG(hw, IXGBE_LSECRXUNCH);
+	rs->InPktsDelayed += IXGBE_READ_REG(hw, IXGBE_LSECRXDELAY);
+	rs->InPktsLate += IXGBE_READ_REG(hw, IXGBE_LSECRXLATE);
+	rs->InPktsNotUsingSA += IXGBE_READ_REG(hw, IXGBE_LSECRXNUSA);
+	rs->InPktsUnusedSA += IXGBE_READ_REG(hw, IXGBE_LSECRXUNSA);
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++) {
+		struct ixgbe_macsec_rx_sa *sa = &macsec->rx_sa[i];
+		u32 ok = IXGBE_READ_REG(hw, IXGBE_LSECRXOK(i));
+		u32 inv = IXGBE_READ_REG(hw, IXGBE_LSECRXINV(i));
+		u32 nv = IXGBE_READ_REG(hw, IXGBE_LSECRXNV(i));
+
+		sa->in_pkts_ok += ok;
+		sa->in_pkts_invalid += inv;
+		sa->in_pkts_not_valid += nv;
+		rs->InPktsOK += ok;
+		rs->InPktsInvalid += inv;
+		rs->InPktsNotValid += nv;
+	}
+
+	spin_unlock(&macsec->stats_lock);
+}
+
+/**
+ * ixgbe_macsec_rx_drop - apply the SecY validation policy to a frame
+ * @rx_ring: ring the frame was received on
+ * @rx_desc: EOP descriptor of a LinkSec frame
+ *
+ * Frames failing validation are only passed up when the SecY is in
+ * check mode; a strict SecY discards them.
+ **/
+bool ixgbe_macsec_rx_drop(struct ixgbe_ring *rx_ring,
+			  union ixgbe_adv_rx_desc *rx_desc)
+{
+	struct ixgbe_adapter *adapter = rx_ring->q_vector->adapter;
+	struct macsec_secy *secy;
+
+	if (!ixgbe_test_staterr(rx_desc, IXGBE_RXDADV_LNKSEC_ERROR_BIT_MASK))
+		return false;
+
+	if (!adapter->macsec)
+		return true;
+
+	secy = READ_ONCE(adapter->macsec->secy);
+
+	return !secy || secy->validate_frames == MACSEC_VALIDATE_STRICT;
+}
+
+static int ixgbe_macsec_find_tx_sa(struct ixgbe_macsec *macsec, u8 an)
+{
+	int i;
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++)
+		if (macsec->tx_sa[i].used && macsec->tx_sa[i].an == an)
+			return i;
+
+	return -ENOENT;
+}
+
+static int ixgbe_macsec_find_rx_sa(struct ixgbe_macsec *macsec, u8 an)
+{
+	int i;
+
+	for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++)
+		if (macsec->rx_sa[i].used && macsec->rx_sa[i].an == an)
+			return i;
+
+	return -ENOENT;
+}
+
+/**
+ * ixgbe_macsec_check_secy - check a SecY against what the HW can offload
+ * @adapter: board private structure
+ * @secy: SecY being offloaded
+ **/
+static int ixgbe_macsec_check_secy(struct ixgbe_adapter *adapter,
+				   struct macsec_secy *secy)
+{
+	struct net_device *netdev = adapter->netdev;
+
+	if (secy->key_len != IXGBE_MACSEC_KEY_LEN ||
+	    secy->icv_len != MACSEC_DEFAULT_ICV_LEN || secy->xpn) {
+		netdev_err(netdev, "MACsec offload supports GCM-AES-128 with a 16 byte ICV only\n");
+		return -EOPNOTSUPP;
+	}
+
+	if (secy->tx_sc.end_station || secy->tx_sc.scb) {
+		netdev_err(netdev, "MACsec offload does not support ES or SCB\n");
+		return -EOPNOTSUPP;
+	}
+
+	if (secy->replay_protect && secy->replay_window) {
+		netdev_err(netdev, "MACsec offload only supports strict replay protection\n");
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+static int ixgbe_macsec_dev_open(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	/* IPsec and MACsec share the security block */
+	if (adapter->flags2 & IXGBE_FLAG2_IPSEC_ENABLED)
+		return -EBUSY;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	macsec->running = true;
+	ixgbe_macsec_enable(adapter);
+
+	return 0;
+}
+
+static int ixgbe_macsec_dev_stop(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	macsec->running = false;
+	ixgbe_macsec_disable(adapter);
+
+	return 0;
+}
+
+static int ixgbe_macsec_add_secy(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int err;
+
+	if (macsec->secy) {
+		netdev_err(ctx->netdev, "MACsec offload supports a single SecY\n");
+		return -EBUSY;
+	}
+
+	err = ixgbe_macsec_check_secy(adapter, ctx->secy);
+	if (err)
+		return err;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	memset(macsec->tx_sa, 0, sizeof(macsec->tx_sa));
+	memset(macsec->rx_sa, 0, sizeof(macsec->rx_sa));
+	macsec->rx_sc_used = false;
+	macsec->running = false;
+	macsec->tx_sel = -1;
+
+	spin_lock(&macsec->stats_lock);
+	memset(&macsec->dev_stats, 0, sizeof(macsec->dev_stats));
+	memset(&macsec->tx_sc_stats, 0, sizeof(macsec->tx_sc_stats));
+	memset(&macsec->rx_sc_stats, 0, sizeof(macsec->rx_sc_stats));
+	spin_unlock(&macsec->stats_lock);
+
+	macsec->secy = ctx->secy;
+
+	return 0;
+}
+
+static int ixgbe_macsec_upd_secy(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int err;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	err = ixgbe_macsec_check_secy(adapter, ctx->secy);
+	if (err)
+		return err;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED) {
+		ixgbe_macsec_write_ctrl(adapter);
+		ixgbe_macsec_write_sci(&adapter->hw, IXGBE_LSECTXSCL,
+				       IXGBE_LSECTXSCH, ctx->secy->sci);
+		ixgbe_macsec_select_tx_sa(adapter);
+	}
+
+	return 0;
+}
+
+static int ixgbe_macsec_del_secy(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	macsec->running = false;
+	ixgbe_macsec_disable(adapter);
+
+	memset(macsec->tx_sa, 0, sizeof(macsec->tx_sa));
+	memset(macsec->rx_sa, 0, sizeof(macsec->rx_sa));
+	macsec->rx_sc_used = false;
+	WRITE_ONCE(macsec->secy, NULL);
+
+	return 0;
+}
+
+static int ixgbe_macsec_add_rxsc(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	if (macsec->rx_sc_used) {
+		netdev_err(ctx->netdev, "MACsec offload supports a single Rx SC\n");
+		return -ENOSPC;
+	}
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	macsec->rx_sci = ctx->rx_sc->sci;
+	macsec->rx_sc_active = ctx->rx_sc->active;
+	macsec->rx_sc_used = true;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		ixgbe_macsec_write_sci(&adapter->hw, IXGBE_LSECRXSCL,
+				       IXGBE_LSECRXSCH, macsec->rx_sci);
+
+	return 0;
+}
+
+static int ixgbe_macsec_upd_rxsc(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int i;
+
+	if (!macsec->rx_sc_used || macsec->rx_sci != ctx->rx_sc->sci)
+		return -EINVAL;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	ixgbe_macsec_save_pn(adapter);
+	macsec->rx_sc_active = ctx->rx_sc->active;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++)
+			ixgbe_macsec_set_rx_sa(&adapter->hw, i,
+					       &macsec->rx_sa[i],
+					       ixgbe_macsec_rx_sa_valid(macsec,
+									i));
+
+	return 0;
+}
+
+static int ixgbe_macsec_del_rxsc(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int i;
+
+	if (!macsec->rx_sc_used || macsec->rx_sci != ctx->rx_sc->sci)
+		return -EINVAL;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		for (i = 0; i < IXGBE_MACSEC_NUM_SA; i++)
+			IXGBE_WRITE_REG(&adapter->hw, IXGBE_LSECRXSA(i), 0);
+
+	memset(macsec->rx_sa, 0, sizeof(macsec->rx_sa));
+	macsec->rx_sc_used = false;
+
+	return 0;
+}
+
+static int ixgbe_macsec_add_rxsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_rx_sa *rx_sa = ctx->sa.rx_sa;
+	struct ixgbe_macsec_rx_sa *sa;
+	int idx;
+
+	if (!macsec->rx_sc_used || macsec->rx_sci != rx_sa->sc->sci)
+		return -EINVAL;
+
+	if (ixgbe_macsec_find_rx_sa(macsec, ctx->sa.assoc_num) >= 0)
+		return -EEXIST;
+
+	for (idx = 0; idx < IXGBE_MACSEC_NUM_SA; idx++)
+		if (!macsec->rx_sa[idx].used)
+			break;
+	if (idx == IXGBE_MACSEC_NUM_SA) {
+		netdev_err(ctx->netdev, "MACsec offload supports two Rx SAs\n");
+		return -ENOSPC;
+	}
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	sa = &macsec->rx_sa[idx];
+	memset(sa, 0, sizeof(*sa));
+	memcpy(sa->key, ctx->sa.key, IXGBE_MACSEC_KEY_LEN);
+	sa->next_pn = rx_sa->next_pn_halves.lower;
+	sa->sw_pn = sa->next_pn;
+	sa->an = ctx->sa.assoc_num;
+	sa->active = rx_sa->active;
+	sa->used = true;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		ixgbe_macsec_set_rx_sa(&adapter->hw, idx, sa,
+				       ixgbe_macsec_rx_sa_valid(macsec, idx));
+
+	return 0;
+}
+
+static int ixgbe_macsec_upd_rxsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_rx_sa *rx_sa = ctx->sa.rx_sa;
+	struct ixgbe_macsec_rx_sa *sa;
+	int idx;
+
+	idx = ixgbe_macsec_find_rx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	ixgbe_macsec_save_pn(adapter);
+
+	sa = &macsec->rx_sa[idx];
+	sa->active = rx_sa->active;
+	/* the stack's PN only moves when the user sets one */
+	if (rx_sa->next_pn_halves.lower != sa->sw_pn) {
+		sa->next_pn = rx_sa->next_pn_halves.lower;
+		sa->sw_pn = sa->next_pn;
+	}
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		ixgbe_macsec_set_rx_sa(&adapter->hw, idx, sa,
+				       ixgbe_macsec_rx_sa_valid(macsec, idx));
+
+	return 0;
+}
+
+static int ixgbe_macsec_del_rxsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int idx;
+
+	idx = ixgbe_macsec_find_rx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		IXGBE_WRITE_REG(&adapter->hw, IXGBE_LSECRXSA(idx), 0);
+
+	memset(&macsec->rx_sa[idx], 0, sizeof(macsec->rx_sa[idx]));
+
+	return 0;
+}
+
+static int ixgbe_macsec_add_txsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_tx_sa *tx_sa = ctx->sa.tx_sa;
+	struct ixgbe_macsec_tx_sa *sa;
+	int idx;
+
+	if (macsec->secy != ctx->secy)
+		return -EINVAL;
+
+	if (ixgbe_macsec_find_tx_sa(macsec, ctx->sa.assoc_num) >= 0)
+		return -EEXIST;
+
+	for (idx = 0; idx < IXGBE_MACSEC_NUM_SA; idx++)
+		if (!macsec->tx_sa[idx].used)
+			break;
+	if (idx == IXGBE_MACSEC_NUM_SA) {
+		netdev_err(ctx->netdev, "MACsec offload supports two Tx SAs\n");
+		return -ENOSPC;
+	}
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	sa = &macsec->tx_sa[idx];
+	memset(sa, 0, sizeof(*sa));
+	memcpy(sa->key, ctx->sa.key, IXGBE_MACSEC_KEY_LEN);
+	sa->next_pn = tx_sa->next_pn_halves.lower;
+	sa->sw_pn = sa->next_pn;
+	sa->an = ctx->sa.assoc_num;
+	sa->active = tx_sa->active;
+	sa->used = true;
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED) {
+		ixgbe_macsec_set_tx_sa(&adapter->hw, idx, sa);
+		ixgbe_macsec_select_tx_sa(adapter);
+	}
+
+	return 0;
+}
+
+static int ixgbe_macsec_upd_txsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_tx_sa *tx_sa = ctx->sa.tx_sa;
+	struct ixgbe_macsec_tx_sa *sa;
+	int idx;
+
+	idx = ixgbe_macsec_find_tx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	sa = &macsec->tx_sa[idx];
+	sa->active = tx_sa->active;
+	if (tx_sa->next_pn_halves.lower != sa->sw_pn) {
+		sa->next_pn = tx_sa->next_pn_halves.lower;
+		sa->sw_pn = sa->next_pn;
+		if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+			ixgbe_macsec_set_tx_sa(&adapter->hw, idx, sa);
+	}
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED)
+		ixgbe_macsec_select_tx_sa(adapter);
+
+	return 0;
+}
+
+static int ixgbe_macsec_del_txsa(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	int idx;
+
+	idx = ixgbe_macsec_find_tx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	memset(&macsec->tx_sa[idx], 0, sizeof(macsec->tx_sa[idx]));
+
+	if (adapter->flags2 & IXGBE_FLAG2_MACSEC_ENABLED) {
+		ixgbe_macsec_set_tx_sa(&adapter->hw, idx, &macsec->tx_sa[idx]);
+		ixgbe_macsec_select_tx_sa(adapter);
+	}
+
+	return 0;
+}
+
+static int ixgbe_macsec_get_dev_stats(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	ixgbe_macsec_update_stats(adapter);
+
+	spin_lock(&macsec->stats_lock);
+	*ctx->stats.dev_stats = macsec->dev_stats;
+	spin_unlock(&macsec->stats_lock);
+
+	return 0;
+}
+
+static int ixgbe_macsec_get_tx_sc_stats(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	ixgbe_macsec_update_stats(adapter);
+
+	spin_lock(&macsec->stats_lock);
+	*ctx->stats.tx_sc_stats = macsec->tx_sc_stats;
+	spin_unlock(&macsec->stats_lock);
+
+	return 0;
+}
+
+static int ixgbe_macsec_get_tx_sa_stats(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_tx_sa_stats *stats = ctx->stats.tx_sa_stats;
+	int idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	idx = ixgbe_macsec_find_tx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return 0;
+
+	ixgbe_macsec_update_stats(adapter);
+
+	spin_lock(&macsec->stats_lock);
+	stats->OutPktsProtected = macsec->tx_sa[idx].out_pkts_protected;
+	stats->OutPktsEncrypted = macsec->tx_sa[idx].out_pkts_encrypted;
+	spin_unlock(&macsec->stats_lock);
+
+	return 0;
+}
+
+static int ixgbe_macsec_get_rx_sc_stats(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	ixgbe_macsec_update_stats(adapter);
+
+	spin_lock(&macsec->stats_lock);
+	*ctx->stats.rx_sc_stats = macsec->rx_sc_stats;
+	spin_unlock(&macsec->stats_lock);
+
+	return 0;
+}
+
+static int ixgbe_macsec_get_rx_sa_stats(struct macsec_context *ctx)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(ctx->netdev);
+	struct ixgbe_macsec *macsec = adapter->macsec;
+	struct macsec_rx_sa_stats *stats = ctx->stats.rx_sa_stats;
+	int idx;
+
+	if (ixgbe_macsec_prepare(ctx))
+		return 0;
+
+	idx = ixgbe_macsec_find_rx_sa(macsec, ctx->sa.assoc_num);
+	if (idx < 0)
+		return 0;
+
+	ixgbe_macsec_update_stats(adapter);
+
+	spin_lock(&macsec->stats_lock);
+	stats->InPktsOK = macsec->rx_sa[idx].in_pkts_ok;
+	stats->InPktsInvalid = macsec->rx_sa[idx].in_pkts_invalid;
+	stats->InPktsNotValid = macsec->rx_sa[idx].in_pkts_not_valid;
+	spin_unlock(&macsec->stats_lock);
+
+	return 0;
+}
+
+static const struct macsec_ops ixgbe_macsec_ops = {
+	.mdo_dev_open = ixgbe_macsec_dev_open,
+	.mdo_dev_stop = ixgbe_macsec_dev_stop,
+	.mdo_add_secy = ixgbe_macsec_add_secy,
+	.mdo_upd_secy = ixgbe_macsec_upd_secy,
+	.mdo_del_secy = ixgbe_macsec_del_secy,
+	.mdo_add_rxsc = ixgbe_macsec_add_rxsc,
+	.mdo_upd_rxsc = ixgbe_macsec_upd_rxsc,
+	.mdo_del_rxsc = ixgbe_macsec_del_rxsc,
+	.mdo_add_rxsa = ixgbe_macsec_add_rxsa,
+	.mdo_upd_rxsa = ixgbe_macsec_upd_rxsa,
+	.mdo_del_rxsa = ixgbe_macsec_del_rxsa,
+	.mdo_add_txsa = ixgbe_macsec_add_txsa,
+	.mdo_upd_txsa = ixgbe_macsec_upd_txsa,
+	.mdo_del_txsa = ixgbe_macsec_del_txsa,
+	.mdo_get_dev_stats = ixgbe_macsec_get_dev_stats,
+	.mdo_get_tx_sc_stats = ixgbe_macsec_get_tx_sc_stats,
+	.mdo_get_tx_sa_stats = ixgbe_macsec_get_tx_sa_stats,
+	.mdo_get_rx_sc_stats = ixgbe_macsec_get_rx_sc_stats,
+	.mdo_get_rx_sa_stats = ixgbe_macsec_get_rx_sa_stats,
+};
+
+/**
+ * ixgbe_init_macsec_offload - set up MACsec offload if the HW supports it
+ * @adapter: board private structure
+ **/
+void ixgbe_init_macsec_offload(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	struct ixgbe_macsec *macsec;
+
+	switch (hw->mac.type) {
+	case ixgbe_mac_82599EB:
+	case ixgbe_mac_X540:
+		break;
+	default:
+		return;
+	}
+
+	/* the security block may be fused off on some SKUs */
+	if ((IXGBE_READ_REG(hw, IXGBE_SECTXSTAT) &
+	     IXGBE_SECTXSTAT_SECTX_OFF_DIS) ||
+	    (IXGBE_READ_REG(hw, IXGBE_SECRXSTAT) &
+	     IXGBE_SECRXSTAT_SECRX_OFF_DIS))
+		return;
+
+	macsec = kzalloc(sizeof(*macsec), GFP_KERNEL);
+	if (!macsec) {
+		e_dev_err("Unable to allocate memory for MACsec offload\n");
+		return;
+	}
+
+	spin_lock_init(&macsec->stats_lock);
+	macsec->tx_sel = -1;
+	adapter->macsec = macsec;
+	adapter->netdev->macsec_ops = &ixgbe_macsec_ops;
+}
+
+/**
+ * ixgbe_stop_macsec_offload - tear down the MACsec offload
+ * @adapter: board private structure
+ **/
+void ixgbe_stop_macsec_offload(struct ixgbe_adapter *adapter)
+{
+	kfree(adapter->macsec);
+	adapter->macsec = NULL;
+}
+#endif /* HAVE_IXGBE_MACSEC */
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* Copyright (C) 1999 - 2025 Intel Corporation */
+
+#ifndef _IXGBE_MACSEC_H_
+#define _IXGBE_MACSEC_H_
+
+#include <net/macsec.h>
+#include <net/dst_metadata.h>
+
+/* the LinkSec block has a single Tx and Rx SC, each with two SA slots */
+#define IXGBE_MACSEC_NUM_SA		2
+#define IXGBE_MACSEC_KEY_LEN		16
+
+/* what the Tx path does with frames of the offloaded SecY */
+enum ixgbe_macsec_tx_state {
+	IXGBE_MACSEC_TX_DROP = 0,	/* no usable encoding SA */
+	IXGBE_MACSEC_TX_CLEAR,		/* SecY does not protect frames */
+	IXGBE_MACSEC_TX_PROTECT,
+};
+
+struct ixgbe_macsec_tx_sa {
+	u8 key[IXGBE_MACSEC_KEY_LEN];
+	u32 next_pn;	/* PN last programmed, or saved across a reset */
+	u32 sw_pn;	/* next_pn as last seen from the stack */
+	u8 an;
+	bool used;
+	bool active;
+	u64 out_pkts_protected;
+	u64 out_pkts_encrypted;
+};
+
+struct ixgbe_macsec_rx_sa {
+	u8 key[IXGBE_MACSEC_KEY_LEN];
+	u32 next_pn;
+	u32 sw_pn;
+	u8 an;
+	bool used;
+	bool active;
+	u64 in_pkts_ok;
+	u64 in_pkts_invalid;
+	u64 in_pkts_not_valid;
+};
+
+struct ixgbe_macsec {
+	struct macsec_secy *secy;	/* the one offloaded SecY, or NULL */
+	bool running;			/* SecY netdev is up */
+	bool rx_sc_used;
+	bool rx_sc_active;
+	sci_t rx_sci;
+	u8 tx_state;			/* enum ixgbe_macsec_tx_state */
+	int tx_sel;			/* Tx SA slot in use, or -1 */
+	struct ixgbe_macsec_tx_sa tx_sa[IXGBE_MACSEC_NUM_SA];
+	struct ixgbe_macsec_rx_sa rx_sa[IXGBE_MACSEC_NUM_SA];
+
+	/* accumulated from the clear-on-read LinkSec counters */
+	spinlock_t stats_lock;
+	struct macsec_dev_stats dev_stats;
+	struct macsec_tx_sc_stats tx_sc_stats;
+	struct macsec_rx_sc_stats rx_sc_stats;
+};
+
+/**
+ * ixgbe_macsec_skb - check whether a frame belongs to the offloaded SecY
+ * @skb: frame being transmitted
+ *
+ * The MACsec driver tags offloaded frames with a metadata dst before
+ * handing them to the real device.
+ **/
+static inline bool ixgbe_macsec_skb(struct sk_buff *skb)
+{
+	struct metadata_dst *md_dst = skb_metadata_dst(skb);
+
+	return md_dst && md_dst->type == METADATA_MACSEC;
+}
+
+#endif /* _IXGBE_MACSEC_H_ */
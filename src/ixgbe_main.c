@@ -57,6 +57,7 @@
 
 #include "ixgbe_devlink.h"
 #include "ixgbe_dcb_82599.h"
+#include "ixgbe_phy.h"
 #include "ixgbe_sriov.h"
 #include "ixgbe_txrx_common.h"
 #ifdef HAVE_TC_SETUP_CLSU32
@@ -85,6 +86,11 @@ const char ixgbe_driver_name[] = "ixgbe";
 #endif
 static const char ixgbe_driver_string[] = DRV_SUMMARY;
 static const char ixgbe_copyright[] = "Copyright (C) 1999 - 2025 Intel Corporation";
+#ifdef CONFIG_FAULT_INJECTION
+struct fault_attr ixgbe_fault_attr[IXGBE_FAULT_NUM_TYPES] = {
+	[0 ... IXGBE_FAULT_NUM_TYPES - 1] = FAULT_ATTR_INITIALIZER,
+};
+#endif
 static const char ixgbe_overheat_msg[] =
 		"Network adapter has been stopped because it has over heated. "
 		"Restart the computer. If the problem persists, "
@@ -169,6 +175,7 @@ static struct notifier_block dca_notifier = {
 static void ixgbe_watchdog_link_is_down(struct ixgbe_adapter *);
 static void ixgbe_watchdog_link_is_up(struct ixgbe_adapter *);
 static void ixgbe_watchdog_update_link(struct ixgbe_adapter *);
+static void ixgbe_module_cache_invalidate(struct ixgbe_adapter *);
 
 MODULE_AUTHOR("Intel Corporation, <linux.nics@intel.com>");
 MODULE_DESCRIPTION(DRV_SUMMARY);
@@ -359,6 +366,22 @@ static void ixgbe_remove_adapter(struct ixgbe_hw *hw)
 		ixgbe_service_event_schedule(adapter);
 }
 
+/**
+ * ixgbe_readl - raw MMIO read
+ * @reg_addr: mapped register base
+ * @reg: register offset
+ *
+ * Returns all ones when a register read failure has been injected, so the
+ * surprise removal handling can be exercised without pulling the device.
+ **/
+static inline u32 ixgbe_readl(u8 __iomem *reg_addr, u32 reg)
+{
+	if (unlikely(ixgbe_should_fail(IXGBE_FAULT_REG_READ)))
+		return IXGBE_FAILED_READ_REG;
+
+	return readl(reg_addr + reg);
+}
+
 static u32
 ixgbe_check_remove(struct ixgbe_hw *hw, u32 reg)
 {
@@ -375,7 +398,7 @@ ixgbe_check_remove(struct ixgbe_hw *hw, u32 reg)
 	 * the adapter has been removed.
 	 */
 	for (i = 0; i < IXGBE_FAILED_READ_RETRIES; ++i) {
-		value = readl(reg_addr + IXGBE_STATUS);
+		value = ixgbe_readl(reg_addr, IXGBE_STATUS);
 		if (value != IXGBE_FAILED_READ_REG)
 			break;
 		mdelay(3);
@@ -384,7 +407,7 @@ ixgbe_check_remove(struct ixgbe_hw *hw, u32 reg)
 	if (value == IXGBE_FAILED_READ_REG)
 		ixgbe_remove_adapter(hw);
 	else
-		value = readl(reg_addr + reg);
+		value = ixgbe_readl(reg_addr, reg);
 	return value;
 }
 
@@ -443,7 +466,7 @@ u32 ixgbe_read_reg(struct ixgbe_hw *hw, u32 reg, bool quiet)
 	}
 
 writes_completed:
-	value = readl(reg_addr + reg);
+	value = ixgbe_readl(reg_addr, reg);
 	if (unlikely(value == IXGBE_FAILED_READ_REG))
 		value = ixgbe_check_remove(hw, reg);
 	if (unlikely(value == IXGBE_DEAD_READ_REG))
@@ -451,6 +474,132 @@ writes_completed:
 	return value;
 }
 
+static const struct {
+	u16 base;
+	u16 count;
+} ixgbe_shadow_layout[IXGBE_SHADOW_NUM_TYPES] = {
+	[IXGBE_SHADOW_SRRCTL]	= {   0, 128 },
+	[IXGBE_SHADOW_RXDCTL]	= { 128, 128 },
+	[IXGBE_SHADOW_PSRTYPE]	= { 256,  64 },
+	[IXGBE_SHADOW_VMOLR]	= { 320,  64 },
+	[IXGBE_SHADOW_RETA]	= { 384, 128 },
+	[IXGBE_SHADOW_RSSRK]	= { 512,  10 },
+	[IXGBE_SHADOW_VLNCTRL]	= { 522,   1 },
+};
+
+static u32 ixgbe_shadow_reg_offset(enum ixgbe_shadow_reg type, u32 idx)
+{
+	switch (type) {
+	case IXGBE_SHADOW_SRRCTL:
+		return IXGBE_SRRCTL(idx);
+	case IXGBE_SHADOW_RXDCTL:
+		return IXGBE_RXDCTL(idx);
+	case IXGBE_SHADOW_PSRTYPE:
+		return IXGBE_PSRTYPE(idx);
+	case IXGBE_SHADOW_VMOLR:
+		return IXGBE_VMOLR(idx);
+	case IXGBE_SHADOW_RETA:
+		return idx < 32 ? IXGBE_RETA(idx) : IXGBE_ERETA(idx - 32);
+	case IXGBE_SHADOW_RSSRK:
+		return IXGBE_RSSRK(idx);
+	case IXGBE_SHADOW_VLNCTRL:
+	default:
+		return IXGBE_VLNCTRL;
+	}
+}
+
+/**
+ * ixgbe_shadow_read - read a configuration register through the shadow
+ * @adapter: board private structure
+ * @type: register family
+ * @idx: register index within the family
+ *
+ * Returns the last value written by the driver, only touching the hardware
+ * the first time the register is read after a reset.  Must not be used to
+ * poll for state the hardware changes on its own, such as RXDCTL.ENABLE.
+ **/
+u32 ixgbe_shadow_read(struct ixgbe_adapter *adapter,
+		      enum ixgbe_shadow_reg type, u32 idx)
+{
+	struct ixgbe_reg_shadow *shadow = &adapter->reg_shadow;
+	u32 slot = ixgbe_shadow_layout[type].base + idx;
+	unsigned long flags;
+	u32 value;
+
+	if (WARN_ON_ONCE(idx >= ixgbe_shadow_layout[type].count))
+		return IXGBE_READ_REG(&adapter->hw,
+				      ixgbe_shadow_reg_offset(type, idx));
+
+	spin_lock_irqsave(&shadow->lock, flags);
+	if (test_bit(slot, shadow->valid)) {
+		value = shadow->val[slot];
+	} else {
+		value = IXGBE_READ_REG(&adapter->hw,
+				       ixgbe_shadow_reg_offset(type, idx));
+		if (value != IXGBE_FAILED_READ_REG) {
+			shadow->val[slot] = value;
+			__set_bit(slot, shadow->valid);
+		}
+	}
+	spin_unlock_irqrestore(&shadow->lock, flags);
+
+	return value;
+}
+
+/**
+ * ixgbe_shadow_write - write a configuration register through the shadow
+ * @adapter: board private structure
+ * @type: register family
+ * @idx: register index within the family
+ * @value: value to write
+ *
+ * The write is skipped when the register already holds @value.  RXDCTL is
+ * always written since it starts and flushes the queue, and its self
+ * clearing SWFLSH bit is never kept in the copy.
+ **/
+void ixgbe_shadow_write(struct ixgbe_adapter *adapter,
+			enum ixgbe_shadow_reg type, u32 idx, u32 value)
+{
+	struct ixgbe_reg_shadow *shadow = &adapter->reg_shadow;
+	u32 slot = ixgbe_shadow_layout[type].base + idx;
+	unsigned long flags;
+
+	if (WARN_ON_ONCE(idx >= ixgbe_shadow_layout[type].count)) {
+		IXGBE_WRITE_REG(&adapter->hw,
+				ixgbe_shadow_reg_offset(type, idx), value);
+		return;
+	}
+
+	spin_lock_irqsave(&shadow->lock, flags);
+	if (type == IXGBE_SHADOW_RXDCTL || !test_bit(slot, shadow->valid) ||
+	    shadow->val[slot] != value)
+		IXGBE_WRITE_REG(&adapter->hw,
+				ixgbe_shadow_reg_offset(type, idx), value);
+
+	if (type == IXGBE_SHADOW_RXDCTL)
+		value &= ~IXGBE_RXDCTL_SWFLSH;
+	shadow->val[slot] = value;
+	__set_bit(slot, shadow->valid);
+	spin_unlock_irqrestore(&shadow->lock, flags);
+}
+
+/**
+ * ixgbe_reg_shadow_invalidate - forget all shadowed register values
+ * @adapter: board private structure
+ *
+ * Called when the hardware may have changed the registers behind our back,
+ * i.e. on MAC reset or when registers are written through debugfs.
+ **/
+void ixgbe_reg_shadow_invalidate(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_reg_shadow *shadow = &adapter->reg_shadow;
+	unsigned long flags;
+
+	spin_lock_irqsave(&shadow->lock, flags);
+	bitmap_zero(shadow->valid, IXGBE_SHADOW_SIZE);
+	spin_unlock_irqrestore(&shadow->lock, flags);
+}
+
 static void ixgbe_release_hw_control(struct ixgbe_adapter *adapter)
 {
 	u32 ctrl_ext;
@@ -745,6 +894,35 @@ static void ixgbe_tx_timeout_reset(struct ixgbe_adapter *adapter)
 	}
 }
 
+/**
+ * ixgbe_tx_recovery_request - schedule recovery of a single hung Tx queue
+ * @adapter: driver private struct
+ * @tx_ring: ring that stopped making progress
+ *
+ * The queue is flushed and restarted from the service task while all other
+ * queues keep running.  XDP rings, 82598 parts and queues that already hung
+ * shortly after a previous recovery get a full adapter reset instead.
+ **/
+static void ixgbe_tx_recovery_request(struct ixgbe_adapter *adapter,
+				      struct ixgbe_ring *tx_ring)
+{
+	if (ring_is_xdp(tx_ring) ||
+	    adapter->hw.mac.type == ixgbe_mac_82598EB ||
+	    (tx_ring->last_tx_recovery &&
+	     time_before(jiffies, tx_ring->last_tx_recovery +
+				  IXGBE_TX_RECOVERY_INTERVAL))) {
+		ixgbe_tx_timeout_reset(adapter);
+		return;
+	}
+
+	if (test_bit(__IXGBE_DOWN, adapter->state))
+		return;
+
+	set_bit(__IXGBE_TX_RECOVER_REQUESTED, &tx_ring->state);
+	set_bit(__IXGBE_TX_RECOVERY_REQUESTED, adapter->state);
+	ixgbe_service_event_schedule(adapter);
+}
+
 /**
  * ixgbe_tx_timeout - Respond to a Tx Hang
  * @netdev: network interface device structure
@@ -763,13 +941,14 @@ static void ixgbe_tx_timeout(struct net_device *netdev)
 #define TX_TIMEO_LIMIT 16000
 	for (i = 0; i < adapter->num_tx_queues; i++) {
 		struct ixgbe_ring *tx_ring = adapter->tx_ring[i];
-		if (check_for_tx_hang(tx_ring) && ixgbe_check_tx_hang(tx_ring))
+		if (check_for_tx_hang(tx_ring) &&
+		    ixgbe_check_tx_hang(tx_ring)) {
+			ixgbe_tx_recovery_request(adapter, tx_ring);
 			real_tx_hang = true;
+		}
 	}
 
-	if (real_tx_hang) {
-		ixgbe_tx_timeout_reset(adapter);
-	} else {
+	if (!real_tx_hang) {
 		e_info(drv, "Fake Tx hang detected with timeout of %d "
 			"seconds\n", netdev->watchdog_timeo/HZ);
 
@@ -1046,12 +1225,14 @@ static bool ixgbe_clean_tx_irq(struct ixgbe_q_vector *q_vector,
 		ixgbe_reset_pf_report(tx_ring, i);
 
 		e_info(probe,
-		       "tx hang %d detected on queue %d, resetting adapter\n",
-		       adapter->tx_timeout_count + 1, tx_ring->queue_index);
+		       "tx hang %d detected on queue %d, resetting queue\n",
+		       adapter->tx_timeout_count +
+		       adapter->tx_queue_recovery_count + 1,
+		       tx_ring->queue_index);
 
-		ixgbe_tx_timeout_reset(adapter);
+		ixgbe_tx_recovery_request(adapter, tx_ring);
 
-		/* the adapter is about to reset, no point in enabling stuff */
+		/* the queue is about to reset, no point in enabling stuff */
 		return true;
 	}
 
@@ -1431,12 +1612,22 @@ static bool ixgbe_alloc_mapped_page(struct ixgbe_ring *rx_ring,
 		return true;
 
 	/* alloc new page for storage */
-	page = dev_alloc_pages(ixgbe_rx_pg_order(rx_ring));
+	if (unlikely(ixgbe_should_fail(IXGBE_FAULT_PAGE_ALLOC)))
+		page = NULL;
+	else
+		page = dev_alloc_pages(ixgbe_rx_pg_order(rx_ring));
 	if (unlikely(!page)) {
 		rx_ring->rx_stats.alloc_rx_page_failed++;
 		return false;
 	}
 
+	if (unlikely(ixgbe_should_fail(IXGBE_FAULT_DMA_MAP))) {
+		__free_pages(page, ixgbe_rx_pg_order(rx_ring));
+
+		rx_ring->rx_stats.alloc_rx_page_failed++;
+		return false;
+	}
+
 	/* map page for use */
 	dma = dma_map_page_attrs(rx_ring->dev, page, 0,
 				 ixgbe_rx_pg_size(rx_ring),
@@ -1654,18 +1845,27 @@ static void ixgbe_receive_skb(struct ixgbe_q_vector *q_vector,
 static void ixgbe_set_rsc_gso_size(struct ixgbe_ring __maybe_unused *ring,
 				   struct sk_buff *skb)
 {
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
 	u16 hdr_len = skb_headlen(skb);
 
 	/* set gso_size to avoid messing up TCP MSS */
-	skb_shinfo(skb)->gso_size = DIV_ROUND_UP((skb->len - hdr_len),
-						 IXGBE_CB(skb)->append_cnt);
-	skb_shinfo(skb)->gso_type = SKB_GSO_TCPV4;
+	shinfo->gso_size = DIV_ROUND_UP((skb->len - hdr_len),
+					IXGBE_CB(skb)->append_cnt);
+	shinfo->gso_type = SKB_GSO_TCPV4;
+
+	/* GRO starts its segment count for a held GSO frame from gso_segs,
+	 * so it must be set for later segments to merge onto the aggregation
+	 */
+	shinfo->gso_segs = DIV_ROUND_UP((skb->len - hdr_len),
+					shinfo->gso_size);
 }
 
 #endif /* NETIF_F_GSO */
 static void ixgbe_update_rsc_stats(struct ixgbe_ring *rx_ring,
 				   struct sk_buff *skb)
 {
+	int bucket;
+
 	/* if append_cnt is 0 then frame is not RSC */
 	if (!IXGBE_CB(skb)->append_cnt)
 		return;
@@ -1673,6 +1873,12 @@ static void ixgbe_update_rsc_stats(struct ixgbe_ring *rx_ring,
 	rx_ring->rx_stats.rsc_count += IXGBE_CB(skb)->append_cnt;
 	rx_ring->rx_stats.rsc_flush++;
 
+	/* bucket by the number of segments in the aggregation */
+	bucket = fls(IXGBE_CB(skb)->append_cnt + 1) - 2;
+	if (bucket >= IXGBE_RSC_HIST_BUCKETS)
+		bucket = IXGBE_RSC_HIST_BUCKETS - 1;
+	rx_ring->rx_stats.rsc_hist[bucket]++;
+
 #ifdef NETIF_F_GSO
 	ixgbe_set_rsc_gso_size(rx_ring, skb);
 
@@ -1681,10 +1887,41 @@ static void ixgbe_update_rsc_stats(struct ixgbe_ring *rx_ring,
 	IXGBE_CB(skb)->append_cnt = 0;
 }
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+/**
+ * ixgbe_rx_stag - move the outer 802.1ad tag into the skb
+ * @skb: frame received in double VLAN mode
+ *
+ * The MAC parses past the S-tag but leaves it in the buffer. Pop it
+ * while the header is still hot so the stack sees an accelerated tag.
+ **/
+static void ixgbe_rx_stag(struct sk_buff *skb)
+{
+	struct vlan_ethhdr *veth = (struct vlan_ethhdr *)skb->data;
+	u16 vlan_tci;
+
+	if (unlikely(skb_headlen(skb) < VLAN_ETH_HLEN) ||
+	    veth->h_vlan_proto != htons(ETH_P_8021AD))
+		return;
+
+	vlan_tci = ntohs(veth->h_vlan_TCI);
+	memmove(skb->data + VLAN_HLEN, skb->data, 2 * ETH_ALEN);
+	__skb_pull(skb, VLAN_HLEN);
+	__vlan_hwaccel_put_tag(skb, htons(ETH_P_8021AD), vlan_tci);
+}
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
 static void ixgbe_rx_vlan(struct ixgbe_ring *ring,
 			  union ixgbe_adv_rx_desc *rx_desc,
 			  struct sk_buff *skb)
 {
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	if (netdev_ring(ring)->features & NETIF_F_HW_VLAN_STAG_RX) {
+		ixgbe_rx_stag(skb);
+		return;
+	}
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
 #ifdef NETIF_F_HW_VLAN_CTAG_RX
 	if ((netdev_ring(ring)->features & NETIF_F_HW_VLAN_CTAG_RX) &&
 #else
@@ -1734,6 +1971,11 @@ void ixgbe_process_skb_fields(struct ixgbe_ring *rx_ring,
 #endif
 	ixgbe_rx_vlan(rx_ring, rx_desc, skb);
 
+#ifdef HAVE_IXGBE_IPSEC
+	if (ixgbe_test_staterr(rx_desc, IXGBE_RXDADV_IPSEC_STATUS_SECP))
+		ixgbe_ipsec_rx(rx_ring, rx_desc, skb);
+
+#endif /* HAVE_IXGBE_IPSEC */
 	skb_record_rx_queue(skb, ring_queue_index(rx_ring));
 	skb->protocol = eth_type_trans(skb, netdev_ring(rx_ring));
 }
@@ -1942,13 +2184,34 @@ bool ixgbe_cleanup_headers(struct ixgbe_ring __maybe_unused *rx_ring,
 			   union ixgbe_adv_rx_desc *rx_desc,
 			   struct sk_buff *skb)
 {
+	u32 err_mask = IXGBE_RXDADV_ERR_FRAME_ERR_MASK;
+
 	/* XDP packets use error pointer so abort at this point */
 	if (IS_ERR(skb))
 		return true;
 
+#if defined(HAVE_IXGBE_IPSEC) || defined(HAVE_IXGBE_MACSEC)
+	if (ixgbe_test_staterr(rx_desc, IXGBE_RXDADV_IPSEC_STATUS_SECP)) {
+		__le16 pkt_info = rx_desc->wb.lower.lo_dword.hs_rss.pkt_info;
+
+#ifdef HAVE_IXGBE_IPSEC
+		/* on IPsec frames these bits carry the decrypt status instead,
+		 * and ixgbe_ipsec_rx() hands it to the stack to account and drop
+		 */
+		if (pkt_info & cpu_to_le16(IXGBE_RXDADV_PKTTYPE_IPSEC_ESP))
+			err_mask &= ~IXGBE_RXDADV_IPSEC_ERROR_BIT_MASK;
+#endif /* HAVE_IXGBE_IPSEC */
+#ifdef HAVE_IXGBE_MACSEC
+		/* on LinkSec frames they carry the validation result */
+		if ((pkt_info & cpu_to_le16(IXGBE_RXDADV_PKTTYPE_LINKSEC)) &&
+		    !ixgbe_macsec_rx_drop(rx_ring, rx_desc))
+			err_mask &= ~IXGBE_RXDADV_LNKSEC_ERROR_BIT_MASK;
+#endif /* HAVE_IXGBE_MACSEC */
+	}
+
+#endif /* HAVE_IXGBE_IPSEC || HAVE_IXGBE_MACSEC */
 	/* verify that the packet does not have any known errors */
-	if (unlikely(ixgbe_test_staterr(rx_desc,
-					IXGBE_RXDADV_ERR_FRAME_ERR_MASK))) {
+	if (unlikely(ixgbe_test_staterr(rx_desc, err_mask))) {
 		dev_kfree_skb_any(skb);
 		return true;
 	}
@@ -2128,6 +2391,66 @@ skip_sync:
 	return rx_buffer;
 }
 
+/**
+ * ixgbe_rx_ring_over_target - check if a ring holds enough Rx pages
+ * @rx_ring: rx descriptor ring
+ *
+ * Pages between next_to_clean and next_to_alloc are either posted to
+ * hardware or parked for the next refill.  Once a ring with a lowered
+ * fill target holds that many, further pages are released instead of
+ * being recycled so the ring actually gives memory back.
+ **/
+static bool ixgbe_rx_ring_over_target(struct ixgbe_ring *rx_ring)
+{
+	u16 target = READ_ONCE(rx_ring->rx_fill_target);
+	int held;
+
+	if (likely(target >= rx_ring->count - 1))
+		return false;
+
+	held = rx_ring->next_to_alloc - rx_ring->next_to_clean;
+	if (held < 0)
+		held += rx_ring->count;
+
+	return held >= target;
+}
+
+/**
+ * ixgbe_rx_fill_count - number of Rx buffers to post on refill
+ * @rx_ring: rx descriptor ring
+ * @cleaned_count: descriptors returned by hardware since the last refill
+ *
+ * Rings at full target simply replace what was cleaned.  Otherwise the
+ * ring is only topped up to its target, always covering the pages parked
+ * by ixgbe_reuse_rx_page since ixgbe_release_rx_desc will move
+ * next_to_alloc back to next_to_use.  If hardware has consumed half of
+ * what was posted the ring is busy again and goes straight back to full.
+ **/
+static u16 ixgbe_rx_fill_count(struct ixgbe_ring *rx_ring, u16 cleaned_count)
+{
+	u16 target = READ_ONCE(rx_ring->rx_fill_target);
+	int posted, parked, fill;
+
+	if (likely(target >= rx_ring->count - 1))
+		return cleaned_count;
+
+	posted = rx_ring->next_to_use - rx_ring->next_to_clean;
+	if (posted < 0)
+		posted += rx_ring->count;
+	parked = rx_ring->next_to_alloc - rx_ring->next_to_use;
+	if (parked < 0)
+		parked += rx_ring->count;
+
+	if (posted < target / 2) {
+		WRITE_ONCE(rx_ring->rx_fill_target, rx_ring->count - 1);
+		return ixgbe_desc_unused(rx_ring);
+	}
+
+	fill = max_t(int, target - posted, parked);
+
+	return min_t(int, fill, ixgbe_desc_unused(rx_ring));
+}
+
 static void ixgbe_put_rx_buffer(struct ixgbe_ring *rx_ring,
 				struct ixgbe_rx_buffer *rx_buffer,
 				struct sk_buff *skb)
@@ -2139,7 +2462,8 @@ static void ixgbe_put_rx_buffer(struct ixgbe_ring *rx_ring,
 	dma_set_attr(DMA_ATTR_WEAK_ORDERING, &attrs);
 
 #endif
-	if (ixgbe_can_reuse_rx_page(rx_buffer)) {
+	if (ixgbe_can_reuse_rx_page(rx_buffer) &&
+	    !ixgbe_rx_ring_over_target(rx_ring)) {
 		/* hand second half of page back to the ring */
 		ixgbe_reuse_rx_page(rx_ring, rx_buffer);
 	} else {
@@ -2439,7 +2763,9 @@ static int ixgbe_clean_rx_irq(struct ixgbe_q_vector *q_vector,
 
 		/* return some buffers to hardware, one at a time is too slow */
 		if (cleaned_count >= IXGBE_RX_BUFFER_WRITE) {
-			ixgbe_alloc_rx_buffers(rx_ring, cleaned_count);
+			ixgbe_alloc_rx_buffers(rx_ring,
+					       ixgbe_rx_fill_count(rx_ring,
+								   cleaned_count));
 			cleaned_count = 0;
 		}
 
@@ -3552,6 +3878,65 @@ static void ixgbe_check_overtemp_event(struct ixgbe_adapter *adapter, u32 eicr)
 	e_crit(drv, "%s\n", ixgbe_overheat_msg);
 }
 
+/**
+ * ixgbe_link_timing_start - start timing a link bring-up
+ * @adapter: the ixgbe adapter structure
+ *
+ * Bring-up time is measured from a module event (or link configuration when
+ * there is none) until carrier is turned on, see ixgbe_link_timing_done().
+ **/
+static void ixgbe_link_timing_start(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_link_timing *lt = &adapter->link_timing;
+
+	lt->start = ktime_get();
+	lt->phase_start = lt->start;
+	memset(lt->phase_usecs, 0, sizeof(lt->phase_usecs));
+}
+
+/**
+ * ixgbe_link_phase_end - record the duration of a link bring-up phase
+ * @adapter: the ixgbe adapter structure
+ * @phase: the phase that just completed
+ **/
+static void ixgbe_link_phase_end(struct ixgbe_adapter *adapter,
+				 enum ixgbe_link_phase phase)
+{
+	struct ixgbe_link_timing *lt = &adapter->link_timing;
+	ktime_t now = ktime_get();
+
+	if (!ktime_to_ns(lt->start))
+		return;
+
+	lt->phase_usecs[phase] = (u32)ktime_us_delta(now, lt->phase_start);
+	lt->phase_start = now;
+}
+
+/**
+ * ixgbe_link_timing_done - finish timing of a link bring-up
+ * @adapter: the ixgbe adapter structure
+ *
+ * Called once carrier is turned on.  Bring-ups that were not started by a
+ * module event or link configuration (e.g. link partner flaps) are ignored.
+ **/
+static void ixgbe_link_timing_done(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_link_timing *lt = &adapter->link_timing;
+
+	if (!ktime_to_ns(lt->start))
+		return;
+
+	ixgbe_link_phase_end(adapter, IXGBE_LINK_PHASE_LINK_CONFIG);
+	lt->total_usecs = (u32)ktime_us_delta(lt->phase_start, lt->start);
+	lt->count++;
+	lt->start = ktime_set(0, 0);
+
+	e_dbg(link, "link bring-up %u us (detect %u, setup %u, link %u)\n",
+	      lt->total_usecs, lt->phase_usecs[IXGBE_LINK_PHASE_SFP_DETECT],
+	      lt->phase_usecs[IXGBE_LINK_PHASE_SFP_SETUP],
+	      lt->phase_usecs[IXGBE_LINK_PHASE_LINK_CONFIG]);
+}
+
 static void ixgbe_check_sfp_event(struct ixgbe_adapter *adapter, u32 eicr)
 {
 	struct ixgbe_hw *hw = &adapter->hw;
@@ -3566,6 +3951,7 @@ static void ixgbe_check_sfp_event(struct ixgbe_adapter *adapter, u32 eicr)
 		/* Clear the interrupt */
 		IXGBE_WRITE_REG(hw, IXGBE_EICR, eicr_mask);
 		if (!test_bit(__IXGBE_DOWN, adapter->state)) {
+			ixgbe_link_timing_start(adapter);
 			adapter->flags2 |= IXGBE_FLAG2_SFP_NEEDS_RESET;
 			adapter->sfp_poll_time = 0;
 			ixgbe_service_event_schedule(adapter);
@@ -4494,6 +4880,7 @@ void ixgbe_configure_tx_ring(struct ixgbe_adapter *adapter,
 	}
 
 	clear_bit(__IXGBE_HANG_CHECK_ARMED, &ring->state);
+	clear_bit(__IXGBE_TX_RECOVER_REQUESTED, &ring->state);
 
 	/* reinitialize tx_buffer_info */
 	memset(ring->tx_buffer_info, 0,
@@ -4609,25 +4996,23 @@ static void ixgbe_configure_tx(struct ixgbe_adapter *adapter)
 static void ixgbe_enable_rx_drop(struct ixgbe_adapter *adapter,
 				 struct ixgbe_ring *ring)
 {
-	struct ixgbe_hw *hw = &adapter->hw;
 	u8 reg_idx = ring->reg_idx;
-	u32 srrctl = IXGBE_READ_REG(hw, IXGBE_SRRCTL(reg_idx));
+	u32 srrctl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_SRRCTL, reg_idx);
 
 	srrctl |= IXGBE_SRRCTL_DROP_EN;
 
-	IXGBE_WRITE_REG(hw, IXGBE_SRRCTL(reg_idx), srrctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_SRRCTL, reg_idx, srrctl);
 }
 
 static void ixgbe_disable_rx_drop(struct ixgbe_adapter *adapter,
 				  struct ixgbe_ring *ring)
 {
-	struct ixgbe_hw *hw = &adapter->hw;
 	u8 reg_idx = ring->reg_idx;
-	u32 srrctl = IXGBE_READ_REG(hw, IXGBE_SRRCTL(reg_idx));
+	u32 srrctl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_SRRCTL, reg_idx);
 
 	srrctl &= ~IXGBE_SRRCTL_DROP_EN;
 
-	IXGBE_WRITE_REG(hw, IXGBE_SRRCTL(reg_idx), srrctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_SRRCTL, reg_idx, srrctl);
 }
 
 void ixgbe_set_rx_drop_en(struct ixgbe_adapter *adapter)
@@ -4726,7 +5111,7 @@ static void ixgbe_configure_srrctl(struct ixgbe_adapter *adapter,
 	/* configure descriptor type */
 	srrctl |= IXGBE_SRRCTL_DESCTYPE_ADV_ONEBUF;
 
-	IXGBE_WRITE_REG(hw, IXGBE_SRRCTL(reg_idx), srrctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_SRRCTL, reg_idx, srrctl);
 }
 
 /**
@@ -4755,11 +5140,11 @@ u32 ixgbe_rss_indir_tbl_entries(struct ixgbe_adapter *adapter)
  */
 void ixgbe_store_key(struct ixgbe_adapter *adapter)
 {
-	struct ixgbe_hw *hw = &adapter->hw;
 	int i;
 
 	for (i = 0; i < 10; i++)
-		IXGBE_WRITE_REG(hw, IXGBE_RSSRK(i), adapter->rss_key[i]);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_RSSRK, i,
+				   adapter->rss_key[i]);
 }
 
 /**
@@ -4793,7 +5178,6 @@ static inline int ixgbe_init_rss_key(struct ixgbe_adapter *adapter)
 void ixgbe_store_reta(struct ixgbe_adapter *adapter)
 {
 	u32 i, reta_entries = ixgbe_rss_indir_tbl_entries(adapter);
-	struct ixgbe_hw *hw = &adapter->hw;
 	u32 reta = 0;
 	u32 indices_multi;
 	u8 *indir_tbl = adapter->rss_indir_tbl;
@@ -4813,11 +5197,9 @@ void ixgbe_store_reta(struct ixgbe_adapter *adapter)
 	for (i = 0; i < reta_entries; i++) {
 		reta |= indices_multi * indir_tbl[i] << (i & 0x3) * 8;
 		if ((i & 3) == 3) {
-			if (i < 128)
-				IXGBE_WRITE_REG(hw, IXGBE_RETA(i >> 2), reta);
-			else
-				IXGBE_WRITE_REG(hw, IXGBE_ERETA((i >> 2) - 32),
-						reta);
+			/* RETA and ERETA share one shadow index space */
+			ixgbe_shadow_write(adapter, IXGBE_SHADOW_RETA, i >> 2,
+					   reta);
 			reta = 0;
 		}
 	}
@@ -5000,13 +5382,14 @@ void ixgbe_configure_rscctl(struct ixgbe_adapter *adapter,
 			    struct ixgbe_ring *ring)
 {
 	struct ixgbe_hw *hw = &adapter->hw;
-	u32 rscctrl;
+	u32 rscctrl, maxdesc;
 	u8 reg_idx = ring->reg_idx;
 
 	if (!ring_is_rsc_enabled(ring))
 		return;
 
 	rscctrl = IXGBE_READ_REG(hw, IXGBE_RSCCTL(reg_idx));
+	rscctrl &= ~IXGBE_RSCCTL_MAXDESC_MASK;
 	rscctrl |= IXGBE_RSCCTL_RSCEN;
 	/*
 	 * we must limit the number of descriptors so that the
@@ -5015,22 +5398,42 @@ void ixgbe_configure_rscctl(struct ixgbe_adapter *adapter,
 	 */
 #ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
 #if (MAX_SKB_FRAGS >= 16)
-	rscctrl |= IXGBE_RSCCTL_MAXDESC_16;
+	maxdesc = IXGBE_RSCCTL_MAXDESC_16;
 #elif (MAX_SKB_FRAGS >= 8)
-	rscctrl |= IXGBE_RSCCTL_MAXDESC_8;
+	maxdesc = IXGBE_RSCCTL_MAXDESC_8;
 #elif (MAX_SKB_FRAGS >= 4)
-	rscctrl |= IXGBE_RSCCTL_MAXDESC_4;
+	maxdesc = IXGBE_RSCCTL_MAXDESC_4;
 #else
-	rscctrl |= IXGBE_RSCCTL_MAXDESC_1;
+	maxdesc = IXGBE_RSCCTL_MAXDESC_1;
 #endif
 #else /* CONFIG_IXGBE_DISABLE_PACKET_SPLIT */
 	if (ring->rx_buf_len <= IXGBE_RXBUFFER_4K)
-		rscctrl |= IXGBE_RSCCTL_MAXDESC_16;
+		maxdesc = IXGBE_RSCCTL_MAXDESC_16;
 	else if (ring->rx_buf_len <= IXGBE_RXBUFFER_8K)
-		rscctrl |= IXGBE_RSCCTL_MAXDESC_8;
+		maxdesc = IXGBE_RSCCTL_MAXDESC_8;
 	else
-		rscctrl |= IXGBE_RSCCTL_MAXDESC_4;
+		maxdesc = IXGBE_RSCCTL_MAXDESC_4;
 #endif /* !CONFIG_IXGBE_DISABLE_PACKET_SPLIT */
+
+	/* A configured limit can only shorten aggregations, which closes
+	 * them sooner at the cost of more frames for the stack.  The
+	 * field encodings grow with the descriptor count.
+	 */
+	switch (adapter->rsc_maxdesc[ring->queue_index]) {
+	case 1:
+		maxdesc = IXGBE_RSCCTL_MAXDESC_1;
+		break;
+	case 4:
+		maxdesc = min_t(u32, maxdesc, IXGBE_RSCCTL_MAXDESC_4);
+		break;
+	case 8:
+		maxdesc = min_t(u32, maxdesc, IXGBE_RSCCTL_MAXDESC_8);
+		break;
+	default:
+		break;
+	}
+
+	rscctrl |= maxdesc;
 	IXGBE_WRITE_REG(hw, IXGBE_RSCCTL(reg_idx), rscctrl);
 }
 
@@ -5093,11 +5496,11 @@ void ixgbe_configure_rx_ring(struct ixgbe_adapter *adapter,
 
 #endif
 	/* disable queue to avoid use of these values while updating state */
-	rxdctl = IXGBE_READ_REG(hw, IXGBE_RXDCTL(reg_idx));
+	rxdctl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_RXDCTL, reg_idx);
 	rxdctl &= ~IXGBE_RXDCTL_ENABLE;
 
 	/* write value back with RXDCTL.ENABLE bit cleared */
-	IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(reg_idx), rxdctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, reg_idx, rxdctl);
 	IXGBE_WRITE_FLUSH(hw);
 
 	IXGBE_WRITE_REG(hw, IXGBE_RDBAL(reg_idx), rdba & DMA_BIT_MASK(32));
@@ -5118,6 +5521,8 @@ void ixgbe_configure_rx_ring(struct ixgbe_adapter *adapter,
 #ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
 	ring->next_to_alloc = 0;
 #endif
+	ring->rx_fill_target = ring->count - 1;
+	ring->rx_fill_packets = ring->stats.packets;
 
 	ixgbe_configure_srrctl(adapter, ring);
 	ixgbe_configure_rscctl(adapter, ring);
@@ -5190,7 +5595,7 @@ void ixgbe_configure_rx_ring(struct ixgbe_adapter *adapter,
 
 	/* enable receive descriptor ring */
 	rxdctl |= IXGBE_RXDCTL_ENABLE;
-	IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(reg_idx), rxdctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, reg_idx, rxdctl);
 
 	ixgbe_rx_desc_queue_enable(adapter, ring);
 #ifdef HAVE_AF_XDP_ZC_SUPPORT
@@ -5225,7 +5630,8 @@ static void ixgbe_setup_psrtype(struct ixgbe_adapter *adapter)
 		psrtype |= 1u << 29;
 
 	for (p = 0; p < adapter->num_rx_pools; p++)
-		IXGBE_WRITE_REG(hw, IXGBE_PSRTYPE(VMDQ_P(p)), psrtype);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_PSRTYPE, VMDQ_P(p),
+				   psrtype);
 }
 
 /**
@@ -5324,9 +5730,11 @@ static void ixgbe_configure_virtualization(struct ixgbe_adapter *adapter)
 			/* accept untagged packets until a vlan tag is
 			 * specifically set for the VMDQ queue/pool
 			 */
-			vmolr = IXGBE_READ_REG(hw, IXGBE_VMOLR(pool));
+			vmolr = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR,
+						  pool);
 			vmolr |= IXGBE_VMOLR_AUPE;
-			IXGBE_WRITE_REG(hw, IXGBE_VMOLR(pool), vmolr);
+			ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, pool,
+					   vmolr);
 		}
 
 		vf_shift = VMDQ_P(0) % 32;
@@ -5787,9 +6195,9 @@ void ixgbe_vlan_strip_disable(struct ixgbe_adapter *adapter)
 
 	switch (hw->mac.type) {
 	case ixgbe_mac_82598EB:
-		vlnctrl = IXGBE_READ_REG(hw, IXGBE_VLNCTRL);
+		vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VLNCTRL, 0);
 		vlnctrl &= ~IXGBE_VLNCTRL_VME;
-		IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 		break;
 	case ixgbe_mac_82599EB:
 	case ixgbe_mac_X540:
@@ -5802,9 +6210,11 @@ void ixgbe_vlan_strip_disable(struct ixgbe_adapter *adapter)
 			struct ixgbe_ring *ring = adapter->rx_ring[i];
 
 			j = ring->reg_idx;
-			vlnctrl = IXGBE_READ_REG(hw, IXGBE_RXDCTL(j));
+			vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_RXDCTL,
+						    j);
 			vlnctrl &= ~IXGBE_RXDCTL_VME;
-			IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(j), vlnctrl);
+			ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, j,
+					   vlnctrl);
 		}
 		break;
 	default:
@@ -5825,9 +6235,9 @@ void ixgbe_vlan_strip_enable(struct ixgbe_adapter *adapter)
 
 	switch (hw->mac.type) {
 	case ixgbe_mac_82598EB:
-		vlnctrl = IXGBE_READ_REG(hw, IXGBE_VLNCTRL);
+		vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VLNCTRL, 0);
 		vlnctrl |= IXGBE_VLNCTRL_VME;
-		IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 		break;
 	case ixgbe_mac_82599EB:
 	case ixgbe_mac_X540:
@@ -5840,9 +6250,11 @@ void ixgbe_vlan_strip_enable(struct ixgbe_adapter *adapter)
 			struct ixgbe_ring *ring = adapter->rx_ring[i];
 
 			j = ring->reg_idx;
-			vlnctrl = IXGBE_READ_REG(hw, IXGBE_RXDCTL(j));
+			vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_RXDCTL,
+						    j);
 			vlnctrl |= IXGBE_RXDCTL_VME;
-			IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(j), vlnctrl);
+			ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, j,
+					   vlnctrl);
 		}
 		break;
 	default:
@@ -5856,15 +6268,15 @@ static void ixgbe_vlan_promisc_enable(struct ixgbe_adapter *adapter)
 	struct ixgbe_hw *hw = &adapter->hw;
 	u32 vlnctrl, i;
 
-	vlnctrl = IXGBE_READ_REG(hw, IXGBE_VLNCTRL);
+	vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VLNCTRL, 0);
 
 	if (adapter->flags & IXGBE_FLAG_VMDQ_ENABLED) {
 	/* we need to keep the VLAN filter on in SRIOV */
 		vlnctrl |= IXGBE_VLNCTRL_VFE;
-		IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 	} else {
 		vlnctrl &= ~IXGBE_VLNCTRL_VFE;
-		IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 		return;
 	}
 
@@ -5946,9 +6358,9 @@ static void ixgbe_vlan_promisc_disable(struct ixgbe_adapter *adapter)
 	u32 vlnctrl, i;
 
 	/* configure vlan filtering */
-	vlnctrl = IXGBE_READ_REG(hw, IXGBE_VLNCTRL);
+	vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VLNCTRL, 0);
 	vlnctrl |= IXGBE_VLNCTRL_VFE;
-	IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 
 	if (!(adapter->flags & IXGBE_FLAG_VMDQ_ENABLED) ||
 	    hw->mac.type == ixgbe_mac_82598EB)
@@ -6058,6 +6470,45 @@ static void ixgbe_restore_vlan(struct ixgbe_adapter *adapter)
 }
 
 #endif
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+/**
+ * ixgbe_configure_dvlan - set up 802.1ad double VLAN parsing
+ * @adapter: board private structure
+ *
+ * With rx-vlan-stag-hw-parse on, the MAC expects an outer S-tag on every
+ * frame and parses past it, so RSS and checksum offload work on the inner
+ * headers of QinQ traffic.
+ **/
+static void ixgbe_configure_dvlan(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 ctrl_ext, dmatxctl, exvet;
+
+	if (hw->mac.type < ixgbe_mac_X550)
+		return;
+
+	ctrl_ext = IXGBE_READ_REG(hw, IXGBE_CTRL_EXT);
+	dmatxctl = IXGBE_READ_REG(hw, IXGBE_DMATXCTL);
+
+	if (adapter->netdev->features & NETIF_F_HW_VLAN_STAG_RX) {
+		exvet = IXGBE_READ_REG(hw, IXGBE_EXVET);
+		exvet &= ~IXGBE_EXVET_VET_EXT_MASK;
+		exvet |= ETH_P_8021AD << IXGBE_EXVET_VET_EXT_SHIFT;
+		IXGBE_WRITE_REG(hw, IXGBE_EXVET, exvet);
+
+		ctrl_ext |= IXGBE_CTRL_EXT_EXTENDED_VLAN;
+		dmatxctl |= IXGBE_DMATXCTL_GDV;
+	} else {
+		ctrl_ext &= ~IXGBE_CTRL_EXT_EXTENDED_VLAN;
+		dmatxctl &= ~IXGBE_DMATXCTL_GDV;
+	}
+
+	IXGBE_WRITE_REG(hw, IXGBE_CTRL_EXT, ctrl_ext);
+	IXGBE_WRITE_REG(hw, IXGBE_DMATXCTL, dmatxctl);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
 static u8 *ixgbe_addr_list_itr(struct ixgbe_hw __maybe_unused *hw, u8 **mc_addr_ptr, u32 *vmdq)
 {
 #ifdef NETDEV_HW_ADDR_T_MULTICAST
@@ -6348,7 +6799,7 @@ void ixgbe_set_rx_mode(struct net_device *netdev)
 	/* Check for Promiscuous and All Multicast modes */
 	fctrl = IXGBE_READ_REG(hw, IXGBE_FCTRL);
 #if defined(HAVE_VLAN_RX_REGISTER)
-	vlnctrl = IXGBE_READ_REG(hw, IXGBE_VLNCTRL);
+	vlnctrl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VLNCTRL, 0);
 #endif
 
 	/* set all bits that we expect to always be set */
@@ -6418,10 +6869,12 @@ void ixgbe_set_rx_mode(struct net_device *netdev)
 	}
 
 	if (hw->mac.type != ixgbe_mac_82598EB) {
-		vmolr |= IXGBE_READ_REG(hw, IXGBE_VMOLR(VMDQ_P(0))) &
+		vmolr |= ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR,
+					   VMDQ_P(0)) &
 			 ~(IXGBE_VMOLR_MPE | IXGBE_VMOLR_ROMPE |
 			   IXGBE_VMOLR_ROPE);
-		IXGBE_WRITE_REG(hw, IXGBE_VMOLR(VMDQ_P(0)), vmolr);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, VMDQ_P(0),
+				   vmolr);
 	}
 
 	IXGBE_WRITE_REG(hw, IXGBE_FCTRL, fctrl);
@@ -6448,7 +6901,7 @@ void ixgbe_set_rx_mode(struct net_device *netdev)
 	else
 		ixgbe_vlan_promisc_enable(adapter);
 #elif defined(HAVE_VLAN_RX_REGISTER)
-	IXGBE_WRITE_REG(hw, IXGBE_VLNCTRL, vlnctrl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_VLNCTRL, 0, vlnctrl);
 #endif /* NETIF_F_HW_VLAN_CTAG_FILTER */
 }
 
@@ -7020,6 +7473,136 @@ static void ixgbe_fdir_filter_restore(struct ixgbe_adapter *adapter)
 	spin_unlock(&adapter->fdir_perfect_lock);
 }
 
+/**
+ * ixgbe_etype_filter_reserved - ETQF slots owned by driver features
+ * @adapter: board private structure
+ *
+ * Returns a bitmap of the slots handed to a fixed consumer in ixgbe_type.h
+ * when that consumer can be active on this adapter. All other slots are
+ * free for ethtool ether-proto rules.
+ **/
+u8 ixgbe_etype_filter_reserved(struct ixgbe_adapter *adapter)
+{
+	u8 reserved = 0;
+
+#ifndef IXGBE_NO_LLI
+	/* the LLIEType module parameter programs slot 0 directly */
+	if (adapter->lli_etype)
+		reserved |= BIT(IXGBE_ETQF_FILTER_EAPOL);
+#endif /* IXGBE_NO_LLI */
+#if IS_ENABLED(CONFIG_FCOE)
+	if (adapter->flags & IXGBE_FLAG_FCOE_CAPABLE)
+		reserved |= BIT(IXGBE_ETQF_FILTER_FCOE) |
+			    BIT(IXGBE_ETQF_FILTER_FIP);
+#endif /* CONFIG_FCOE */
+#ifdef HAVE_PTP_1588_CLOCK
+	reserved |= BIT(IXGBE_ETQF_FILTER_1588);
+#endif /* HAVE_PTP_1588_CLOCK */
+	/* VF EtherType anti-spoofing */
+	if (adapter->hw.mac.ops.set_ethertype_anti_spoofing)
+		reserved |= BIT(IXGBE_ETQF_FILTER_LLDP) |
+			    BIT(IXGBE_ETQF_FILTER_FC);
+
+	return reserved;
+}
+
+/**
+ * ixgbe_etype_filter_owned - check if a driver feature filters an EtherType
+ * @adapter: board private structure
+ * @etype: EtherType in host byte order
+ *
+ * Returns true if one of the slots from ixgbe_etype_filter_reserved()
+ * already matches @etype, in which case an ethtool rule for it would
+ * conflict with the feature owning that slot.
+ **/
+bool ixgbe_etype_filter_owned(struct ixgbe_adapter *adapter, u16 etype)
+{
+	u8 reserved = ixgbe_etype_filter_reserved(adapter);
+	u32 owned;
+	int i;
+
+	for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++) {
+		if (!(reserved & BIT(i)))
+			continue;
+
+		switch (i) {
+#ifndef IXGBE_NO_LLI
+		case IXGBE_ETQF_FILTER_EAPOL:
+			owned = adapter->lli_etype;
+			break;
+#endif /* IXGBE_NO_LLI */
+		case IXGBE_ETQF_FILTER_FCOE:
+			owned = ETH_P_FCOE;
+			break;
+		case IXGBE_ETQF_FILTER_FIP:
+			owned = ETH_P_FIP;
+			break;
+		case IXGBE_ETQF_FILTER_1588:
+			owned = ETH_P_1588;
+			break;
+		case IXGBE_ETQF_FILTER_LLDP:
+			owned = IXGBE_ETH_P_LLDP;
+			break;
+		case IXGBE_ETQF_FILTER_FC:
+			owned = ETH_P_PAUSE;
+			break;
+		default:
+			continue;
+		}
+
+		if (owned == etype)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * ixgbe_etype_filter_write - program one ETQF/ETQS slot
+ * @adapter: board private structure
+ * @idx: ETQF slot to program from adapter->etype_filter
+ **/
+void ixgbe_etype_filter_write(struct ixgbe_adapter *adapter, int idx)
+{
+	struct ixgbe_etype_filter *filter = &adapter->etype_filter[idx];
+	struct ixgbe_hw *hw = &adapter->hw;
+	u32 etqs = 0;
+
+	if (!filter->used) {
+		IXGBE_WRITE_REG(hw, IXGBE_ETQF(idx), 0);
+		IXGBE_WRITE_REG(hw, IXGBE_ETQS(idx), 0);
+		IXGBE_WRITE_FLUSH(hw);
+		return;
+	}
+
+	/* the ring may be gone after the queue count was reduced */
+	if (filter->ring < adapter->num_rx_queues) {
+		etqs |= IXGBE_ETQS_QUEUE_EN;
+		etqs |= (adapter->rx_ring[filter->ring]->reg_idx <<
+			 IXGBE_ETQS_RX_QUEUE_SHIFT) & IXGBE_ETQS_RX_QUEUE;
+	}
+	if (filter->lli)
+		etqs |= IXGBE_ETQS_LLI;
+
+	IXGBE_WRITE_REG(hw, IXGBE_ETQS(idx), etqs);
+	IXGBE_WRITE_REG(hw, IXGBE_ETQF(idx),
+			filter->etype | IXGBE_ETQF_FILTER_EN);
+	IXGBE_WRITE_FLUSH(hw);
+}
+
+static void ixgbe_etype_filter_restore(struct ixgbe_adapter *adapter)
+{
+	int i;
+
+	spin_lock(&adapter->fdir_perfect_lock);
+
+	for (i = 0; i < IXGBE_MAX_ETQF_FILTERS; i++)
+		if (adapter->etype_filter[i].used)
+			ixgbe_etype_filter_write(adapter, i);
+
+	spin_unlock(&adapter->fdir_perfect_lock);
+}
+
 /**
  * ixgbe_clean_rx_ring - Free Rx Buffers per Queue
  * @rx_ring: ring to free buffers from
@@ -7141,6 +7724,9 @@ static void ixgbe_configure(struct ixgbe_adapter *adapter)
 #if defined(NETIF_F_HW_VLAN_TX) || defined(NETIF_F_HW_VLAN_CTAG_TX)
 	ixgbe_restore_vlan(adapter);
 #endif
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	ixgbe_configure_dvlan(adapter);
+#endif
 
 	if (adapter->hw.mac.type == ixgbe_mac_82599EB ||
 	    adapter->hw.mac.type == ixgbe_mac_X540)
@@ -7155,6 +7741,9 @@ static void ixgbe_configure(struct ixgbe_adapter *adapter)
 		ixgbe_fdir_filter_restore(adapter);
 	}
 
+	if (adapter->etype_filter_count)
+		ixgbe_etype_filter_restore(adapter);
+
 	if (adapter->hw.mac.type == ixgbe_mac_82599EB ||
 	    adapter->hw.mac.type == ixgbe_mac_X540)
 		hw->mac.ops.enable_sec_rx_path(hw);
@@ -7178,6 +7767,15 @@ static void ixgbe_configure(struct ixgbe_adapter *adapter)
 	ixgbe_configure_fcoe(adapter);
 #endif /* CONFIG_FCOE */
 
+#ifdef HAVE_IXGBE_IPSEC
+	/* reprogram the SA tables lost across reset */
+	ixgbe_ipsec_restore(adapter);
+#endif /* HAVE_IXGBE_IPSEC */
+#ifdef HAVE_IXGBE_MACSEC
+	/* reload keys, SCIs and saved PNs into the LinkSec block */
+	ixgbe_macsec_restore(adapter);
+#endif /* HAVE_IXGBE_MACSEC */
+
 	ixgbe_configure_tx(adapter);
 	ixgbe_configure_rx(adapter);
 }
@@ -7469,9 +8067,159 @@ static void ixgbe_setup_gpie(struct ixgbe_adapter *adapter)
 	IXGBE_WRITE_REG(hw, IXGBE_GPIE, gpie);
 }
 
-static void ixgbe_up_complete(struct ixgbe_adapter *adapter)
-{
-	struct ixgbe_hw *hw = &adapter->hw;
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+/**
+ * ixgbe_fwd_ring_up - steer a VMDq pool to an offloaded macvlan
+ * @adapter: board private structure
+ * @accel: offloaded macvlan and the pool it owns
+ *
+ * Binds the pool's Tx queues to the macvlan as a subordinate channel,
+ * points the pool's Rx rings at it and adds its MAC address to the RAR
+ * table for the pool.
+ *
+ * Returns 0 on success, negative value on failure
+ **/
+static int ixgbe_fwd_ring_up(struct ixgbe_adapter *adapter,
+			     struct ixgbe_fwd_adapter *accel)
+{
+	struct net_device *vdev = accel->netdev;
+	int per_pool = adapter->num_rx_queues_per_pool;
+	int i, baseq, err;
+
+	/* the pool may have been lost to a queue layout change */
+	if (!(adapter->flags2 & IXGBE_FLAG2_FWD_POOLS) ||
+	    accel->pool >= adapter->num_rx_pools)
+		return -ENOSPC;
+
+#ifdef HAVE_XDP_SUPPORT
+	if (READ_ONCE(adapter->xdp_prog))
+		return -EOPNOTSUPP;
+
+#endif /* HAVE_XDP_SUPPORT */
+	baseq = accel->pool * per_pool;
+	netdev_dbg(vdev, "pool %d:%d queues %d:%d\n",
+		   accel->pool, adapter->num_rx_pools,
+		   baseq, baseq + per_pool);
+
+	accel->rx_base_queue = baseq;
+	accel->tx_base_queue = baseq;
+
+	err = netdev_bind_sb_channel_queue(adapter->netdev, vdev, 0,
+					   per_pool, baseq);
+	if (err)
+		return err;
+
+	for (i = 0; i < per_pool; i++)
+		adapter->rx_ring[baseq + i]->netdev = vdev;
+
+	/* Guarantee all rings are updated before we update the
+	 * MAC address filter.
+	 */
+	wmb();
+
+	/* a reset flushes the RAR table, but a plain down/up does not */
+	ixgbe_del_mac_filter(adapter, vdev->dev_addr, VMDQ_P(accel->pool));
+	err = ixgbe_add_mac_filter(adapter, vdev->dev_addr,
+				   VMDQ_P(accel->pool));
+	if (err >= 0)
+		return 0;
+
+	for (i = 0; i < per_pool; i++)
+		adapter->rx_ring[baseq + i]->netdev = adapter->netdev;
+	netdev_unbind_sb_channel(adapter->netdev, vdev);
+
+	return err;
+}
+
+/**
+ * ixgbe_fwd_release - hand an offloaded macvlan's pool back to the PF
+ * @adapter: board private structure
+ * @accel: offloaded macvlan and the pool it owns
+ *
+ * Frees @accel; the caller is responsible for the macvlan side.
+ **/
+static void ixgbe_fwd_release(struct ixgbe_adapter *adapter,
+			      struct ixgbe_fwd_adapter *accel)
+{
+	struct net_device *vdev = accel->netdev;
+	int i;
+
+	ixgbe_del_mac_filter(adapter, vdev->dev_addr, VMDQ_P(accel->pool));
+
+	/* let frames already in the Rx FIFO drain to the macvlan before
+	 * its rings are handed back
+	 */
+	if (!test_bit(__IXGBE_DOWN, adapter->state))
+		usleep_range(10000, 20000);
+
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		struct ixgbe_ring *ring = adapter->rx_ring[i];
+
+		if (!ring || ring->netdev != vdev)
+			continue;
+
+		if (!test_bit(__IXGBE_DOWN, adapter->state))
+			napi_synchronize(&ring->q_vector->napi);
+		ring->netdev = adapter->netdev;
+	}
+
+	/* unbind the queues and drop the subordinate channel config */
+	netdev_unbind_sb_channel(adapter->netdev, vdev);
+	netdev_set_sb_channel(vdev, 0);
+
+	adapter->fwd_priv[accel->pool] = NULL;
+	kfree(accel);
+}
+
+/**
+ * ixgbe_configure_dfwd - restore the pools of offloaded macvlans
+ * @adapter: board private structure
+ *
+ * The RAR table is flushed on reset and the rings may have been
+ * reallocated since the macvlans were offloaded.  A macvlan whose pool
+ * cannot be restored falls back to the software path.
+ **/
+static void ixgbe_configure_dfwd(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_fwd_adapter *accel;
+	int pool;
+
+	for (pool = 1; pool <= IXGBE_MAX_MACVLANS; pool++) {
+		accel = adapter->fwd_priv[pool];
+		if (!accel || !ixgbe_fwd_ring_up(adapter, accel))
+			continue;
+
+		netdev_err(accel->netdev,
+			   "L2FW offload disabled, pool %d is no longer available\n",
+			   pool);
+		macvlan_release_l2fw_offload(accel->netdev);
+		ixgbe_fwd_release(adapter, accel);
+	}
+}
+
+/**
+ * ixgbe_fwd_release_all - move every offloaded macvlan back to software
+ * @adapter: board private structure
+ **/
+static void ixgbe_fwd_release_all(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_fwd_adapter *accel;
+	int pool;
+
+	for (pool = 1; pool <= IXGBE_MAX_MACVLANS; pool++) {
+		accel = adapter->fwd_priv[pool];
+		if (!accel)
+			continue;
+
+		macvlan_release_l2fw_offload(accel->netdev);
+		ixgbe_fwd_release(adapter, accel);
+	}
+}
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
+static void ixgbe_up_complete(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
 	int err;
 	u32 ctrl_ext;
 
@@ -7488,6 +8236,12 @@ static void ixgbe_up_complete(struct ixgbe_adapter *adapter)
 		hw->mac.ops.enable_tx_laser(hw);
 	ixgbe_set_phy_power(hw, true);
 
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+	/* rings still quiesced, so pools can be handed back safely */
+	ixgbe_configure_dfwd(adapter);
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
+	adapter->rx_fill_review = jiffies;
 	smp_mb__before_atomic();
 	clear_bit(__IXGBE_DOWN, adapter->state);
 	ixgbe_napi_enable_all(adapter);
@@ -7626,12 +8380,14 @@ void ixgbe_disable_rx_queue(struct ixgbe_adapter *adapter)
 		struct ixgbe_ring *ring = adapter->rx_ring[i];
 		u8 reg_idx = ring->reg_idx;
 
-		rxdctl = IXGBE_READ_REG(hw, IXGBE_RXDCTL(reg_idx));
+		rxdctl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_RXDCTL,
+					   reg_idx);
 		rxdctl &= ~IXGBE_RXDCTL_ENABLE;
 		rxdctl |= IXGBE_RXDCTL_SWFLSH;
 
 		/* write value back with RXDCTL.ENABLE bit cleared */
-		IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(reg_idx), rxdctl);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, reg_idx,
+				   rxdctl);
 	}
 
 	/* RXDCTL.EN may not change on 82598 if link is down, so skip it */
@@ -7680,6 +8436,45 @@ void ixgbe_disable_rx_queue(struct ixgbe_adapter *adapter)
 	      "RXDCTL.ENABLE for one or more queues not cleared within the polling period\n");
 }
 
+/**
+ * ixgbe_disable_txr_hw - disable a single Tx queue in hardware
+ * @adapter: board private structure
+ * @tx_ring: ring to disable
+ *
+ * Returns true once the queue reports itself disabled, false if it did not
+ * stop within the polling period.
+ **/
+static bool ixgbe_disable_txr_hw(struct ixgbe_adapter *adapter,
+				 struct ixgbe_ring *tx_ring)
+{
+	unsigned long wait_delay, delay_interval;
+	struct ixgbe_hw *hw = &adapter->hw;
+	u8 reg_idx = tx_ring->reg_idx;
+	int wait_loop;
+	u32 txdctl;
+
+	IXGBE_WRITE_REG(hw, IXGBE_TXDCTL(reg_idx), IXGBE_TXDCTL_SWFLSH);
+
+	/* delay mechanism from ixgbe_disable_tx */
+	delay_interval = ixgbe_get_completion_timeout(adapter) / 100;
+
+	wait_loop = IXGBE_MAX_RX_DESC_POLL;
+	wait_delay = delay_interval;
+
+	while (wait_loop--) {
+		usleep_range(wait_delay, wait_delay + 10);
+		wait_delay += delay_interval * 2;
+		txdctl = IXGBE_READ_REG(hw, IXGBE_TXDCTL(reg_idx));
+
+		if (!(txdctl & IXGBE_TXDCTL_ENABLE))
+			return true;
+	}
+
+	e_err(drv, "TXDCTL.ENABLE not cleared within the polling period\n");
+
+	return false;
+}
+
 void ixgbe_disable_tx_queue(struct ixgbe_adapter *adapter)
 {
 	unsigned long wait_delay, delay_interval;
@@ -7841,6 +8636,9 @@ void ixgbe_fwlog_realloc_rings(struct ixgbe_hw *hw, int ring_size)
 	struct device *dev = ixgbe_pf_to_dev(adapter);
 	int status;
 
+	/* serializes against the debugfs memory accounting */
+	ASSERT_RTNL();
+
 	if (ring_size == hw->fwlog_ring.size)
 		return;
 
@@ -8072,7 +8870,13 @@ void ixgbe_reset(struct ixgbe_adapter *adapter)
 	adapter->flags2 &= ~(IXGBE_FLAG2_SEARCH_FOR_SFP |
 			     IXGBE_FLAG2_SFP_NEEDS_RESET);
 	adapter->flags &= ~IXGBE_FLAG_NEED_LINK_CONFIG;
+	adapter->msf_state = IXGBE_MSF_IDLE;
 
+#ifdef HAVE_IXGBE_MACSEC
+	/* the PN registers are lost in reset, keep them for the restore */
+	ixgbe_macsec_save_pn(adapter);
+#endif /* HAVE_IXGBE_MACSEC */
+	ixgbe_reg_shadow_invalidate(adapter);
 	err = hw->mac.ops.init_hw(hw);
 	switch (err) {
 	case IXGBE_SUCCESS:
@@ -8291,6 +9095,13 @@ void ixgbe_down(struct ixgbe_adapter *adapter)
 	adapter->flags &= ~IXGBE_FLAG_NEED_LINK_UPDATE;
 
 	del_timer_sync(&adapter->service_timer);
+	adapter->msf_state = IXGBE_MSF_IDLE;
+	hrtimer_cancel(&adapter->msf_timer);
+#ifdef ETHTOOL_GMODULEINFO
+	/* the module may be swapped while we are not watching SDP events */
+	cancel_delayed_work_sync(&adapter->module_task);
+	ixgbe_module_cache_invalidate(adapter);
+#endif
 
 	if (adapter->num_vfs) {
 		/* Clear EITR Select mapping */
@@ -8578,6 +9389,8 @@ static int ixgbe_sw_init(struct ixgbe_adapter *adapter)
 	/* n-tuple support exists, always init our spinlock */
 	spin_lock_init(&adapter->fdir_perfect_lock);
 
+	spin_lock_init(&adapter->reg_shadow.lock);
+
 #if IS_ENABLED(CONFIG_DCB)
 	switch (hw->mac.type) {
 	case ixgbe_mac_82598EB:
@@ -8991,54 +9804,42 @@ static int ixgbe_change_mtu(struct net_device *netdev, int new_mtu)
 }
 
 /**
- * ixgbe_open - Called when a network interface is made active
- * @netdev: network interface device structure
+ * __ixgbe_open - bring up an interface whose rings are already allocated
+ * @adapter: board private structure
  *
- * Returns 0 on success, negative value on failure
+ * Programs the hardware, requests interrupts and starts the queues.  The
+ * caller owns the Tx/Rx descriptor rings and must release them on failure.
  *
- * The open entry point is called when a network interface is made
- * active by the system (IFF_UP).  At this point all resources needed
- * for transmit and receive operations are allocated, the interrupt
- * handler is registered with the OS, the watchdog timer is started,
- * and the stack is notified that the interface is ready.
+ * Returns 0 on success, negative value on failure
  **/
-int ixgbe_open(struct net_device *netdev)
+static int __ixgbe_open(struct ixgbe_adapter *adapter)
 {
-	struct ixgbe_adapter *adapter = netdev_priv(netdev);
+	struct net_device *netdev = adapter->netdev;
+	unsigned int tx_queues = adapter->num_tx_queues;
+	unsigned int rx_queues = adapter->num_rx_queues;
 	int err;
 
-	/* disallow open during test */
-	if (test_bit(__IXGBE_TESTING, adapter->state))
-		return -EBUSY;
-
-	netif_carrier_off(netdev);
-
-	/* allocate transmit descriptors */
-	err = ixgbe_setup_all_tx_resources(adapter);
-	if (err)
-		goto err_setup_tx;
-
-	/* allocate receive descriptors */
-	err = ixgbe_setup_all_rx_resources(adapter);
-	if (err)
-		goto err_setup_rx;
-
 	ixgbe_configure(adapter);
 
 	err = ixgbe_request_irq(adapter);
 	if (err)
 		goto err_req_irq;
 
+	/* With VMDq the PF only uses pool 0, unless TC 0 fences it there so
+	 * the other pools can carry offloaded macvlans.
+	 */
+	if (adapter->num_rx_pools > 1 &&
+	    !(adapter->flags2 & IXGBE_FLAG2_FWD_POOLS)) {
+		tx_queues = 1;
+		rx_queues = 1;
+	}
+
 	/* Notify the stack of the actual queue counts. */
-	err = netif_set_real_num_tx_queues(netdev,
-					   adapter->num_rx_pools > 1 ? 1 :
-					   adapter->num_tx_queues);
+	err = netif_set_real_num_tx_queues(netdev, tx_queues);
 	if (err)
 		goto err_set_queues;
 
-	err = netif_set_real_num_rx_queues(netdev,
-					   adapter->num_rx_pools > 1 ? 1 :
-					   adapter->num_rx_queues);
+	err = netif_set_real_num_rx_queues(netdev, rx_queues);
 	if (err)
 		goto err_set_queues;
 
@@ -9077,6 +9878,49 @@ out:
 err_set_queues:
 	ixgbe_free_irq(adapter);
 err_req_irq:
+	return err;
+}
+
+/**
+ * ixgbe_open - Called when a network interface is made active
+ * @netdev: network interface device structure
+ *
+ * Returns 0 on success, negative value on failure
+ *
+ * The open entry point is called when a network interface is made
+ * active by the system (IFF_UP).  At this point all resources needed
+ * for transmit and receive operations are allocated, the interrupt
+ * handler is registered with the OS, the watchdog timer is started,
+ * and the stack is notified that the interface is ready.
+ **/
+int ixgbe_open(struct net_device *netdev)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(netdev);
+	int err;
+
+	/* disallow open during test */
+	if (test_bit(__IXGBE_TESTING, adapter->state))
+		return -EBUSY;
+
+	netif_carrier_off(netdev);
+
+	/* allocate transmit descriptors */
+	err = ixgbe_setup_all_tx_resources(adapter);
+	if (err)
+		goto err_setup_tx;
+
+	/* allocate receive descriptors */
+	err = ixgbe_setup_all_rx_resources(adapter);
+	if (err)
+		goto err_setup_rx;
+
+	err = __ixgbe_open(adapter);
+	if (err)
+		goto err_open;
+
+	return IXGBE_SUCCESS;
+
+err_open:
 	ixgbe_free_all_rx_resources(adapter);
 	if (!adapter->wol)
 		ixgbe_set_phy_power(&adapter->hw, false);
@@ -9089,13 +9933,13 @@ err_setup_tx:
 }
 
 /**
- * ixgbe_close_suspend - actions necessary to both suspend and close flows
+ * ixgbe_quiesce - stop the device and release its interrupts
  * @adapter: the private adapter struct
  *
- * This function should contain the necessary work common to both suspending
- * and closing of the device.
+ * Stops all DMA and releases the IRQ lines, leaving the descriptor rings
+ * allocated so that they can either be freed or reused on resume.
  */
-static void ixgbe_close_suspend(struct ixgbe_adapter *adapter)
+static void ixgbe_quiesce(struct ixgbe_adapter *adapter)
 {
 #ifdef HAVE_PTP_1588_CLOCK
 	ixgbe_ptp_suspend(adapter);
@@ -9110,6 +9954,18 @@ static void ixgbe_close_suspend(struct ixgbe_adapter *adapter)
 		ixgbe_down(adapter);
 	}
 	ixgbe_free_irq(adapter);
+}
+
+/**
+ * ixgbe_close_suspend - actions necessary to both suspend and close flows
+ * @adapter: the private adapter struct
+ *
+ * This function should contain the necessary work common to both suspending
+ * and closing of the device.
+ */
+static void ixgbe_close_suspend(struct ixgbe_adapter *adapter)
+{
+	ixgbe_quiesce(adapter);
 
 	ixgbe_free_all_rx_resources(adapter);
 	ixgbe_free_all_tx_resources(adapter);
@@ -9186,9 +10042,25 @@ static int ixgbe_resume(struct pci_dev *pdev)
 
 	rtnl_lock();
 
-	err = ixgbe_init_interrupt_scheme(adapter);
-	if (!err && netif_running(netdev))
-		err = ixgbe_open(netdev);
+	if (adapter->flags2 & IXGBE_FLAG2_RINGS_RETAINED) {
+		/* q_vectors, MSI-X vectors and descriptor rings survived
+		 * suspend, only the register state needs to be rebuilt
+		 */
+		adapter->flags2 &= ~IXGBE_FLAG2_RINGS_RETAINED;
+		if (netif_running(netdev)) {
+			netif_carrier_off(netdev);
+			err = __ixgbe_open(adapter);
+			if (err) {
+				ixgbe_free_all_rx_resources(adapter);
+				ixgbe_free_all_tx_resources(adapter);
+				ixgbe_reset(adapter);
+			}
+		}
+	} else {
+		err = ixgbe_init_interrupt_scheme(adapter);
+		if (!err && netif_running(netdev))
+			err = ixgbe_open(netdev);
+	}
 
 
 	if (!err)
@@ -9269,7 +10141,17 @@ static int ixgbe_thaw(struct device *dev)
  * warning/error, because it is defined and not used.
  */
 #if defined(CONFIG_PM) || !defined(USE_REBOOT_NOTIFIER)
-static int __ixgbe_shutdown(struct pci_dev *pdev, bool *enable_wake)
+/**
+ * __ixgbe_shutdown - common suspend and power off handling
+ * @pdev: PCI device information struct
+ * @enable_wake: returns whether the device should wake the system
+ * @retain_rings: keep interrupt vectors and descriptor rings allocated
+ *
+ * When @retain_rings is set the device keeps its host memory across the
+ * power transition and ixgbe_resume() only has to reprogram the hardware.
+ **/
+static int __ixgbe_shutdown(struct pci_dev *pdev, bool *enable_wake,
+			    bool retain_rings)
 {
 	struct ixgbe_adapter *adapter = pci_get_drvdata(pdev);
 	struct net_device *netdev = adapter->netdev;
@@ -9283,10 +10165,15 @@ static int __ixgbe_shutdown(struct pci_dev *pdev, bool *enable_wake)
 	rtnl_lock();
 	netif_device_detach(netdev);
 
-	if (netif_running(netdev))
-		ixgbe_close_suspend(adapter);
-
-	ixgbe_clear_interrupt_scheme(adapter);
+	if (retain_rings) {
+		if (netif_running(netdev))
+			ixgbe_quiesce(adapter);
+		adapter->flags2 |= IXGBE_FLAG2_RINGS_RETAINED;
+	} else {
+		if (netif_running(netdev))
+			ixgbe_close_suspend(adapter);
+		ixgbe_clear_interrupt_scheme(adapter);
+	}
 	rtnl_unlock();
 
 #ifdef CONFIG_PM
@@ -9368,7 +10255,7 @@ static int ixgbe_suspend(struct pci_dev *pdev,
 	struct pci_dev *pdev = to_pci_dev(dev);
 #endif
 
-	retval = __ixgbe_shutdown(pdev, &wake);
+	retval = __ixgbe_shutdown(pdev, &wake, true);
 	if (retval)
 		return retval;
 
@@ -9388,7 +10275,7 @@ static void ixgbe_shutdown(struct pci_dev *pdev)
 {
 	bool wake;
 
-	__ixgbe_shutdown(pdev, &wake);
+	__ixgbe_shutdown(pdev, &wake, false);
 
 	if (system_state == SYSTEM_POWER_OFF) {
 		pci_wake_from_d3(pdev, wake);
@@ -9544,14 +10431,22 @@ void ixgbe_update_stats(struct ixgbe_adapter *adapter)
 		return;
 
 	if (adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED) {
+		u64 rsc_hist[IXGBE_RSC_HIST_BUCKETS] = { 0 };
 		u64 rsc_count = 0;
 		u64 rsc_flush = 0;
+		int j;
+
 		for (i = 0; i < adapter->num_rx_queues; i++) {
-			rsc_count += adapter->rx_ring[i]->rx_stats.rsc_count;
-			rsc_flush += adapter->rx_ring[i]->rx_stats.rsc_flush;
+			struct ixgbe_ring *rx_ring = adapter->rx_ring[i];
+
+			rsc_count += rx_ring->rx_stats.rsc_count;
+			rsc_flush += rx_ring->rx_stats.rsc_flush;
+			for (j = 0; j < IXGBE_RSC_HIST_BUCKETS; j++)
+				rsc_hist[j] += rx_ring->rx_stats.rsc_hist[j];
 		}
 		adapter->rsc_total_count = rsc_count;
 		adapter->rsc_total_flush = rsc_flush;
+		memcpy(adapter->rsc_total_hist, rsc_hist, sizeof(rsc_hist));
 	}
 
 	for (i = 0; i < adapter->num_rx_queues; i++) {
@@ -9716,6 +10611,9 @@ void ixgbe_update_stats(struct ixgbe_adapter *adapter)
 	default:
 		break;
 	}
+#ifdef HAVE_IXGBE_MACSEC
+	ixgbe_macsec_update_stats(adapter);
+#endif /* HAVE_IXGBE_MACSEC */
 	bprc = IXGBE_READ_REG(hw, IXGBE_BPRC);
 	hwstats->bprc += bprc;
 	hwstats->mprc += IXGBE_READ_REG(hw, IXGBE_MPRC);
@@ -10071,6 +10969,7 @@ static void ixgbe_watchdog_link_is_up(struct ixgbe_adapter *adapter)
 	       (flow_tx ? "TX" : "None"))));
 
 	netif_carrier_on(netdev);
+	ixgbe_link_timing_done(adapter);
 #ifdef IFLA_VF_MAX
 	ixgbe_check_vf_rate_limit(adapter);
 #endif /* IFLA_VF_MAX */
@@ -10318,16 +11217,288 @@ static void ixgbe_watchdog_subtask(struct ixgbe_adapter *adapter)
 	if (adapter->link_up)
 		ixgbe_watchdog_link_is_up(adapter);
 	else
-		ixgbe_watchdog_link_is_down(adapter);
-#ifdef CONFIG_PCI_IOV
-	ixgbe_spoof_check(adapter);
-	ixgbe_check_for_bad_vf(adapter);
-#endif /* CONFIG_PCI_IOV */
-	ixgbe_update_stats(adapter);
+		ixgbe_watchdog_link_is_down(adapter);
+#ifdef CONFIG_PCI_IOV
+	ixgbe_spoof_check(adapter);
+	ixgbe_check_for_bad_vf(adapter);
+#endif /* CONFIG_PCI_IOV */
+	ixgbe_update_stats(adapter);
+
+	ixgbe_watchdog_flush_tx(adapter);
+}
+
+/**
+ * ixgbe_msf_timer - hrtimer callback for multispeed fiber link bring-up
+ * @timer: pointer to the msf_timer
+ **/
+static enum hrtimer_restart ixgbe_msf_timer(struct hrtimer *timer)
+{
+	struct ixgbe_adapter *adapter = container_of(timer,
+						     struct ixgbe_adapter,
+						     msf_timer);
+
+	/* the service task is already running and would miss this event,
+	 * check back once it had a chance to complete
+	 */
+	if (test_bit(__IXGBE_SERVICE_SCHED, adapter->state)) {
+		hrtimer_forward_now(timer,
+				    ns_to_ktime(IXGBE_MSF_POLL_USECS *
+						NSEC_PER_USEC));
+		return HRTIMER_RESTART;
+	}
+
+	ixgbe_service_event_schedule(adapter);
+
+	return HRTIMER_NORESTART;
+}
+
+static void ixgbe_msf_arm(struct ixgbe_adapter *adapter, s64 usecs)
+{
+	hrtimer_start(&adapter->msf_timer, ns_to_ktime(usecs * NSEC_PER_USEC),
+		      HRTIMER_MODE_REL);
+}
+
+/**
+ * ixgbe_msf_try_next - start trying the next multispeed fiber link speed
+ * @adapter: the ixgbe adapter structure
+ *
+ * Speeds are tried highest first.  Once every speed failed, the link is
+ * configured back to the highest speed requested and the state machine
+ * goes idle; the watchdog picks up the link whenever the partner comes up.
+ * Must be called with __IXGBE_IN_SFP_INIT held.
+ **/
+static void ixgbe_msf_try_next(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+
+	if (adapter->msf_speed & IXGBE_LINK_SPEED_10GB_FULL) {
+		adapter->msf_try = IXGBE_LINK_SPEED_10GB_FULL;
+	} else if (adapter->msf_speed & IXGBE_LINK_SPEED_1GB_FULL) {
+		adapter->msf_try = IXGBE_LINK_SPEED_1GB_FULL;
+	} else if (!adapter->msf_fallback &&
+		   adapter->msf_try != adapter->msf_highest) {
+		/* We didn't get link.  Configure back to the highest speed
+		 * we tried, (if there was more than one).
+		 */
+		adapter->msf_fallback = true;
+		adapter->msf_try = adapter->msf_highest;
+	} else {
+		adapter->msf_state = IXGBE_MSF_IDLE;
+		return;
+	}
+	adapter->msf_speed &= ~adapter->msf_try;
+
+	/* Set the module link speed */
+	switch (hw->phy.media_type) {
+	case ixgbe_media_type_fiber:
+		ixgbe_set_rate_select_speed(hw, adapter->msf_try);
+		break;
+	case ixgbe_media_type_fiber_qsfp:
+		/* QSFP module automatically detects MAC link speed */
+		break;
+	default:
+		hw_dbg(hw, "Unexpected media type.\n");
+		break;
+	}
+
+	/* Allow module to change analog characteristics */
+	adapter->msf_state = IXGBE_MSF_SETTLE;
+	adapter->msf_deadline = ktime_add_us(ktime_get(),
+					     IXGBE_MSF_SETTLE_USECS);
+}
+
+/**
+ * ixgbe_msf_start - begin non-blocking multispeed fiber link setup
+ * @adapter: the ixgbe adapter structure
+ * @speed: requested link speeds
+ *
+ * Non-blocking counterpart of ixgbe_setup_mac_link_multispeed_fiber().
+ * Must be called with __IXGBE_IN_SFP_INIT held.
+ **/
+static void ixgbe_msf_start(struct ixgbe_adapter *adapter,
+			    ixgbe_link_speed speed)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	ixgbe_link_speed link_speed;
+	bool autoneg;
+
+	/* Mask off requested but non-supported speeds */
+	if (ixgbe_get_link_capabilities(hw, &link_speed, &autoneg))
+		return;
+
+	speed &= link_speed & (IXGBE_LINK_SPEED_10GB_FULL |
+			       IXGBE_LINK_SPEED_1GB_FULL);
+
+	/* Set autoneg_advertised value based on input link speed */
+	hw->phy.autoneg_advertised = speed;
+
+	adapter->msf_speed = speed;
+	adapter->msf_highest = (speed & IXGBE_LINK_SPEED_10GB_FULL) ?
+			       IXGBE_LINK_SPEED_10GB_FULL : speed;
+	adapter->msf_try = IXGBE_LINK_SPEED_UNKNOWN;
+	adapter->msf_fallback = false;
+
+	ixgbe_msf_try_next(adapter);
+}
+
+#ifdef ETHTOOL_GMODULEINFO
+/**
+ * ixgbe_read_module_eeprom - read pluggable module EEPROM over I2C
+ * @adapter: the ixgbe adapter structure
+ * @offset: offset to read from, page 0xA2 starts at ETH_MODULE_SFF_8079_LEN
+ * @len: number of bytes to read
+ * @data: buffer to read into
+ *
+ * Returns -EBUSY if module init is in progress, since I2C reads can take a
+ * long time and would otherwise delay link setup.
+ **/
+int ixgbe_read_module_eeprom(struct ixgbe_adapter *adapter, u32 offset,
+			     u32 len, u8 *data)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	u8 databyte = 0xFF;
+	s32 status;
+	u32 i;
+
+	for (i = offset; i < offset + len; i++) {
+		if (test_bit(__IXGBE_IN_SFP_INIT, adapter->state))
+			return -EBUSY;
+
+		if (i < ETH_MODULE_SFF_8079_LEN)
+			status = hw->phy.ops.read_i2c_eeprom(hw, i, &databyte);
+		else
+			status = hw->phy.ops.read_i2c_sff8472(hw, i, &databyte);
+
+		if (status != 0)
+			return -EIO;
+
+		data[i - offset] = databyte;
+	}
+
+	return 0;
+}
+
+/**
+ * ixgbe_module_cache_invalidate - drop cached module EEPROM contents
+ * @adapter: the ixgbe adapter structure
+ **/
+static void ixgbe_module_cache_invalidate(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
+
+	spin_lock_bh(&mc->lock);
+	mc->valid = false;
+	spin_unlock_bh(&mc->lock);
+}
+
+/**
+ * ixgbe_module_cache_fill - read the static module EEPROM pages
+ * @adapter: the ixgbe adapter structure
+ **/
+static int ixgbe_module_cache_fill(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
+	u32 type = ETH_MODULE_SFF_8079;
+	u32 len = ETH_MODULE_SFF_8079_LEN;
+	u8 *data;
+	int err;
+
+	data = kzalloc(ETH_MODULE_SFF_8472_LEN, GFP_KERNEL);
+	if (!data)
+		return -ENOMEM;
+
+	err = ixgbe_read_module_eeprom(adapter, 0, ETH_MODULE_SFF_8079_LEN,
+				       data);
+	if (err)
+		goto out;
+
+	/* address change is required to access page 0xA2, not supported */
+	if (data[IXGBE_SFF_SFF_8472_COMP] != IXGBE_SFF_SFF_8472_UNSUP &&
+	    !(data[IXGBE_SFF_SFF_8472_SWAP] & IXGBE_SFF_ADDRESSING_MODE)) {
+		type = ETH_MODULE_SFF_8472;
+		len = ETH_MODULE_SFF_8472_LEN;
+
+		err = ixgbe_read_module_eeprom(adapter,
+					       ETH_MODULE_SFF_8079_LEN,
+					       ETH_MODULE_SFF_8472_LEN -
+					       ETH_MODULE_SFF_8079_LEN,
+					       data + ETH_MODULE_SFF_8079_LEN);
+		if (err)
+			goto out;
+	}
+
+	spin_lock_bh(&mc->lock);
+	memcpy(mc->data, data, len);
+	mc->type = type;
+	mc->len = len;
+	mc->static_jiffies = jiffies;
+	mc->dom_jiffies = mc->static_jiffies;
+	mc->valid = true;
+	spin_unlock_bh(&mc->lock);
+
+out:
+	kfree(data);
+	return err;
+}
+
+/**
+ * ixgbe_module_dom_refresh - re-read the module real-time diagnostics
+ * @adapter: the ixgbe adapter structure
+ **/
+static int ixgbe_module_dom_refresh(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
+	u8 dom[IXGBE_MODULE_DOM_LEN];
+	int err;
+
+	err = ixgbe_read_module_eeprom(adapter, IXGBE_MODULE_DOM_OFFSET,
+				       IXGBE_MODULE_DOM_LEN, dom);
+	if (err)
+		return err;
+
+	spin_lock_bh(&mc->lock);
+	if (mc->valid) {
+		memcpy(mc->data + IXGBE_MODULE_DOM_OFFSET, dom, sizeof(dom));
+		mc->dom_jiffies = jiffies;
+	}
+	spin_unlock_bh(&mc->lock);
+
+	return 0;
+}
+
+/**
+ * ixgbe_module_task - fill the module EEPROM cache and poll diagnostics
+ * @work: pointer to the module_task delayed work
+ *
+ * Runs on system_long_wq so that slow I2C accesses do not hold up the
+ * service task.
+ **/
+static void ixgbe_module_task(struct work_struct *work)
+{
+	struct ixgbe_adapter *adapter = container_of(to_delayed_work(work),
+						     struct ixgbe_adapter,
+						     module_task);
+	struct ixgbe_module_cache *mc = &adapter->module_cache;
+	int err;
+
+	if (test_bit(__IXGBE_DOWN, adapter->state) ||
+	    test_bit(__IXGBE_REMOVING, adapter->state))
+		return;
+
+	if (!mc->valid)
+		err = ixgbe_module_cache_fill(adapter);
+	else
+		err = ixgbe_module_dom_refresh(adapter);
 
-	ixgbe_watchdog_flush_tx(adapter);
+	if (err == -EBUSY)
+		queue_delayed_work(system_long_wq, &adapter->module_task,
+				   IXGBE_MODULE_RETRY_INTERVAL);
+	else if (!err && mc->type == ETH_MODULE_SFF_8472)
+		queue_delayed_work(system_long_wq, &adapter->module_task,
+				   IXGBE_MODULE_DOM_INTERVAL);
 }
 
+#endif /* ETHTOOL_GMODULEINFO */
 /**
  * ixgbe_sfp_detection_subtask - poll for SFP+ cable
  * @adapter: the ixgbe adapter structure
@@ -10360,6 +11531,9 @@ static void ixgbe_sfp_detection_subtask(struct ixgbe_adapter *adapter)
 		/* If no cable is present, then we need to reset
 		 * the next time we find a good cable. */
 		adapter->flags2 |= IXGBE_FLAG2_SFP_NEEDS_RESET;
+#ifdef ETHTOOL_GMODULEINFO
+		ixgbe_module_cache_invalidate(adapter);
+#endif
 	}
 
 	/* exit on error */
@@ -10371,6 +11545,10 @@ static void ixgbe_sfp_detection_subtask(struct ixgbe_adapter *adapter)
 		goto sfp_out;
 
 	adapter->flags2 &= ~IXGBE_FLAG2_SFP_NEEDS_RESET;
+	ixgbe_link_phase_end(adapter, IXGBE_LINK_PHASE_SFP_DETECT);
+#ifdef ETHTOOL_GMODULEINFO
+	ixgbe_module_cache_invalidate(adapter);
+#endif
 
 	/*
 	 * A module may be identified correctly, but the EEPROM may not have
@@ -10385,8 +11563,15 @@ static void ixgbe_sfp_detection_subtask(struct ixgbe_adapter *adapter)
 	if (err == IXGBE_ERR_SFP_NOT_SUPPORTED)
 		goto sfp_out;
 
+	ixgbe_link_phase_end(adapter, IXGBE_LINK_PHASE_SFP_SETUP);
+
 	adapter->flags |= IXGBE_FLAG_NEED_LINK_CONFIG;
 	e_info(probe, "detected SFP+: %d\n", hw->phy.sfp_type);
+#ifdef ETHTOOL_GMODULEINFO
+	/* read the module EEPROM once link setup had a chance to start */
+	mod_delayed_work(system_long_wq, &adapter->module_task,
+			 IXGBE_MODULE_RETRY_INTERVAL);
+#endif
 
 sfp_out:
 	clear_bit(__IXGBE_IN_SFP_INIT, adapter->state);
@@ -10422,6 +11607,9 @@ static void ixgbe_sfp_link_config_subtask(struct ixgbe_adapter *adapter)
 
 	adapter->flags &= ~IXGBE_FLAG_NEED_LINK_CONFIG;
 
+	if (!ktime_to_ns(adapter->link_timing.start))
+		ixgbe_link_timing_start(adapter);
+
 	hw->mac.ops.get_link_capabilities(hw, &cap_speed, &autoneg);
 
 	/* Advertise highest capable link speed */
@@ -10434,12 +11622,97 @@ static void ixgbe_sfp_link_config_subtask(struct ixgbe_adapter *adapter)
 		speed = IXGBE_LINK_SPEED_1GB_FULL;
 	}
 
-	if (hw->mac.ops.setup_link)
+	if (hw->mac.ops.setup_link == ixgbe_setup_mac_link_multispeed_fiber)
+		ixgbe_msf_start(adapter, speed);
+	else if (hw->mac.ops.setup_link)
 		hw->mac.ops.setup_link(hw, speed, true);
 
 	adapter->flags |= IXGBE_FLAG_NEED_LINK_UPDATE;
 	adapter->link_check_timeout = jiffies;
 	clear_bit(__IXGBE_IN_SFP_INIT, adapter->state);
+
+	if (adapter->msf_state != IXGBE_MSF_IDLE)
+		ixgbe_msf_arm(adapter, IXGBE_MSF_SETTLE_USECS);
+}
+
+/**
+ * ixgbe_msf_subtask - advance the multispeed fiber link state machine
+ * @adapter: the ixgbe adapter structure
+ *
+ * Runs from the service task whenever the msf_timer expires or a link
+ * status change interrupt is received while a link bring-up is pending.
+ **/
+static void ixgbe_msf_subtask(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_hw *hw = &adapter->hw;
+	ixgbe_link_speed link_speed;
+	bool link_up = false;
+	ktime_t now;
+	s64 delta;
+
+	if (adapter->msf_state == IXGBE_MSF_IDLE)
+		return;
+
+	/* someone else is in init, try again shortly */
+	if (test_and_set_bit(__IXGBE_IN_SFP_INIT, adapter->state)) {
+		ixgbe_msf_arm(adapter, IXGBE_MSF_POLL_USECS);
+		return;
+	}
+
+	now = ktime_get();
+	switch (adapter->msf_state) {
+	case IXGBE_MSF_SETTLE:
+		if (ktime_before(now, adapter->msf_deadline))
+			break;
+
+		if (ixgbe_setup_mac_link(hw, adapter->msf_try, false)) {
+			e_warn(drv, "failed to set up link at speed 0x%x\n",
+			       adapter->msf_try);
+			adapter->msf_state = IXGBE_MSF_IDLE;
+			break;
+		}
+
+		/* Flap the Tx laser if it has not already been done */
+		ixgbe_flap_tx_laser(hw);
+
+		now = ktime_get();
+		adapter->msf_state = IXGBE_MSF_WAIT_LINK;
+		adapter->msf_deadline =
+			ktime_add_us(now,
+				     adapter->msf_try == IXGBE_LINK_SPEED_10GB_FULL ?
+				     IXGBE_MSF_10G_LINK_USECS :
+				     IXGBE_MSF_1G_LINK_USECS);
+		break;
+	case IXGBE_MSF_WAIT_LINK:
+		if (hw->mac.ops.check_link(hw, &link_speed, &link_up, false) ||
+		    link_up) {
+			adapter->msf_state = IXGBE_MSF_IDLE;
+			adapter->flags |= IXGBE_FLAG_NEED_LINK_UPDATE;
+			break;
+		}
+
+		if (ktime_before(now, adapter->msf_deadline))
+			break;
+
+		ixgbe_msf_try_next(adapter);
+		break;
+	default:
+		adapter->msf_state = IXGBE_MSF_IDLE;
+		break;
+	}
+
+	clear_bit(__IXGBE_IN_SFP_INIT, adapter->state);
+
+	if (adapter->msf_state == IXGBE_MSF_IDLE)
+		return;
+
+	/* wake up at the end of the current step, polling link while waiting
+	 * in case the link status change interrupt is masked
+	 */
+	delta = ktime_us_delta(adapter->msf_deadline, ktime_get());
+	if (adapter->msf_state == IXGBE_MSF_WAIT_LINK)
+		delta = min_t(s64, delta, IXGBE_MSF_POLL_USECS);
+	ixgbe_msf_arm(adapter, max_t(s64, delta, 1));
 }
 
 /**
@@ -10498,6 +11771,147 @@ static void ixgbe_reset_subtask(struct ixgbe_adapter *adapter)
 	rtnl_unlock();
 }
 
+/**
+ * ixgbe_recover_tx_ring - flush and restart a single Tx queue
+ * @adapter: board private structure
+ * @tx_ring: hung ring
+ *
+ * Returns true if the queue is running again, false if the caller needs
+ * to fall back to a full reset.
+ **/
+static bool ixgbe_recover_tx_ring(struct ixgbe_adapter *adapter,
+				  struct ixgbe_ring *tx_ring)
+{
+	struct ixgbe_q_vector *q_vector = tx_ring->q_vector;
+	struct netdev_queue *txq = txring_txq(tx_ring);
+	u32 txdctl;
+
+	/* keep the stack from handing us any more frames */
+	__netif_tx_lock_bh(txq);
+	netif_tx_stop_queue(txq);
+	__netif_tx_unlock_bh(txq);
+
+	/* Tx cleanup runs from the shared napi context */
+	napi_disable(&q_vector->napi);
+
+	if (!ixgbe_disable_txr_hw(adapter, tx_ring)) {
+		napi_enable(&q_vector->napi);
+		return false;
+	}
+
+	ixgbe_clean_tx_ring(tx_ring);
+	ixgbe_configure_tx_ring(adapter, tx_ring);
+
+	napi_enable(&q_vector->napi);
+
+	/* the vector may have been masked while napi was disabled */
+	local_bh_disable();
+	napi_schedule(&q_vector->napi);
+	local_bh_enable();
+
+	txdctl = IXGBE_READ_REG(&adapter->hw, IXGBE_TXDCTL(tx_ring->reg_idx));
+	if (!(txdctl & IXGBE_TXDCTL_ENABLE))
+		return false;
+
+	tx_ring->last_tx_recovery = jiffies;
+	netif_tx_wake_queue(txq);
+
+	return true;
+}
+
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+/**
+ * ixgbe_rx_fill_subtask - review how many buffers each Rx ring keeps posted
+ * @adapter: board private structure
+ *
+ * Lowers the fill target of rings that have been quiet since the last
+ * review to what their recent rate needs.  Busy rings raise their own
+ * target again from the hot path, see ixgbe_rx_fill_count.
+ **/
+static void ixgbe_rx_fill_subtask(struct ixgbe_adapter *adapter)
+{
+	unsigned long elapsed = jiffies - adapter->rx_fill_review;
+	int i;
+
+	if (!(adapter->flags2 & IXGBE_FLAG2_RX_IDLE_SHRINK))
+		return;
+
+	if (test_bit(__IXGBE_DOWN, adapter->state) ||
+	    test_bit(__IXGBE_RESETTING, adapter->state))
+		return;
+
+	if (elapsed < IXGBE_RX_FILL_REVIEW)
+		return;
+	adapter->rx_fill_review = jiffies;
+
+	for (i = 0; i < adapter->num_rx_queues; i++) {
+		struct ixgbe_ring *rx_ring = adapter->rx_ring[i];
+		u64 packets, need;
+
+		if (!rx_ring)
+			continue;
+#ifdef HAVE_AF_XDP_ZC_SUPPORT
+		if (rx_ring->xsk_pool)
+			continue;
+#endif
+
+		packets = READ_ONCE(rx_ring->stats.packets);
+		need = div64_u64((packets - rx_ring->rx_fill_packets) *
+				 IXGBE_RX_FILL_HEADROOM_MS,
+				 jiffies_to_msecs(elapsed));
+		rx_ring->rx_fill_packets = packets;
+
+		need = clamp_t(u64, need, IXGBE_RX_FILL_LOW_WATER,
+			       rx_ring->count - 1);
+		WRITE_ONCE(rx_ring->rx_fill_target, need);
+	}
+}
+
+#endif /* CONFIG_IXGBE_DISABLE_PACKET_SPLIT */
+/**
+ * ixgbe_tx_recovery_subtask - recover individual hung Tx queues
+ * @adapter: board private structure
+ **/
+static void ixgbe_tx_recovery_subtask(struct ixgbe_adapter *adapter)
+{
+	int i;
+
+	if (!test_and_clear_bit(__IXGBE_TX_RECOVERY_REQUESTED, adapter->state))
+		return;
+
+	rtnl_lock();
+	/* a full reset already in flight will restart every queue */
+	if (test_bit(__IXGBE_DOWN, adapter->state) ||
+	    test_bit(__IXGBE_REMOVING, adapter->state) ||
+	    test_bit(__IXGBE_RESETTING, adapter->state) ||
+	    test_bit(__IXGBE_RESET_REQUESTED, adapter->state)) {
+		rtnl_unlock();
+		return;
+	}
+
+	for (i = 0; i < adapter->num_tx_queues; i++) {
+		struct ixgbe_ring *tx_ring = adapter->tx_ring[i];
+
+		if (!test_and_clear_bit(__IXGBE_TX_RECOVER_REQUESTED,
+					&tx_ring->state))
+			continue;
+
+		e_err(hw, "Reset Tx queue %d\n", tx_ring->queue_index);
+		if (ixgbe_recover_tx_ring(adapter, tx_ring)) {
+			adapter->tx_queue_recovery_count++;
+			continue;
+		}
+
+		e_err(hw, "Tx queue %d did not restart, reset adapter\n",
+		      tx_ring->queue_index);
+		adapter->tx_timeout_count++;
+		ixgbe_reinit_locked(adapter);
+		break;
+	}
+
+	rtnl_unlock();
+}
+
 static int ixgbe_check_fw_api_ver(struct ixgbe_adapter *adapter)
 {
 	struct ixgbe_hw *hw = &adapter->hw;
@@ -10602,18 +12016,25 @@ static void ixgbe_service_task(struct work_struct *work)
 	if (hw->mac.type == ixgbe_mac_E610)
 		ixgbe_check_media_subtask(adapter);
 	ixgbe_reset_subtask(adapter);
+	ixgbe_tx_recovery_subtask(adapter);
 	ixgbe_phy_interrupt_subtask(adapter);
 	ixgbe_sfp_detection_subtask(adapter);
 	ixgbe_sfp_link_config_subtask(adapter);
+	ixgbe_msf_subtask(adapter);
 	ixgbe_check_overtemp_subtask(adapter);
 	ixgbe_watchdog_subtask(adapter);
 #ifdef HAVE_TX_MQ
 	ixgbe_fdir_reinit_subtask(adapter);
 #endif
 	ixgbe_check_hang_subtask(adapter);
+#ifndef CONFIG_IXGBE_DISABLE_PACKET_SPLIT
+	ixgbe_rx_fill_subtask(adapter);
+#endif
 #ifdef HAVE_PTP_1588_CLOCK
 	if (test_bit(__IXGBE_PTP_RUNNING, adapter->state)) {
 		ixgbe_ptp_overflow_check(adapter);
+		ixgbe_ptp_check_extts(adapter);
+		ixgbe_ptp_holdover_check(adapter);
 		if (unlikely(adapter->flags & IXGBE_FLAG_RX_HWTSTAMP_IN_REGISTER))
 			ixgbe_ptp_rx_hang(adapter);
 		ixgbe_ptp_tx_hang(adapter);
@@ -10625,10 +12046,12 @@ static void ixgbe_service_task(struct work_struct *work)
 
 static int ixgbe_tso(struct ixgbe_ring *tx_ring,
 		     struct ixgbe_tx_buffer *first,
-		     u8 *hdr_len)
+		     u8 *hdr_len,
+		     struct ixgbe_ipsec_tx_data *itd)
 {
 #ifdef NETIF_F_TSO
 	u32 vlan_macip_lens, type_tucmd, mss_l4len_idx;
+	u32 fceof_saidx = 0;
 	struct sk_buff *skb = first->skb;
 	union {
 		struct iphdr *v4;
@@ -10704,7 +12127,10 @@ static int ixgbe_tso(struct ixgbe_ring *tx_ring,
 	vlan_macip_lens |= (ip.hdr - skb->data) << IXGBE_ADVTXD_MACLEN_SHIFT;
 	vlan_macip_lens |= first->tx_flags & IXGBE_TX_FLAGS_VLAN_MASK;
 
-	ixgbe_tx_ctxtdesc(tx_ring, vlan_macip_lens, 0, type_tucmd,
+	fceof_saidx |= itd->sa_idx;
+	type_tucmd |= itd->flags | itd->trailer_len;
+
+	ixgbe_tx_ctxtdesc(tx_ring, vlan_macip_lens, fceof_saidx, type_tucmd,
 			  mss_l4len_idx);
 
 	return 1;
@@ -10723,10 +12149,12 @@ static inline bool ixgbe_ipv6_csum_is_sctp(struct sk_buff *skb)
 }
 
 static void ixgbe_tx_csum(struct ixgbe_ring *tx_ring,
-			  struct ixgbe_tx_buffer *first)
+			  struct ixgbe_tx_buffer *first,
+			  struct ixgbe_ipsec_tx_data *itd)
 {
 	struct sk_buff *skb = first->skb;
 	u32 vlan_macip_lens = 0;
+	u32 fceof_saidx = 0;
 	u32 type_tucmd = 0;
 
 	if (skb->ip_summed != CHECKSUM_PARTIAL) {
@@ -10767,7 +12195,10 @@ no_csum:
 	vlan_macip_lens |= skb_network_offset(skb) << IXGBE_ADVTXD_MACLEN_SHIFT;
 	vlan_macip_lens |= first->tx_flags & IXGBE_TX_FLAGS_VLAN_MASK;
 
-	ixgbe_tx_ctxtdesc(tx_ring, vlan_macip_lens, 0, type_tucmd, 0);
+	fceof_saidx |= itd->sa_idx;
+	type_tucmd |= itd->flags | itd->trailer_len;
+
+	ixgbe_tx_ctxtdesc(tx_ring, vlan_macip_lens, fceof_saidx, type_tucmd, 0);
 }
 
 #define IXGBE_SET_FLAG(_input, _flag, _result) \
@@ -10794,6 +12225,10 @@ static u32 ixgbe_tx_cmd_type(u32 tx_flags)
 	cmd_type |= IXGBE_SET_FLAG(tx_flags, IXGBE_TX_FLAGS_TSTAMP,
 				   IXGBE_ADVTXD_MAC_TSTAMP);
 
+	/* insert the SecTAG and ICV for the offloaded MACsec SecY */
+	cmd_type |= IXGBE_SET_FLAG(tx_flags, IXGBE_TX_FLAGS_LINKSEC,
+				   IXGBE_ADVTXD_MAC_LINKSEC);
+
 	return cmd_type;
 }
 
@@ -10820,6 +12255,11 @@ static void ixgbe_tx_olinfo_status(union ixgbe_adv_tx_desc *tx_desc,
 					IXGBE_TX_FLAGS_CC,
 					IXGBE_ADVTXD_CC);
 
+	/* request inline IPsec processing using the SA in the context */
+	olinfo_status |= IXGBE_SET_FLAG(tx_flags,
+					IXGBE_TX_FLAGS_IPSEC,
+					IXGBE_ADVTXD_POPTS_IPSEC);
+
 	tx_desc->read.olinfo_status = cpu_to_le32(olinfo_status);
 }
 
@@ -10897,6 +12337,10 @@ static int ixgbe_tx_map(struct ixgbe_ring *tx_ring,
 		dma_unmap_len_set(tx_buffer, len, size);
 		dma_unmap_addr_set(tx_buffer, dma, dma);
 
+		/* recorded first so the error path unmaps it again */
+		if (unlikely(ixgbe_should_fail(IXGBE_FAULT_DMA_MAP)))
+			goto dma_error;
+
 		tx_desc->read.buffer_addr = cpu_to_le64(dma);
 
 		while (unlikely(size > IXGBE_MAX_DATA_PER_TXD)) {
@@ -11323,35 +12767,6 @@ int ixgbe_xmit_xdp_ring(struct ixgbe_ring *ring, struct xdp_buff *xdp)
 }
 
 #ifdef HAVE_AF_XDP_ZC_SUPPORT
-static void ixgbe_disable_txr_hw(struct ixgbe_adapter *adapter,
-				 struct ixgbe_ring *tx_ring)
-{
-	unsigned long wait_delay, delay_interval;
-	struct ixgbe_hw *hw = &adapter->hw;
-	u8 reg_idx = tx_ring->reg_idx;
-	int wait_loop;
-	u32 txdctl;
-
-	IXGBE_WRITE_REG(hw, IXGBE_TXDCTL(reg_idx), IXGBE_TXDCTL_SWFLSH);
-
-	/* delay mechanism from ixgbe_disable_tx */
-	delay_interval = ixgbe_get_completion_timeout(adapter) / 100;
-
-	wait_loop = IXGBE_MAX_RX_DESC_POLL;
-	wait_delay = delay_interval;
-
-	while (wait_loop--) {
-		usleep_range(wait_delay, wait_delay + 10);
-		wait_delay += delay_interval * 2;
-		txdctl = IXGBE_READ_REG(hw, IXGBE_TXDCTL(reg_idx));
-
-		if (!(txdctl & IXGBE_TXDCTL_ENABLE))
-			return;
-	}
-
-	e_err(drv, "TXDCTL.ENABLE not cleared within the polling period\n");
-}
-
 static void ixgbe_disable_txr(struct ixgbe_adapter *adapter,
 			      struct ixgbe_ring *tx_ring)
 {
@@ -11368,12 +12783,12 @@ static void ixgbe_disable_rxr_hw(struct ixgbe_adapter *adapter,
 	int wait_loop;
 	u32 rxdctl;
 
-	rxdctl = IXGBE_READ_REG(hw, IXGBE_RXDCTL(reg_idx));
+	rxdctl = ixgbe_shadow_read(adapter, IXGBE_SHADOW_RXDCTL, reg_idx);
 	rxdctl &= ~IXGBE_RXDCTL_ENABLE;
 	rxdctl |= IXGBE_RXDCTL_SWFLSH;
 
 	/* write value back with RXDCTL.ENABLE bit cleared */
-	IXGBE_WRITE_REG(hw, IXGBE_RXDCTL(reg_idx), rxdctl);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_RXDCTL, reg_idx, rxdctl);
 
 	/* RXDCTL.EN may not change on 82598 if link is down, so skip it */
 	if (hw->mac.type == ixgbe_mac_82598EB &&
@@ -11483,6 +12898,7 @@ netdev_tx_t ixgbe_xmit_frame_ring(struct sk_buff *skb,
 				  struct ixgbe_adapter __maybe_unused *adapter,
 				  struct ixgbe_ring *tx_ring)
 {
+	struct ixgbe_ipsec_tx_data ipsec_tx = { 0 };
 	struct ixgbe_tx_buffer *first;
 	int tso;
 	u32 tx_flags = 0;
@@ -11596,6 +13012,21 @@ netdev_tx_t ixgbe_xmit_frame_ring(struct sk_buff *skb,
 	}
 
 #endif /* HAVE_TX_MQ */
+#ifdef HAVE_IXGBE_MACSEC
+	if (adapter->macsec && ixgbe_macsec_skb(skb)) {
+		switch (READ_ONCE(adapter->macsec->tx_state)) {
+		case IXGBE_MACSEC_TX_PROTECT:
+			tx_flags |= IXGBE_TX_FLAGS_LINKSEC;
+			break;
+		case IXGBE_MACSEC_TX_CLEAR:
+			break;
+		default:
+			/* never leak frames of a protected SecY in the clear */
+			goto out_drop;
+		}
+	}
+
+#endif /* HAVE_IXGBE_MACSEC */
 	/* record initial flags and protocol */
 	first->tx_flags = tx_flags;
 	first->protocol = protocol;
@@ -11628,11 +13059,16 @@ netdev_tx_t ixgbe_xmit_frame_ring(struct sk_buff *skb,
 	}
 #endif /* CONFIG_FCOE */
 
-	tso = ixgbe_tso(tx_ring, first, &hdr_len);
+#ifdef HAVE_IXGBE_IPSEC
+	if (xfrm_offload(skb) &&
+	    !ixgbe_ipsec_tx(tx_ring, first, &ipsec_tx))
+		goto out_drop;
+#endif /* HAVE_IXGBE_IPSEC */
+	tso = ixgbe_tso(tx_ring, first, &hdr_len, &ipsec_tx);
 	if (tso < 0)
 		goto out_drop;
 	else if (!tso)
-		ixgbe_tx_csum(tx_ring, first);
+		ixgbe_tx_csum(tx_ring, first, &ipsec_tx);
 
 	/* add the ATR filter if ATR is on */
 	if (test_bit(__IXGBE_TX_FDIR_INIT_DONE, &tx_ring->state))
@@ -12581,6 +14017,15 @@ int ixgbe_setup_tc(struct net_device *dev, u8 tc)
 	    tc < IXGBE_DCB_MAX_TRAFFIC_CLASS)
 		return -EINVAL;
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	/* double VLAN mode is global and cannot be split across TCs */
+	if (tc && (dev->features & NETIF_F_HW_VLAN_STAG_RX)) {
+		e_dev_err("DCB is not supported with 802.1ad offload\n");
+		return -EINVAL;
+	}
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
+
 	/* Hardware has to reinitialize queues and interrupts to
 	 * match packet buffer alignment. Unfortunately, the
 	 * hardware is not flexible enough to do this dynamically.
@@ -12640,7 +14085,7 @@ void ixgbe_sriov_reinit(struct ixgbe_adapter *adapter)
 	struct net_device *netdev = adapter->netdev;
 
 	rtnl_lock();
-	ixgbe_setup_tc(netdev, netdev_get_num_tc(netdev));
+	ixgbe_setup_tc(netdev, ixgbe_dcb_tcs(adapter));
 	rtnl_unlock();
 }
 #endif
@@ -12687,6 +14132,26 @@ static netdev_features_t ixgbe_fix_features(struct net_device *netdev,
 		features &= ~NETIF_F_LRO;
 	}
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	if (features & NETIF_F_HW_VLAN_STAG_RX) {
+		/* double VLAN mode is global and would apply to VF and DCB
+		 * traffic as well
+		 */
+		if (adapter->flags & (IXGBE_FLAG_SRIOV_ENABLED |
+				      IXGBE_FLAG_DCB_ENABLED)) {
+			e_dev_err("802.1ad offload is not supported with SR-IOV or DCB\n");
+			features &= ~NETIF_F_HW_VLAN_STAG_RX;
+		} else {
+			/* the C-tag offloads act on the inner tag in this
+			 * mode, which the stack expects to find in the payload
+			 */
+			features &= ~(NETIF_F_HW_VLAN_CTAG_RX |
+				      NETIF_F_HW_VLAN_CTAG_TX |
+				      NETIF_F_HW_VLAN_CTAG_FILTER);
+		}
+	}
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
+
 	return features;
 }
 
@@ -12708,8 +14173,7 @@ static int ixgbe_set_features(struct net_device *netdev,
 		adapter->flags2 &= ~IXGBE_FLAG2_RSC_ENABLED;
 	} else if ((adapter->flags2 & IXGBE_FLAG2_RSC_CAPABLE) &&
 		   !(adapter->flags2 & IXGBE_FLAG2_RSC_ENABLED)) {
-		if (adapter->rx_itr_setting == 1 ||
-		    adapter->rx_itr_setting > IXGBE_MIN_RSC_ITR) {
+		if (ixgbe_rsc_itr_ok(adapter)) {
 			adapter->flags2 |= IXGBE_FLAG2_RSC_ENABLED;
 			need_reset = true;
 		} else if (changed & NETIF_F_LRO) {
@@ -12753,6 +14217,19 @@ static int ixgbe_set_features(struct net_device *netdev,
 			adapter->flags |= IXGBE_FLAG_FDIR_HASH_CAPABLE;
 	}
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	/* moving the parser in or out of double VLAN mode needs a reset */
+	if (changed & NETIF_F_HW_VLAN_STAG_RX)
+		need_reset = true;
+#endif
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+
+	/* macvlans already offloaded go back to the software path */
+	if ((changed & NETIF_F_HW_L2FW_DOFFLOAD) &&
+	    !(features & NETIF_F_HW_L2FW_DOFFLOAD))
+		ixgbe_fwd_release_all(adapter);
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
+
 	netdev->features = features;
 
 #if defined(HAVE_UDP_ENC_RX_OFFLOAD) || defined(HAVE_VXLAN_RX_OFFLOAD)
@@ -12779,6 +14256,13 @@ static int ixgbe_set_features(struct net_device *netdev,
 	}
 #endif /* HAVE_UDP_ENC_RX_OFFLOAD */
 
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+	/* the PF may use every pool again, so lift the pool 0 fence */
+	if (!(features & NETIF_F_HW_L2FW_DOFFLOAD) &&
+	    (adapter->flags2 & IXGBE_FLAG2_FWD_POOLS))
+		return ixgbe_setup_tc(netdev, ixgbe_dcb_tcs(adapter));
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 	if (need_reset)
 		ixgbe_do_reset(netdev);
 #ifdef NETIF_F_HW_VLAN_CTAG_FILTER
@@ -13175,8 +14659,12 @@ ixgbe_features_check(struct sk_buff *skb, struct net_device *dev,
 	/* We can only support IPV4 TSO in tunnels if we can mangle the
 	 * inner IP ID field, so strip TSO if MANGLEID is not supported.
 	 */
-	if (skb->encapsulation && !(features & NETIF_F_TSO_MANGLEID))
-		features &= ~NETIF_F_TSO;
+	if (skb->encapsulation && !(features & NETIF_F_TSO_MANGLEID)) {
+#ifdef HAVE_IXGBE_IPSEC
+		if (!secpath_exists(skb))
+#endif /* HAVE_IXGBE_IPSEC */
+			features &= ~NETIF_F_TSO;
+	}
 
 	return features;
 }
@@ -13197,6 +14685,128 @@ ixgbe_features_check(struct sk_buff *skb, struct net_device *dev,
 #endif /* NETIF_F_GSO_PARTIAL */
 #endif /* HAVE_NDO_FEATURES_CHECK */
 
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+/**
+ * ixgbe_fwd_add - offload a macvlan onto a VMDq pool of its own
+ * @pdev: lower (PF) net device
+ * @vdev: macvlan being brought up on @pdev
+ *
+ * The pool gets its own Rx/Tx queues, RSS across them and a RAR entry for
+ * the macvlan's address.  If no pool is free the VMDq layout is grown,
+ * which reinitializes the rings of @pdev.
+ *
+ * Returns the private pointer macvlan hands back on removal, or an
+ * ERR_PTR when the macvlan should stay in software
+ **/
+static void *ixgbe_fwd_add(struct net_device *pdev, struct net_device *vdev)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(pdev);
+	struct ixgbe_fwd_adapter *accel;
+	int pool, err;
+
+	/* pools are carved out of the plain VMDq layout only */
+	if (adapter->flags & (IXGBE_FLAG_DCB_ENABLED |
+			      IXGBE_FLAG_SRIOV_ENABLED)) {
+		netdev_info(pdev,
+			    "%s: macvlan offload requires DCB and SR-IOV to be disabled\n",
+			    vdev->name);
+		return ERR_PTR(-EINVAL);
+	}
+
+#ifdef HAVE_XDP_SUPPORT
+	if (adapter->xdp_prog) {
+		netdev_info(pdev, "%s: macvlan offload is not supported with XDP\n",
+			    vdev->name);
+		return ERR_PTR(-EINVAL);
+	}
+
+#endif /* HAVE_XDP_SUPPORT */
+	/* the pool only receives frames addressed to the macvlan itself */
+	if (!macvlan_supports_dest_filter(vdev)) {
+		netdev_info(pdev, "%s: only private, vepa and bridge macvlans can be offloaded\n",
+			    vdev->name);
+		return ERR_PTR(-EMEDIUMTYPE);
+	}
+
+	/* a subordinate channel can only back a single queue netdev */
+	if (netif_is_multiqueue(vdev))
+		return ERR_PTR(-ERANGE);
+
+	for (pool = 1; pool < adapter->num_rx_pools; pool++)
+		if (!adapter->fwd_priv[pool])
+			break;
+
+	if (!(adapter->flags2 & IXGBE_FLAG2_FWD_POOLS) ||
+	    pool >= adapter->num_rx_pools) {
+		struct ixgbe_ring_feature *vmdq;
+
+		if (adapter->num_rx_pools > IXGBE_MAX_MACVLANS)
+			return ERR_PTR(-EBUSY);
+
+		/* Grow in steps that keep as many queues per pool as the
+		 * hardware allows: 16 pools of 4, then 32 of 4, then 64 of 2.
+		 */
+		vmdq = &adapter->ring_feature[RING_F_VMDQ];
+		if (adapter->num_rx_pools < 16)
+			vmdq->limit = 16;
+		else if (adapter->num_rx_pools < 32)
+			vmdq->limit = 32;
+		else
+			vmdq->limit = IXGBE_MAX_MACVLANS + 1;
+
+		adapter->flags |= IXGBE_FLAG_VMDQ_ENABLED;
+
+		err = ixgbe_setup_tc(pdev, 0);
+		if (err)
+			return ERR_PTR(err);
+
+		for (pool = 1; pool < adapter->num_rx_pools; pool++)
+			if (!adapter->fwd_priv[pool])
+				break;
+
+		if (!(adapter->flags2 & IXGBE_FLAG2_FWD_POOLS) ||
+		    pool >= adapter->num_rx_pools)
+			return ERR_PTR(-EBUSY);
+	}
+
+	accel = kzalloc(sizeof(*accel), GFP_KERNEL);
+	if (!accel)
+		return ERR_PTR(-ENOMEM);
+
+	accel->pool = pool;
+	accel->netdev = vdev;
+	adapter->fwd_priv[pool] = accel;
+
+	/* steer the macvlan's transmits to its pool */
+	netdev_set_sb_channel(vdev, pool);
+
+	if (!netif_running(pdev))
+		return accel;
+
+	err = ixgbe_fwd_ring_up(adapter, accel);
+	if (err) {
+		netdev_set_sb_channel(vdev, 0);
+		adapter->fwd_priv[pool] = NULL;
+		kfree(accel);
+		return ERR_PTR(err);
+	}
+
+	return accel;
+}
+
+/**
+ * ixgbe_fwd_del - return a macvlan's pool when the macvlan goes down
+ * @pdev: lower (PF) net device
+ * @priv: pointer returned by ixgbe_fwd_add()
+ **/
+static void ixgbe_fwd_del(struct net_device *pdev, void *priv)
+{
+	struct ixgbe_adapter *adapter = netdev_priv(pdev);
+
+	ixgbe_fwd_release(adapter, priv);
+}
+
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 void ixgbe_xdp_ring_update_tail(struct ixgbe_ring *ring)
 {
 	/* Force memory writes to complete before letting h/w know there
@@ -13253,7 +14863,7 @@ static int ixgbe_xdp_setup(struct net_device *dev, struct bpf_prog *prog)
 
 	/* If transitioning XDP modes reconfigure rings */
 	if (need_reset) {
-		int err = ixgbe_setup_tc(dev, netdev_get_num_tc(dev));
+		int err = ixgbe_setup_tc(dev, ixgbe_dcb_tcs(adapter));
 
 		if (err) {
 			rcu_assign_pointer(adapter->xdp_prog, old_prog);
@@ -13561,6 +15171,10 @@ static const struct net_device_ops ixgbe_netdev_ops = {
 #ifdef HAVE_NDO_FEATURES_CHECK
 	.ndo_features_check	= ixgbe_features_check,
 #endif /* HAVE_NDO_FEATURES_CHECK */
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+	.ndo_dfwd_add_station	= ixgbe_fwd_add,
+	.ndo_dfwd_del_station	= ixgbe_fwd_del,
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 #ifdef HAVE_XDP_SUPPORT
 #ifdef HAVE_NDO_BPF
 	.ndo_bpf                = ixgbe_xdp,
@@ -14136,6 +15750,12 @@ static int ixgbe_probe(struct pci_dev *pdev,
 	if (hw->mac.type >= ixgbe_mac_82599EB)
 		netdev->features |= NETIF_F_SCTP_CRC;
 
+#ifdef HAVE_IXGBE_IPSEC
+	ixgbe_init_ipsec_offload(adapter);
+	if (adapter->ipsec)
+		netdev->features |= IXGBE_ESP_FEATURES;
+
+#endif /* HAVE_IXGBE_IPSEC */
 	/* copy netdev features into list of user selectable features */
 	netdev->hw_features |= netdev->features |
 			       NETIF_F_HW_VLAN_CTAG_FILTER |
@@ -14146,6 +15766,12 @@ static int ixgbe_probe(struct pci_dev *pdev,
 	if (hw->mac.type >= ixgbe_mac_82599EB)
 		netdev->hw_features |= NETIF_F_NTUPLE |
 				       NETIF_F_HW_TC;
+#ifdef HAVE_IXGBE_FWD_OFFLOAD
+
+	/* macvlans are offloaded to VMDq pools, left for the user to enable */
+	if (hw->mac.type >= ixgbe_mac_82599EB)
+		netdev->hw_features |= NETIF_F_HW_L2FW_DOFFLOAD;
+#endif /* HAVE_IXGBE_FWD_OFFLOAD */
 
 	if (pci_using_dac)
 		netdev->features |= NETIF_F_HIGHDMA;
@@ -14159,6 +15785,23 @@ static int ixgbe_probe(struct pci_dev *pdev,
 			    NETIF_F_HW_VLAN_CTAG_RX |
 			    NETIF_F_HW_VLAN_CTAG_TX;
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	/* double VLAN parsing expects every frame to carry an S-tag, so it
+	 * is left for the user to turn on
+	 */
+	if (hw->mac.type >= ixgbe_mac_X550)
+		netdev->hw_features |= NETIF_F_HW_VLAN_STAG_RX;
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
+#ifdef HAVE_IXGBE_MACSEC
+	/* the SecTAG goes in front of any VLAN tag, keep out of vlan_features */
+	ixgbe_init_macsec_offload(adapter);
+	if (adapter->macsec) {
+		netdev->features |= NETIF_F_HW_MACSEC;
+		netdev->hw_features |= NETIF_F_HW_MACSEC;
+	}
+
+#endif /* HAVE_IXGBE_MACSEC */
 	netdev->priv_flags |= IFF_UNICAST_FLT;
 	netdev->priv_flags |= IFF_SUPP_NOFCS;
 
@@ -14262,8 +15905,7 @@ static int ixgbe_probe(struct pci_dev *pdev,
 #endif /* HAVE_VXLAN_RX_OFFLOAD */
 	if (netdev->features & NETIF_F_LRO) {
 		if ((adapter->flags2 & IXGBE_FLAG2_RSC_CAPABLE) &&
-		    ((adapter->rx_itr_setting == 1) ||
-		     (adapter->rx_itr_setting > IXGBE_MIN_RSC_ITR))) {
+		    ixgbe_rsc_itr_ok(adapter)) {
 			adapter->flags2 |= IXGBE_FLAG2_RSC_ENABLED;
 		} else if (adapter->flags2 & IXGBE_FLAG2_RSC_CAPABLE) {
 			e_dev_info("InterruptThrottleRate set too high, "
@@ -14359,12 +16001,18 @@ static int ixgbe_probe(struct pci_dev *pdev,
 	ixgbe_mac_set_default_filter(adapter);
 
 	timer_setup(&adapter->service_timer, ixgbe_service_timer, 0);
+	hrtimer_setup(&adapter->msf_timer, ixgbe_msf_timer, CLOCK_MONOTONIC,
+		      HRTIMER_MODE_REL);
 
 	if (IXGBE_REMOVED(hw->hw_addr)) {
 		err = -EIO;
 		goto err_aci_lock;
 	}
 	INIT_WORK(&adapter->service_task, ixgbe_service_task);
+#ifdef ETHTOOL_GMODULEINFO
+	spin_lock_init(&adapter->module_cache.lock);
+	INIT_DELAYED_WORK(&adapter->module_task, ixgbe_module_task);
+#endif
 	set_bit(__IXGBE_SERVICE_INITED, adapter->state);
 	clear_bit(__IXGBE_SERVICE_SCHED, adapter->state);
 
@@ -14630,6 +16278,12 @@ err_aci_lock:
 	if (mac_type == ixgbe_mac_E610)
 		ixgbe_shutdown_aci(&adapter->hw);
 err_sw_init:
+#ifdef HAVE_IXGBE_IPSEC
+	ixgbe_stop_ipsec_offload(adapter);
+#endif /* HAVE_IXGBE_IPSEC */
+#ifdef HAVE_IXGBE_MACSEC
+	ixgbe_stop_macsec_offload(adapter);
+#endif /* HAVE_IXGBE_MACSEC */
 	ixgbe_release_hw_control(adapter);
 #ifdef CONFIG_PCI_IOV
 	ixgbe_disable_sriov(adapter);
@@ -14700,6 +16354,10 @@ static void ixgbe_remove(struct pci_dev *pdev)
 #endif /*HAVE_IXGBE_DEBUG_FS */
 	set_bit(__IXGBE_REMOVING, adapter->state);
 	cancel_work_sync(&adapter->service_task);
+	hrtimer_cancel(&adapter->msf_timer);
+#ifdef ETHTOOL_GMODULEINFO
+	cancel_delayed_work_sync(&adapter->module_task);
+#endif
 
 	if (adapter->hw.mac.type == ixgbe_mac_E610)
 		ixgbe_shutdown_aci(&adapter->hw);
@@ -14743,6 +16401,12 @@ static void ixgbe_remove(struct pci_dev *pdev)
 	ixgbe_fcoe_ddp_disable(adapter);
 #endif
 #endif /* CONFIG_FCOE */
+#ifdef HAVE_IXGBE_IPSEC
+	ixgbe_stop_ipsec_offload(adapter);
+#endif /* HAVE_IXGBE_IPSEC */
+#ifdef HAVE_IXGBE_MACSEC
+	ixgbe_stop_macsec_offload(adapter);
+#endif /* HAVE_IXGBE_MACSEC */
 	ixgbe_clear_interrupt_scheme(adapter);
 	ixgbe_release_hw_control(adapter);
 
@@ -14838,6 +16502,18 @@ void ewarn(struct ixgbe_hw *hw, const char *st)
 	netif_warn(adapter, drv, adapter->netdev,  "%s", st);
 }
 
+/**
+ * ixgbe_inject_aci_timeout - check for an injected admin command timeout
+ * @hw: pointer to hardware structure
+ *
+ * Called by the shared code once an admin command has completed, so that
+ * the timeout handling can be exercised on demand.
+ **/
+bool ixgbe_inject_aci_timeout(struct ixgbe_hw *hw)
+{
+	return ixgbe_should_fail(IXGBE_FAULT_ACI_TIMEOUT);
+}
+
 #ifdef HAVE_PCI_ERS
 /**
  * ixgbe_io_error_detected - called when PCI error is detected
@@ -102,6 +102,7 @@ u32 ixgbe_read_reg(struct ixgbe_hw *, u32 reg, bool quiet);
 extern u16 ixgbe_read_pci_cfg_word(struct ixgbe_hw *hw, u32 reg);
 extern void ixgbe_write_pci_cfg_word(struct ixgbe_hw *hw, u32 reg, u16 value);
 extern void ewarn(struct ixgbe_hw *hw, const char *str);
+extern bool ixgbe_inject_aci_timeout(struct ixgbe_hw *hw);
 
 #define IXGBE_READ_PCIE_WORD ixgbe_read_pci_cfg_word
 #define IXGBE_WRITE_PCIE_WORD ixgbe_write_pci_cfg_word
@@ -117,6 +118,7 @@ extern void ewarn(struct ixgbe_hw *hw, const char *str);
 #define IXGBE_LE32_TO_CPUS(_i) le32_to_cpus(_i)
 #define IXGBE_LE64_TO_CPU(_i) le64_to_cpu(_i)
 #define EWARN(H, W) ewarn(H, W)
+#define IXGBE_INJECT_ACI_TIMEOUT(H) ixgbe_inject_aci_timeout(H)
 
 #undef TRUE
 #define TRUE true
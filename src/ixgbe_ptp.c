@@ -140,80 +140,266 @@
 #define ISGN		0x80000000
 #define MAX_TIMADJ	0x7FFFFFFF
 
+/**
+ * ixgbe_ptp_ns_to_cycles - convert a PHC interval into SYSTIME cycles
+ * @cc: cyclecounter structure
+ * @ns: interval in nanoseconds
+ *
+ * This uses the cycle counter shift and mult values in reverse. Whole seconds
+ * are converted separately so that the shift cannot overflow for intervals
+ * longer than a second on hardware with a large shift, such as the X540.
+ */
+static u64 ixgbe_ptp_ns_to_cycles(const struct cyclecounter *cc, u64 ns)
+{
+	u64 sec;
+	u32 rem;
+
+	sec = div_u64_rem(ns, NS_PER_SEC, &rem);
+
+	return sec * div_u64(NS_PER_SEC << cc->shift, cc->mult) +
+	       div_u64((u64)rem << cc->shift, cc->mult);
+}
+
+/**
+ * ixgbe_ptp_perout_params - get the signal to drive on a clock out channel
+ * @adapter: private adapter structure
+ * @chan: periodic output channel
+ * @start: returns the requested start time in nanoseconds
+ * @period: returns the period in nanoseconds
+ *
+ * The PPS feature uses clock out channel 0 to create a 1 second periodic
+ * output aligned to the full second, so it is treated as a periodic output
+ * request starting at time 0.
+ *
+ * Returns true if the channel should be enabled.
+ */
+static bool ixgbe_ptp_perout_params(struct ixgbe_adapter *adapter,
+				    unsigned int chan, u64 *start, u64 *period)
+{
+	if (!chan && (adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED)) {
+		*start = 0;
+		*period = NS_PER_SEC;
+		return true;
+	}
+
+	if (!(adapter->ptp_perout_ena & BIT(chan)))
+		return false;
+
+	*start = adapter->ptp_perout[chan].start;
+	*period = adapter->ptp_perout[chan].period;
+	return true;
+}
+
+/**
+ * ixgbe_ptp_perout_edge - find the first clock out edge still in the future
+ * @adapter: private adapter structure
+ * @start: requested start time in nanoseconds
+ * @period: output period in nanoseconds
+ *
+ * A start time that has already passed is moved forward by whole periods,
+ * so that the output keeps the requested phase. This is also what re-aligns
+ * the signal after the clock has been stepped.
+ *
+ * Returns the SYSTIME cycle value of the edge.
+ */
+static u64 ixgbe_ptp_perout_edge(struct ixgbe_adapter *adapter, u64 start,
+				 u64 period)
+{
+	u64 ns = 0, clock_edge = 0;
+	unsigned long flags;
+
+	/* Read the current clock time, and save the cycle counter value */
+	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	write_seqcount_begin(&adapter->hw_tc_seq);
+	ns = timecounter_read(&adapter->hw_tc);
+	clock_edge = adapter->hw_tc.cycle_last;
+	write_seqcount_end(&adapter->hw_tc_seq);
+	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
+
+	if (start <= ns)
+		start += (div64_u64(ns - start, period) + 1) * period;
+
+	return clock_edge + ixgbe_ptp_ns_to_cycles(&adapter->hw_cc, start - ns);
+}
+
+/**
+ * ixgbe_ptp_free_sdps - find the SDPs the board leaves to Timesync
+ * @adapter: private adapter structure
+ *
+ * On X550EM devices SDP0 carries the SFP+ module detect, external PHY or
+ * thermal sensor interrupt, and on port 1 of fiber boards SDP1 drives the
+ * I2C mux select of the shared CS4227 (see ixgbe_setup_mux_ctl()).
+ *
+ * Returns a bitmap of the SDPs that can be given to clock out and
+ * auxiliary timestamp channels.
+ */
+static unsigned long ixgbe_ptp_free_sdps(struct ixgbe_adapter *adapter)
+{
+	unsigned long sdps = GENMASK(IXGBE_PTP_N_PINS - 1, 0);
+	struct ixgbe_hw *hw = &adapter->hw;
+
+	switch (hw->mac.type) {
+	case ixgbe_mac_X540:
+		/* fixed pins: clock out on SDP0, aux timestamp on SDP1 */
+		return BIT(0) | BIT(1);
+	case ixgbe_mac_X550EM_x:
+	case ixgbe_mac_X550EM_a:
+		sdps &= ~BIT(0);
+		if (hw->bus.lan_id &&
+		    hw->mac.ops.get_media_type(hw) == ixgbe_media_type_fiber)
+			sdps &= ~BIT(1);
+		break;
+	default:
+		break;
+	}
+
+	return sdps;
+}
+
+/**
+ * ixgbe_ptp_default_sdp - SDP of a channel in the default pin layout
+ * @adapter: private adapter structure
+ * @extts: true for an auxiliary timestamp channel, false for clock out
+ * @chan: channel of the function
+ *
+ * The free SDPs are handed out in order to clock out 0, aux timestamp 0,
+ * clock out 1 and aux timestamp 1. With all four SDPs free this puts the
+ * outputs on the even SDPs and the inputs on the odd ones, which is also
+ * the fixed layout of the X540.
+ *
+ * Returns the SDP number, or -1 if the board has too few free SDPs.
+ */
+static int ixgbe_ptp_default_sdp(struct ixgbe_adapter *adapter, bool extts,
+				 unsigned int chan)
+{
+	unsigned int nth = chan * 2 + extts;
+	int sdp;
+
+	for_each_set_bit(sdp, &adapter->ptp_sdps, IXGBE_PTP_N_PINS)
+		if (!nth--)
+			return sdp;
+
+	return -1;
+}
+
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+/**
+ * ixgbe_ptp_find_pin - find the SDP assigned to a function and channel
+ * @adapter: private adapter structure
+ * @func: PTP pin function
+ * @chan: channel of the function
+ *
+ * The pin table is updated in place by the PTP core when userspace assigns
+ * pins. It is read directly rather than through ptp_find_pin() because the
+ * core already holds its pin mutex when calling our enable callback.
+ *
+ * Returns the SDP number, or -1 if no pin is assigned.
+ */
+static int ixgbe_ptp_find_pin(struct ixgbe_adapter *adapter,
+			      enum ptp_pin_function func, unsigned int chan)
+{
+	int i;
+
+	for (i = 0; i < adapter->ptp_caps.n_pins; i++) {
+		if (adapter->ptp_pins[i].func == func &&
+		    adapter->ptp_pins[i].chan == chan)
+			return adapter->ptp_pin_sdp[i];
+	}
+
+	return -1;
+}
+
+#endif /* HAVE_PTP_1588_CLOCK_PINS */
+/* Without pin configuration, channels use the default layout */
+static int ixgbe_ptp_perout_pin(struct ixgbe_adapter *adapter,
+				unsigned int chan)
+{
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+	if (adapter->ptp_caps.n_pins)
+		return ixgbe_ptp_find_pin(adapter, PTP_PF_PEROUT, chan);
+#endif
+	return ixgbe_ptp_default_sdp(adapter, false, chan);
+}
+
+static int ixgbe_ptp_extts_pin(struct ixgbe_adapter *adapter,
+			       unsigned int chan)
+{
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+	if (adapter->ptp_caps.n_pins)
+		return ixgbe_ptp_find_pin(adapter, PTP_PF_EXTTS, chan);
+#endif
+	return ixgbe_ptp_default_sdp(adapter, true, chan);
+}
+
 /**
  * ixgbe_ptp_setup_sdp_X540
  * @adapter: private adapter structure
  *
- * this function enables or disables the clock out feature on SDP0 for
- * the X540 device. It will create a 1 second periodic output that can
- * be used as the PPS (via an interrupt).
+ * this function enables or disables the clock out feature on SDP0 and the
+ * auxiliary timestamp on SDP1 for the X540 device. The clock out creates
+ * either a 1 second periodic output that can be used as the PPS (via an
+ * interrupt), or a periodic output of the requested period.
  *
- * It calculates when the system time will be on an exact second, and then
- * aligns the start of the PPS signal to that value.
+ * It calculates when the system time will reach the next edge of the
+ * output, and then aligns the start of the signal to that value.
  *
- * This works by using the cycle counter shift and mult values in reverse, and
- * assumes that the values we're shifting will not overflow.
+ * This works by using the cycle counter shift and mult values in reverse.
  */
 static void ixgbe_ptp_setup_sdp_X540(struct ixgbe_adapter *adapter)
 {
 	struct cyclecounter *cc = &adapter->hw_cc;
 	struct ixgbe_hw *hw = &adapter->hw;
-	u32 esdp, tsauxc, clktiml, clktimh, trgttiml, trgttimh, rem;
-	u64 ns = 0, clock_edge = 0, clock_period;
-	unsigned long flags;
+	u32 esdp, tsauxc = 0, clktiml, clktimh, trgttiml, trgttimh;
+	u64 start, period, clock_edge, clock_period;
 
 	/* disable the pin first */
 	IXGBE_WRITE_REG(hw, IXGBE_TSAUXC, 0x0);
 	IXGBE_WRITE_FLUSH(hw);
 
-	if (!(adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED))
+	if (!(adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED) &&
+	    !adapter->ptp_perout_ena && !adapter->ptp_extts_ena)
 		return;
 
 	esdp = IXGBE_READ_REG(hw, IXGBE_ESDP);
 
-	/* enable the SDP0 pin as output, and connected to the
-	 * native function for Timesync (ClockOut)
-	 */
-	esdp |= IXGBE_ESDP_SDP0_DIR |
-		IXGBE_ESDP_SDP0_NATIVE;
-
-	/* enable the Clock Out feature on SDP0, and allow
-	 * interrupts to occur when the pin changes
-	 */
-	tsauxc = (IXGBE_TSAUXC_EN_CLK |
-		  IXGBE_TSAUXC_SYNCLK |
-		  IXGBE_TSAUXC_SDP0_INT);
-
-	/* Determine the clock time period to use. This assumes that the
-	 * cycle counter shift is small enough to avoid overflow.
-	 */
-	clock_period = div_u64((NS_PER_HALF_SEC << cc->shift), cc->mult);
-	clktiml = (u32)(clock_period);
-	clktimh = (u32)(clock_period >> 32);
-
-	/* Read the current clock time, and save the cycle counter value */
-	spin_lock_irqsave(&adapter->tmreg_lock, flags);
-	ns = timecounter_read(&adapter->hw_tc);
-	clock_edge = adapter->hw_tc.cycle_last;
-	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
-
-	/* Figure out how many seconds to add in order to round up */
-	div_u64_rem(ns, NS_PER_SEC, &rem);
-
-	/* Figure out how many nanoseconds to add to round the clock edge up
-	 * to the next full second
-	 */
-	rem = (NS_PER_SEC - rem);
+	if (ixgbe_ptp_perout_params(adapter, 0, &start, &period)) {
+		/* enable the SDP0 pin as output, and connected to the
+		 * native function for Timesync (ClockOut)
+		 */
+		esdp |= IXGBE_ESDP_SDP0_DIR |
+			IXGBE_ESDP_SDP0_NATIVE;
 
-	/* Adjust the clock edge to align with the next full second. */
-	clock_edge += div_u64(((u64)rem << cc->shift), cc->mult);
-	trgttiml = (u32)clock_edge;
-	trgttimh = (u32)(clock_edge >> 32);
+		/* enable the Clock Out feature on SDP0, and allow
+		 * interrupts to occur when the pin changes for PPS
+		 */
+		tsauxc |= (IXGBE_TSAUXC_EN_CLK |
+			   IXGBE_TSAUXC_SYNCLK);
+		if (adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED)
+			tsauxc |= IXGBE_TSAUXC_SDP0_INT;
+
+		/* Clock Out toggles the pin every half period */
+		clock_period = ixgbe_ptp_ns_to_cycles(cc, div_u64(period, 2));
+		clktiml = (u32)(clock_period);
+		clktimh = (u32)(clock_period >> 32);
+
+		clock_edge = ixgbe_ptp_perout_edge(adapter, start, period);
+		trgttiml = (u32)clock_edge;
+		trgttimh = (u32)(clock_edge >> 32);
+
+		IXGBE_WRITE_REG(hw, IXGBE_CLKTIML, clktiml);
+		IXGBE_WRITE_REG(hw, IXGBE_CLKTIMH, clktimh);
+		IXGBE_WRITE_REG(hw, IXGBE_TRGTTIML0, trgttiml);
+		IXGBE_WRITE_REG(hw, IXGBE_TRGTTIMH0, trgttimh);
+	}
 
-	IXGBE_WRITE_REG(hw, IXGBE_CLKTIML, clktiml);
-	IXGBE_WRITE_REG(hw, IXGBE_CLKTIMH, clktimh);
-	IXGBE_WRITE_REG(hw, IXGBE_TRGTTIML0, trgttiml);
-	IXGBE_WRITE_REG(hw, IXGBE_TRGTTIMH0, trgttimh);
+	if (adapter->ptp_extts_ena & BIT(0)) {
+		/* use SDP1 as an input connected to the native function for
+		 * Timesync, which latches SYSTIME into AUXSTMP0 on an edge
+		 */
+		esdp &= ~IXGBE_ESDP_SDP1_DIR;
+		esdp |= IXGBE_ESDP_SDP1_NATIVE;
+		tsauxc |= IXGBE_TSAUXC_EN_TS0;
+	}
 
 	IXGBE_WRITE_REG(hw, IXGBE_ESDP, esdp);
 	IXGBE_WRITE_REG(hw, IXGBE_TSAUXC, tsauxc);
@@ -225,89 +411,130 @@ static void ixgbe_ptp_setup_sdp_X540(struct ixgbe_adapter *adapter)
  * ixgbe_ptp_setup_sdp_X550
  * @adapter: private adapter structure
  *
- * Enable or disable a clock output signal on SDP 0 for X550 hardware.
+ * Enable or disable the clock output signals and the auxiliary timestamp
+ * inputs on the SDPs assigned to them for X550 hardware.
  *
- * Use the target time feature to align the output signal on the next full
- * second.
+ * Use the target time feature to align each output signal on its next edge,
+ * which is the next full second for PPS.
  *
  * This works by using the cycle counter shift and mult values in reverse, and
- * assumes that the values we're shifting will not overflow.
+ * assumes that the half period fits in the 32bit FREQOUT registers, which is
+ * checked when the output is requested.
  */
 static void ixgbe_ptp_setup_sdp_X550(struct ixgbe_adapter *adapter)
 {
 	struct cyclecounter *cc = &adapter->hw_cc;
 	struct ixgbe_hw *hw = &adapter->hw;
-	u32 esdp, tsauxc, freqout, trgttiml, trgttimh, rem, tssdp;
-	u64 ns = 0, clock_edge = 0;
+	u32 esdp, tsauxc, tsim, freqout, trgttiml, trgttimh, tssdp = 0;
+	u64 start, period, clock_edge;
 	struct timespec64 ts;
-	unsigned long flags;
+	unsigned int chan;
+	int pin;
 
 	/* disable the pin first */
 	IXGBE_WRITE_REG(hw, IXGBE_TSAUXC, 0x0);
 	IXGBE_WRITE_FLUSH(hw);
 
-	if (!(adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED))
+	tsim = IXGBE_READ_REG(hw, IXGBE_TSIM);
+	tsim &= ~(IXGBE_TSIM_AUTT0 | IXGBE_TSIM_AUTT1);
+
+	if (!(adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED) &&
+	    !adapter->ptp_perout_ena && !adapter->ptp_extts_ena) {
+		IXGBE_WRITE_REG(hw, IXGBE_TSIM, tsim);
+		IXGBE_WRITE_REG(hw, IXGBE_TSSDP, 0);
 		return;
+	}
 
 	esdp = IXGBE_READ_REG(hw, IXGBE_ESDP);
 
-	/* enable the SDP0 pin as output, and connected to the
-	 * native function for Timesync (ClockOut)
-	 */
-	esdp |= IXGBE_ESDP_SDP0_DIR |
-		IXGBE_ESDP_SDP0_NATIVE;
-
-	/* enable the Clock Out feature on SDP0, and use Target Time 0 to
-	 * enable generation of interrupts on the clock change.
-	 */
 #define IXGBE_TSAUXC_DIS_TS_CLEAR 0x40000000
-	tsauxc = (IXGBE_TSAUXC_EN_CLK | IXGBE_TSAUXC_ST0 |
-		  IXGBE_TSAUXC_EN_TT0 | IXGBE_TSAUXC_SDP0_INT |
-		  IXGBE_TSAUXC_DIS_TS_CLEAR);
+	tsauxc = IXGBE_TSAUXC_DIS_TS_CLEAR;
 
-	tssdp = (IXGBE_TSSDP_TS_SDP0_EN |
-		 IXGBE_TSSDP_TS_SDP0_CLK0);
+	for (chan = 0; chan < IXGBE_PTP_N_PEROUT; chan++) {
+		if (!ixgbe_ptp_perout_params(adapter, chan, &start, &period))
+			continue;
 
-	/* Determine the clock time period to use. This assumes that the
-	 * cycle counter shift is small enough to avoid overflowing a 32bit
-	 * value.
-	 */
-	freqout = (NS_PER_HALF_SEC << cc->shift) / cc->mult;
+		pin = ixgbe_ptp_perout_pin(adapter, chan);
+		if (pin < 0)
+			continue;
 
-	/* Read the current clock time, and save the cycle counter value */
-	spin_lock_irqsave(&adapter->tmreg_lock, flags);
-	ns = timecounter_read(&adapter->hw_tc);
-	clock_edge = adapter->hw_tc.cycle_last;
-	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
-
-	/* Figure out how far past the next second we are */
-	div_u64_rem(ns, NS_PER_SEC, &rem);
+		/* enable the pin as output, and connected to the native
+		 * function for Timesync (ClockOut)
+		 */
+		esdp |= (IXGBE_ESDP_SDP0_DIR |
+			 IXGBE_ESDP_SDP0_NATIVE) << pin;
+
+		tssdp |= IXGBE_TSSDP_TS_SDP_EN(pin) |
+			 ((chan ? IXGBE_TSSDP_TS_SDP_SEL_CLK1 :
+				  IXGBE_TSSDP_TS_SDP_SEL_CLK0) <<
+			  IXGBE_TSSDP_TS_SDP_SEL_SHIFT(pin));
+
+		/* the clock toggles every half period */
+		freqout = (u32)ixgbe_ptp_ns_to_cycles(cc, div_u64(period, 2));
+
+		/* X550 hardware stores the time in 32bits of 'billions of
+		 * cycles' and 32bits of 'cycles'. There's no guarantee that
+		 * cycles represents nanoseconds. However, we can use the math
+		 * from a timespec64 to convert into the hardware
+		 * representation.
+		 *
+		 * See ixgbe_ptp_read_X550() for more details.
+		 */
+		clock_edge = ixgbe_ptp_perout_edge(adapter, start, period);
+		ts = ns_to_timespec64(clock_edge);
+		trgttiml = (u32)ts.tv_nsec;
+		trgttimh = (u32)ts.tv_sec;
 
-	/* Figure out how many nanoseconds to add to round the clock edge up
-	 * to the next full second
-	 */
-	rem = (NS_PER_SEC - rem);
+		/* enable the Clock Out feature, and use the matching Target
+		 * Time to start it. PPS also needs the clock change interrupt.
+		 */
+		if (chan) {
+			tsauxc |= (IXGBE_TSAUXC_EN_CLK1 | IXGBE_TSAUXC_ST1 |
+				   IXGBE_TSAUXC_EN_TT1);
+			IXGBE_WRITE_REG(hw, IXGBE_FREQOUT1, freqout);
+			IXGBE_WRITE_REG(hw, IXGBE_TRGTTIML1, trgttiml);
+			IXGBE_WRITE_REG(hw, IXGBE_TRGTTIMH1, trgttimh);
+		} else {
+			tsauxc |= (IXGBE_TSAUXC_EN_CLK | IXGBE_TSAUXC_ST0 |
+				   IXGBE_TSAUXC_EN_TT0);
+			if (adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED)
+				tsauxc |= IXGBE_TSAUXC_SDP0_INT;
+			IXGBE_WRITE_REG(hw, IXGBE_FREQOUT0, freqout);
+			IXGBE_WRITE_REG(hw, IXGBE_TRGTTIML0, trgttiml);
+			IXGBE_WRITE_REG(hw, IXGBE_TRGTTIMH0, trgttimh);
+		}
+	}
 
-	/* Adjust the clock edge to align with the next full second. */
-	clock_edge += div_u64(((u64)rem << cc->shift), cc->mult);
+	for (chan = 0; chan < IXGBE_PTP_N_EXTTS; chan++) {
+		if (!(adapter->ptp_extts_ena & BIT(chan)))
+			continue;
 
-	/* X550 hardware stores the time in 32bits of 'billions of cycles' and
-	 * 32bits of 'cycles'. There's no guarantee that cycles represents
-	 * nanoseconds. However, we can use the math from a timespec64 to
-	 * convert into the hardware representation.
-	 *
-	 * See ixgbe_ptp_read_X550() for more details.
-	 */
-	ts = ns_to_timespec64(clock_edge);
-	trgttiml = (u32)ts.tv_nsec;
-	trgttimh = (u32)ts.tv_sec;
+		pin = ixgbe_ptp_extts_pin(adapter, chan);
+		if (pin < 0)
+			continue;
 
-	IXGBE_WRITE_REG(hw, IXGBE_FREQOUT0, freqout);
-	IXGBE_WRITE_REG(hw, IXGBE_TRGTTIML0, trgttiml);
-	IXGBE_WRITE_REG(hw, IXGBE_TRGTTIMH0, trgttimh);
+		/* the pin is a plain input sampled by the auxiliary
+		 * timestamp, which raises a Timesync interrupt when taken
+		 */
+		esdp &= ~((IXGBE_ESDP_SDP0_DIR |
+			   IXGBE_ESDP_SDP0_NATIVE) << pin);
+
+		if (chan) {
+			tssdp |= IXGBE_TSSDP_AUX1_TS_SDP_EN |
+				 (pin << IXGBE_TSSDP_AUX1_SDP_SEL_SHIFT);
+			tsauxc |= IXGBE_TSAUXC_EN_TS1;
+			tsim |= IXGBE_TSIM_AUTT1;
+		} else {
+			tssdp |= IXGBE_TSSDP_AUX0_TS_SDP_EN |
+				 (pin << IXGBE_TSSDP_AUX0_SDP_SEL_SHIFT);
+			tsauxc |= IXGBE_TSAUXC_EN_TS0;
+			tsim |= IXGBE_TSIM_AUTT0;
+		}
+	}
 
 	IXGBE_WRITE_REG(hw, IXGBE_ESDP, esdp);
 	IXGBE_WRITE_REG(hw, IXGBE_TSSDP, tssdp);
+	IXGBE_WRITE_REG(hw, IXGBE_TSIM, tsim);
 	IXGBE_WRITE_REG(hw, IXGBE_TSAUXC, tsauxc);
 
 	IXGBE_WRITE_FLUSH(hw);
@@ -329,6 +556,7 @@ static u64 ixgbe_ptp_read_X550(const struct cyclecounter *cc)
 		container_of(cc, struct ixgbe_adapter, hw_cc);
 	struct ixgbe_hw *hw = &adapter->hw;
 	struct timespec64 ts;
+	unsigned long flags;
 
 	/* storage is 32 bits of 'billions of cycles' and 32 bits of 'cycles'.
 	 * Some revisions of hardware run at a higher frequency and so the
@@ -345,9 +573,11 @@ static u64 ixgbe_ptp_read_X550(const struct cyclecounter *cc)
 	 * Since the SYSTIME values start at 0 and we never write them, it is
 	 * highly unlikely for the cyclecounter to overflow in practice.
 	 */
+	spin_lock_irqsave(&adapter->tslatch_lock, flags);
 	IXGBE_READ_REG(hw, IXGBE_SYSTIMR);
 	ts.tv_nsec = IXGBE_READ_REG(hw, IXGBE_SYSTIML);
 	ts.tv_sec = IXGBE_READ_REG(hw, IXGBE_SYSTIMH);
+	spin_unlock_irqrestore(&adapter->tslatch_lock, flags);
 
 	return (u64)timespec64_to_ns(&ts);
 }
@@ -365,14 +595,39 @@ static u64 ixgbe_ptp_read_82599(const struct cyclecounter *cc)
 	struct ixgbe_adapter *adapter =
 		container_of(cc, struct ixgbe_adapter, hw_cc);
 	struct ixgbe_hw *hw = &adapter->hw;
+	unsigned long flags;
 	u64 stamp = 0;
 
+	spin_lock_irqsave(&adapter->tslatch_lock, flags);
 	stamp |= (u64)IXGBE_READ_REG(hw, IXGBE_SYSTIML);
 	stamp |= (u64)IXGBE_READ_REG(hw, IXGBE_SYSTIMH) << 32;
+	spin_unlock_irqrestore(&adapter->tslatch_lock, flags);
 
 	return stamp;
 }
 
+/**
+ * ixgbe_ptp_tc_cyc2time - convert cycles to ns without taking tmreg_lock
+ * @adapter: private adapter structure
+ * @cycles: SYSTIME value in cycles
+ *
+ * Every change to the timecounter or cyclecounter is made under tmreg_lock
+ * inside a hw_tc_seq write section, so the conversion can be retried
+ * instead of serializing Rx queues and PHC readers on the lock.
+ **/
+static u64 ixgbe_ptp_tc_cyc2time(struct ixgbe_adapter *adapter, u64 cycles)
+{
+	unsigned int seq;
+	u64 ns;
+
+	do {
+		seq = read_seqcount_begin(&adapter->hw_tc_seq);
+		ns = timecounter_cyc2time(&adapter->hw_tc, cycles);
+	} while (read_seqcount_retry(&adapter->hw_tc_seq, seq));
+
+	return ns;
+}
+
 /**
  * ixgbe_ptp_convert_to_hwtstamp - convert register value to hw timestamp
  * @adapter: private adapter structure
@@ -382,10 +637,9 @@ static u64 ixgbe_ptp_read_82599(const struct cyclecounter *cc)
  * We need to convert the adapter's RX/TXSTMP registers into a hwtstamp value
  * which can be used by the stack's ptp functions.
  *
- * The lock is used to protect consistency of the cyclecounter and the SYSTIME
- * registers. However, it does not need to protect against the Rx or Tx
- * timestamp registers, as there can't be a new timestamp until the old one is
- * unlatched by reading.
+ * The conversion reads the timecounter through hw_tc_seq, so it never takes
+ * tmreg_lock. The Rx or Tx timestamp registers need no protection either, as
+ * there can't be a new timestamp until the old one is unlatched by reading.
  *
  * In addition to the timestamp in hardware, some controllers need a software
  * overflow cyclecounter, and this function takes this into account as well.
@@ -394,7 +648,6 @@ static void ixgbe_ptp_convert_to_hwtstamp(struct ixgbe_adapter *adapter,
 					  struct skb_shared_hwtstamps *hwtstamp,
 					  u64 timestamp)
 {
-	unsigned long flags;
 	struct timespec64 systime;
 	u64 ns;
 
@@ -428,16 +681,14 @@ static void ixgbe_ptp_convert_to_hwtstamp(struct ixgbe_adapter *adapter,
 		break;
 	}
 
-	spin_lock_irqsave(&adapter->tmreg_lock, flags);
-	ns = timecounter_cyc2time(&adapter->hw_tc, timestamp);
-	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
+	ns = ixgbe_ptp_tc_cyc2time(adapter, timestamp);
 
 	hwtstamp->hwtstamp = ns_to_ktime(ns);
 }
 
 /**
- * ixgbe_ptp_adjfine_82599
- * @ptp: the ptp clock structure
+ * ixgbe_ptp_set_rate_82599
+ * @adapter: private adapter structure
  * @scaled_ppm: scaled parts per million adjustment from base
  *
  * Adjust the frequency of the SYSTIME registers by the indicated scaled_ppm
@@ -445,10 +696,9 @@ static void ixgbe_ptp_convert_to_hwtstamp(struct ixgbe_adapter *adapter,
  *
  * Scaled parts per million is ppm with a 16-bit binary fractional field.
  */
-static int ixgbe_ptp_adjfine_82599(struct ptp_clock_info *ptp, long scaled_ppm)
+static void ixgbe_ptp_set_rate_82599(struct ixgbe_adapter *adapter,
+				     long scaled_ppm)
 {
-	struct ixgbe_adapter *adapter =
-		container_of(ptp, struct ixgbe_adapter, ptp_caps);
 	struct ixgbe_hw *hw = &adapter->hw;
 	u64 incval;
 
@@ -472,40 +722,11 @@ static int ixgbe_ptp_adjfine_82599(struct ptp_clock_info *ptp, long scaled_ppm)
 	default:
 		break;
 	}
-
-	return 0;
-}
-
-#ifndef HAVE_PTP_CLOCK_INFO_ADJFINE
-/**
- * ixgbe_ptp_adjfreq_82599 - Adjust the frequency of the clock
- * @info: the driver's PTP info structure
- * @ppb: Parts per billion adjustment from the base
- *
- * Adjust the frequency of the clock by the indicated parts per billion from the
- * base frequency.
- */
-static int ixgbe_ptp_adjfreq_82599(struct ptp_clock_info *info, s32 ppb)
-{
-	long scaled_ppm;
-
-	/*
-	 * We want to calculate
-	 *
-	 *    scaled_ppm = ppb * 2^16 / 1000
-	 *
-	 * which simplifies to
-	 *
-	 *    scaled_ppm = ppb * 2^13 / 125
-	 */
-	scaled_ppm = ((long)ppb << 13) / 125;
-	return ixgbe_ptp_adjfine_82599(info, scaled_ppm);
 }
-#endif
 
 /**
- * ixgbe_ptp_adjfine_X550
- * @ptp: the ptp clock structure
+ * ixgbe_ptp_set_rate_X550
+ * @adapter: private adapter structure
  * @scaled_ppm: scaled parts per million adjustment from base
  *
  * Adjust the frequency of the ptp cycle counter by the
@@ -513,10 +734,9 @@ static int ixgbe_ptp_adjfreq_82599(struct ptp_clock_info *info, s32 ppb)
  *
  * Scaled parts per million is ppm with a 16-bit binary fractional field.
  */
-static int ixgbe_ptp_adjfine_X550(struct ptp_clock_info *ptp, long scaled_ppm)
+static void ixgbe_ptp_set_rate_X550(struct ixgbe_adapter *adapter,
+				    long scaled_ppm)
 {
-	struct ixgbe_adapter *adapter =
-		container_of(ptp, struct ixgbe_adapter, ptp_caps);
 	struct ixgbe_hw *hw = &adapter->hw;
 	bool neg_adj;
 	u64 rate;
@@ -537,34 +757,87 @@ static int ixgbe_ptp_adjfine_X550(struct ptp_clock_info *ptp, long scaled_ppm)
 		inca |= ISGN;
 
 	IXGBE_WRITE_REG(hw, IXGBE_TIMINCA, inca);
+}
+
+/**
+ * ixgbe_ptp_holdover_exit - hand the clock back to the servo
+ * @adapter: private adapter structure
+ *
+ * Called with tmreg_lock held.
+ */
+static void ixgbe_ptp_holdover_exit(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
+	unsigned long secs = (jiffies - ho->start) / HZ;
+
+	ho->active = false;
+	ho->total_secs += secs;
+	e_dev_info("PHC holdover ended after %lu seconds\n", secs);
+}
+
+/**
+ * ixgbe_ptp_holdover_servo - record a frequency correction from the servo
+ * @adapter: private adapter structure
+ * @scaled_ppm: correction requested by the servo
+ *
+ * Called with tmreg_lock held. The correction is averaged so that servo noise
+ * is not frozen into the holdover frequency, and a running holdover ends as
+ * soon as the servo is back.
+ */
+static void ixgbe_ptp_holdover_servo(struct ixgbe_adapter *adapter,
+				     long scaled_ppm)
+{
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
+
+	ho->last_update = jiffies;
+	if (!ho->enabled)
+		return;
+
+	if (ho->active)
+		ixgbe_ptp_holdover_exit(adapter);
+
+	ho->last_scaled_ppm = scaled_ppm;
+	if (!ho->samples++)
+		ho->avg_scaled_ppm = scaled_ppm;
+	else
+		ho->avg_scaled_ppm += (scaled_ppm - ho->avg_scaled_ppm) / 8;
+	ho->ref_temp = ho->temp;
+}
+
+/**
+ * ixgbe_ptp_adjfine
+ * @ptp: the ptp clock structure
+ * @scaled_ppm: scaled parts per million adjustment from base
+ *
+ * Adjust the frequency of the clock by the indicated scaled_ppm from the base
+ * frequency, and let the holdover logic learn from it.
+ */
+static int ixgbe_ptp_adjfine(struct ptp_clock_info *ptp, long scaled_ppm)
+{
+	struct ixgbe_adapter *adapter =
+		container_of(ptp, struct ixgbe_adapter, ptp_caps);
+	unsigned long flags;
+
+	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	ixgbe_ptp_holdover_servo(adapter, scaled_ppm);
+	adapter->ptp_set_rate(adapter, scaled_ppm);
+	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 
 	return 0;
 }
 
 #ifndef HAVE_PTP_CLOCK_INFO_ADJFINE
 /**
- * ixgbe_ptp_adjfreq_X550 - Adjust the frequency of the clock
+ * ixgbe_ptp_adjfreq - Adjust the frequency of the clock
  * @info: the driver's PTP info structure
  * @ppb: Parts per billion adjustment from the base
  *
  * Adjust the frequency of the clock by the indicated parts per billion from the
  * base frequency.
  */
-static int ixgbe_ptp_adjfreq_X550(struct ptp_clock_info *info, s32 ppb)
+static int ixgbe_ptp_adjfreq(struct ptp_clock_info *info, s32 ppb)
 {
-	long scaled_ppm;
-
-	/*
-	 * We want to calculate
-	 *
-	 *    scaled_ppm = ppb * 2^16 / 1000
-	 *
-	 * which simplifies to
-	 *
-	 *    scaled_ppm = ppb * 2^13 / 125
-	 */
-	scaled_ppm = ((long)ppb << 13) / 125;
-	return ixgbe_ptp_adjfine_X550(info, scaled_ppm);
+	return ixgbe_ptp_adjfine(info, IXGBE_PPB_TO_SCALED_PPM(ppb));
 }
 #endif
 
@@ -579,10 +852,24 @@ static int ixgbe_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
 {
 	struct ixgbe_adapter *adapter =
 		container_of(ptp, struct ixgbe_adapter, ptp_caps);
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
 	unsigned long flags;
 
 	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	write_seqcount_begin(&adapter->hw_tc_seq);
 	timecounter_adjtime(&adapter->hw_tc, delta);
+	write_seqcount_end(&adapter->hw_tc_seq);
+
+	/* a step that ends holdover is the drift accumulated during it */
+	ho->last_update = jiffies;
+	if (ho->enabled && ho->active) {
+		ixgbe_ptp_holdover_exit(adapter);
+		ho->last_step_ns = delta;
+		if (delta < 0)
+			delta = -delta;
+		if (delta > ho->max_step_ns)
+			ho->max_step_ns = delta;
+	}
 	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 
 	if (adapter->ptp_setup_sdp)
@@ -599,6 +886,10 @@ static int ixgbe_ptp_adjtime(struct ptp_clock_info *ptp, s64 delta)
  *
  * read the timecounter and return the correct value on ns,
  * after converting it into a struct timespec.
+ *
+ * Only the SYSTIME latch is serialized, by tslatch_lock. The conversion
+ * reads the timecounter through hw_tc_seq, so clock reads never wait for
+ * tmreg_lock.
  */
 static int ixgbe_ptp_gettimex(struct ptp_clock_info *ptp,
 			      struct timespec64 *ts,
@@ -610,7 +901,7 @@ static int ixgbe_ptp_gettimex(struct ptp_clock_info *ptp,
 	unsigned long flags;
 	u64 ns, stamp;
 
-	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	spin_lock_irqsave(&adapter->tslatch_lock, flags);
 
 	switch (adapter->hw.mac.type) {
 	case ixgbe_mac_X550:
@@ -638,9 +929,9 @@ static int ixgbe_ptp_gettimex(struct ptp_clock_info *ptp,
 		break;
 	}
 
-	ns = timecounter_cyc2time(&adapter->hw_tc, stamp);
+	spin_unlock_irqrestore(&adapter->tslatch_lock, flags);
 
-	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
+	ns = ixgbe_ptp_tc_cyc2time(adapter, stamp);
 
 	*ts = ns_to_timespec64(ns);
 
@@ -679,7 +970,9 @@ static int ixgbe_ptp_settime(struct ptp_clock_info *ptp,
 
 	/* reset the timecounter */
 	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	write_seqcount_begin(&adapter->hw_tc_seq);
 	timecounter_init(&adapter->hw_tc, &adapter->hw_cc, ns);
+	write_seqcount_end(&adapter->hw_tc_seq);
 	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 
 	if (adapter->ptp_setup_sdp)
@@ -712,6 +1005,99 @@ static int ixgbe_ptp_settime32(struct ptp_clock_info *ptp,
 }
 #endif
 
+/**
+ * ixgbe_ptp_perout_request - store a periodic output request
+ * @adapter: the private adapter structure
+ * @perout: the periodic output request
+ * @on: whether to enable or disable the output
+ *
+ * The output is programmed by the ptp_setup_sdp callback afterwards, which
+ * also re-aligns it whenever the clock is adjusted or the MAC is reset.
+ */
+static int ixgbe_ptp_perout_request(struct ixgbe_adapter *adapter,
+				    struct ptp_perout_request *perout, int on)
+{
+	unsigned int chan = perout->index;
+	u64 start, period;
+
+	if (chan >= adapter->ptp_caps.n_per_out)
+		return -EINVAL;
+
+	/* A phase request shares storage with the start time, and is handled
+	 * the same way since a start time in the past keeps its phase.
+	 */
+	if (perout->flags & ~PTP_PEROUT_PHASE)
+		return -EOPNOTSUPP;
+
+	if (!on) {
+		adapter->ptp_perout_ena &= ~BIT(chan);
+		return 0;
+	}
+
+	if (ixgbe_ptp_perout_pin(adapter, chan) < 0)
+		return -EINVAL;
+
+	/* PPS is generated on clock out channel 0 */
+	if (!chan && (adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED))
+		return -EBUSY;
+
+	if (perout->start.sec < 0 || perout->period.sec < 0)
+		return -EINVAL;
+
+	start = perout->start.sec * NS_PER_SEC + perout->start.nsec;
+	period = perout->period.sec * NS_PER_SEC + perout->period.nsec;
+
+	/* the clock toggles every half period, and X550 hardware stores the
+	 * half period in a 32bit register
+	 */
+	if (period < 2)
+		return -ERANGE;
+	if (adapter->hw.mac.type != ixgbe_mac_X540 &&
+	    ixgbe_ptp_ns_to_cycles(&adapter->hw_cc,
+				   div_u64(period, 2)) > U32_MAX)
+		return -ERANGE;
+
+	adapter->ptp_perout[chan].start = start;
+	adapter->ptp_perout[chan].period = period;
+	adapter->ptp_perout_ena |= BIT(chan);
+
+	return 0;
+}
+
+/**
+ * ixgbe_ptp_extts_request - store an external timestamp request
+ * @adapter: the private adapter structure
+ * @extts: the external timestamp request
+ * @on: whether to enable or disable the channel
+ */
+static int ixgbe_ptp_extts_request(struct ixgbe_adapter *adapter,
+				   struct ptp_extts_request *extts, int on)
+{
+	unsigned int chan = extts->index;
+
+	if (chan >= adapter->ptp_caps.n_ext_ts)
+		return -EINVAL;
+
+	if (extts->flags & ~(PTP_ENABLE_FEATURE | PTP_RISING_EDGE |
+			     PTP_FALLING_EDGE | PTP_STRICT_FLAGS))
+		return -EOPNOTSUPP;
+
+	/* the auxiliary timestamp is only taken on the rising edge */
+	if (on && (extts->flags & PTP_STRICT_FLAGS) &&
+	    (extts->flags & PTP_FALLING_EDGE))
+		return -EOPNOTSUPP;
+
+	if (on && ixgbe_ptp_extts_pin(adapter, chan) < 0)
+		return -EINVAL;
+
+	if (on)
+		adapter->ptp_extts_ena |= BIT(chan);
+	else
+		adapter->ptp_extts_ena &= ~BIT(chan);
+
+	return 0;
+}
+
 /**
  * ixgbe_ptp_feature_enable
  * @ptp: the ptp clock structure
@@ -719,38 +1105,170 @@ static int ixgbe_ptp_settime32(struct ptp_clock_info *ptp,
  * @on: whether to enable or disable the feature
  *
  * enable (or disable) ancillary features of the phc subsystem.
- * our driver only supports the PPS feature on the X540
+ * our driver supports the PPS, periodic output and external timestamp
+ * features on the X540 and X550 families
  */
 static int ixgbe_ptp_feature_enable(struct ptp_clock_info *ptp,
 				    struct ptp_clock_request *rq, int on)
 {
 	struct ixgbe_adapter *adapter =
 		container_of(ptp, struct ixgbe_adapter, ptp_caps);
+	int err;
 
-	/**
-	 * When PPS is enabled, unmask the interrupt for the ClockOut
-	 * feature, so that the interrupt handler can send the PPS
-	 * event when the clock SDP triggers. Clear mask when PPS is
-	 * disabled
-	 */
-	if (rq->type != PTP_CLK_REQ_PPS || !adapter->ptp_setup_sdp)
+	if (!adapter->ptp_setup_sdp)
 		return -ENOTSUPP;
 
-	if (on)
-		adapter->flags2 |= IXGBE_FLAG2_PTP_PPS_ENABLED;
-	else
-		adapter->flags2 &= ~IXGBE_FLAG2_PTP_PPS_ENABLED;
+	switch (rq->type) {
+	case PTP_CLK_REQ_PPS:
+		/**
+		 * When PPS is enabled, unmask the interrupt for the ClockOut
+		 * feature, so that the interrupt handler can send the PPS
+		 * event when the clock SDP triggers. Clear mask when PPS is
+		 * disabled
+		 */
+		if (on && (adapter->ptp_perout_ena & BIT(0)))
+			return -EBUSY;
+
+		if (on && ixgbe_ptp_perout_pin(adapter, 0) < 0)
+			return -EINVAL;
+
+		if (on)
+			adapter->flags2 |= IXGBE_FLAG2_PTP_PPS_ENABLED;
+		else
+			adapter->flags2 &= ~IXGBE_FLAG2_PTP_PPS_ENABLED;
+		break;
+	case PTP_CLK_REQ_PEROUT:
+		err = ixgbe_ptp_perout_request(adapter, &rq->perout, on);
+		if (err)
+			return err;
+		break;
+	case PTP_CLK_REQ_EXTTS:
+		err = ixgbe_ptp_extts_request(adapter, &rq->extts, on);
+		if (err)
+			return err;
+		break;
+	default:
+		return -ENOTSUPP;
+	}
 
 	adapter->ptp_setup_sdp(adapter);
 	return 0;
 }
 
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+/**
+ * ixgbe_ptp_verify_pin - check that a pin can take a function
+ * @ptp: the ptp clock structure
+ * @pin: index of the pin
+ * @func: requested function
+ * @chan: requested channel
+ *
+ * Only SDPs left free by the board are in the pin table, and each of them
+ * can be used for clock out or as an auxiliary timestamp input. A new
+ * assignment takes effect the next time the channel is enabled.
+ */
+static int ixgbe_ptp_verify_pin(struct ptp_clock_info *ptp, unsigned int pin,
+				enum ptp_pin_function func, unsigned int chan)
+{
+	struct ixgbe_adapter *adapter =
+		container_of(ptp, struct ixgbe_adapter, ptp_caps);
+
+	if (pin >= ptp->n_pins ||
+	    !test_bit(adapter->ptp_pin_sdp[pin], &adapter->ptp_sdps))
+		return -EINVAL;
+
+	switch (func) {
+	case PTP_PF_NONE:
+	case PTP_PF_EXTTS:
+	case PTP_PF_PEROUT:
+		return 0;
+	default:
+		return -EOPNOTSUPP;
+	}
+}
+
+/**
+ * ixgbe_ptp_setup_pins - describe the free SDPs to the PTP core
+ * @adapter: the private adapter structure
+ */
+static void ixgbe_ptp_setup_pins(struct ixgbe_adapter *adapter)
+{
+	struct ptp_pin_desc *pins = adapter->ptp_pins;
+	int i = 0, sdp;
+
+	for_each_set_bit(sdp, &adapter->ptp_sdps, IXGBE_PTP_N_PINS) {
+		snprintf(pins[i].name, sizeof(pins[i].name), "SDP%d", sdp);
+		pins[i].index = i;
+		/* same layout as ixgbe_ptp_default_sdp */
+		pins[i].func = (i & 1) ? PTP_PF_EXTTS : PTP_PF_PEROUT;
+		pins[i].chan = i / 2;
+		adapter->ptp_pin_sdp[i] = sdp;
+		i++;
+	}
+
+	adapter->ptp_caps.n_pins = i;
+	adapter->ptp_caps.pin_config = pins;
+	adapter->ptp_caps.verify = ixgbe_ptp_verify_pin;
+}
+
+#endif /* HAVE_PTP_1588_CLOCK_PINS */
+/**
+ * ixgbe_ptp_check_extts - report external timestamp events
+ * @adapter: the private adapter structure
+ *
+ * An auxiliary timestamp register holds the first event on its pin until
+ * AUXSTMPH is read. This is called from the interrupt handler, and from the
+ * service task in case the event was not signaled by an interrupt.
+ */
+void ixgbe_ptp_check_extts(struct ixgbe_adapter *adapter)
+{
+	struct skb_shared_hwtstamps hwtstamp;
+	struct ixgbe_hw *hw = &adapter->hw;
+	struct ptp_clock_event event;
+	unsigned long flags;
+	unsigned int chan;
+	u64 stamp;
+	u32 autt;
+
+	if (!adapter->ptp_clock || !adapter->ptp_extts_ena)
+		return;
+
+	for (chan = 0; chan < IXGBE_PTP_N_EXTTS; chan++) {
+		if (!(adapter->ptp_extts_ena & BIT(chan)))
+			continue;
+
+		autt = chan ? IXGBE_TSAUXC_AUTT1 : IXGBE_TSAUXC_AUTT0;
+
+		/* the lock keeps the interrupt handler and the service task
+		 * from splitting a read of the two halves
+		 */
+		spin_lock_irqsave(&adapter->tslatch_lock, flags);
+		if (!(IXGBE_READ_REG(hw, IXGBE_TSAUXC) & autt)) {
+			spin_unlock_irqrestore(&adapter->tslatch_lock, flags);
+			continue;
+		}
+		stamp = (u64)IXGBE_READ_REG(hw, chan ? IXGBE_AUXSTMPL1 :
+						       IXGBE_AUXSTMPL0);
+		stamp |= (u64)IXGBE_READ_REG(hw, chan ? IXGBE_AUXSTMPH1 :
+							IXGBE_AUXSTMPH0) << 32;
+		spin_unlock_irqrestore(&adapter->tslatch_lock, flags);
+
+		ixgbe_ptp_convert_to_hwtstamp(adapter, &hwtstamp, stamp);
+
+		event.type = PTP_CLOCK_EXTTS;
+		event.index = chan;
+		event.timestamp = ktime_to_ns(hwtstamp.hwtstamp);
+		ptp_clock_event(adapter->ptp_clock, &event);
+	}
+}
+
 /**
  * ixgbe_ptp_check_pps_event
  * @adapter: the private adapter structure
  *
  * This function is called by the interrupt routine when checking for
- * interrupts. It will check and handle a pps event.
+ * interrupts. It will check and handle a pps event, and report any external
+ * timestamps that share the Timesync interrupt.
  */
 void ixgbe_ptp_check_pps_event(struct ixgbe_adapter *adapter)
 {
@@ -766,9 +1284,12 @@ void ixgbe_ptp_check_pps_event(struct ixgbe_adapter *adapter)
 	if (!adapter->ptp_clock)
 		return;
 
+	ixgbe_ptp_check_extts(adapter);
+
 	switch (hw->mac.type) {
 	case ixgbe_mac_X540:
-		ptp_clock_event(adapter->ptp_clock, &event);
+		if (adapter->flags2 & IXGBE_FLAG2_PTP_PPS_ENABLED)
+			ptp_clock_event(adapter->ptp_clock, &event);
 		break;
 	default:
 		break;
@@ -794,13 +1315,115 @@ void ixgbe_ptp_overflow_check(struct ixgbe_adapter *adapter)
 	if (timeout) {
 		/* Update the timecounter */
 		spin_lock_irqsave(&adapter->tmreg_lock, flags);
+		write_seqcount_begin(&adapter->hw_tc_seq);
 		timecounter_read(&adapter->hw_tc);
+		write_seqcount_end(&adapter->hw_tc_seq);
 		spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 
 		adapter->last_overflow_check = jiffies;
 	}
 }
 
+/**
+ * ixgbe_ptp_holdover_check - watchdog task to enter and run PHC holdover
+ * @adapter: private adapter struct
+ *
+ * When the servo has not corrected the frequency for the holdover timeout,
+ * the upstream clock is considered lost and the averaged servo correction is
+ * applied instead. Where the thermal sensors are available, the correction
+ * is compensated by the configured ppb per degree C for the change in
+ * temperature since the servo last ran.
+ */
+void ixgbe_ptp_holdover_check(struct ixgbe_adapter *adapter)
+{
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
+	struct ixgbe_hw *hw = &adapter->hw;
+	struct ixgbe_thermal_sensor_data *data;
+	unsigned long flags;
+	long scaled_ppm;
+	bool temp_valid;
+	s32 temp = 0;
+
+	if (!ho->enabled)
+		return;
+
+	/* the sensors are read over I2C, so do it before taking the lock and
+	 * at most once a second, as the service task can run far more often
+	 */
+	data = &hw->mac.thermal_sensor_data;
+	temp_valid = false;
+	if (time_is_before_jiffies(ho->last_temp_read + HZ)) {
+		ho->last_temp_read = jiffies;
+		temp_valid = hw->mac.ops.get_thermal_sensor_data &&
+			     data->sensor[0].location &&
+			     !hw->mac.ops.get_thermal_sensor_data(hw);
+	}
+	if (temp_valid)
+		temp = data->sensor[0].temp;
+
+	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	if (temp_valid) {
+		/* take the first reading as the reference if the servo has
+		 * only run before the sensor was read
+		 */
+		if (!ho->temp_valid)
+			ho->ref_temp = temp;
+		ho->temp = temp;
+		ho->temp_valid = true;
+	}
+
+	/* nothing learned from the servo yet */
+	if (!ho->samples)
+		goto out;
+
+	if (!ho->active &&
+	    time_after(jiffies, ho->last_update + ho->timeout * HZ)) {
+		ho->active = true;
+		ho->start = jiffies;
+		ho->entries++;
+		e_dev_info("PHC servo idle for %u seconds, entering holdover\n",
+			   ho->timeout);
+	}
+
+	if (!ho->active)
+		goto out;
+
+	scaled_ppm = ho->avg_scaled_ppm;
+	if (ho->temp_valid)
+		scaled_ppm += IXGBE_PPB_TO_SCALED_PPM(ho->tempco *
+						      (ho->temp - ho->ref_temp));
+	ho->applied_scaled_ppm = scaled_ppm;
+	adapter->ptp_set_rate(adapter, scaled_ppm);
+out:
+	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
+}
+
+/**
+ * ixgbe_ptp_holdover_enable - turn the PHC holdover assistance on or off
+ * @adapter: private adapter struct
+ * @enable: new state
+ *
+ * Enabling starts learning from the servo afresh. Disabling during holdover
+ * leaves the holdover frequency in place until the servo corrects it.
+ */
+void ixgbe_ptp_holdover_enable(struct ixgbe_adapter *adapter, bool enable)
+{
+	struct ixgbe_ptp_holdover *ho = &adapter->ptp_holdover;
+	unsigned long flags;
+
+	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	if (enable && !ho->enabled) {
+		ho->samples = 0;
+		ho->temp_valid = false;
+		ho->last_update = jiffies;
+		ho->last_temp_read = jiffies - HZ;
+	}
+	if (!enable && ho->active)
+		ixgbe_ptp_holdover_exit(adapter);
+	ho->enabled = enable;
+	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
+}
+
 /**
  * ixgbe_ptp_rx_hang - detect error case when Rx timestamp registers latched
  * @adapter: private network adapter structure
@@ -972,6 +1595,10 @@ static void ixgbe_ptp_tx_hwtstamp_work(struct work_struct *work)
  * This function will be called by the Rx routine of the timestamp for this
  * packet is stored in the buffer. The value is stored in little endian format
  * starting at the end of the packet data.
+ *
+ * Only the X550 family places timestamps in the packet, and it does so for
+ * every received packet. This path therefore neither touches registers nor
+ * takes tmreg_lock.
  */
 void ixgbe_ptp_rx_pktstamp(struct ixgbe_q_vector *q_vector,
 			   struct sk_buff *skb)
@@ -1380,7 +2007,9 @@ void ixgbe_ptp_start_cyclecounter(struct ixgbe_adapter *adapter)
 
 	/* need lock to prevent incorrect read while modifying cyclecounter */
 	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	write_seqcount_begin(&adapter->hw_tc_seq);
 	memcpy(&adapter->hw_cc, &cc, sizeof(adapter->hw_cc));
+	write_seqcount_end(&adapter->hw_tc_seq);
 	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 }
 
@@ -1411,8 +2040,15 @@ void ixgbe_ptp_reset(struct ixgbe_adapter *adapter)
 	ixgbe_ptp_start_cyclecounter(adapter);
 
 	spin_lock_irqsave(&adapter->tmreg_lock, flags);
+	write_seqcount_begin(&adapter->hw_tc_seq);
 	timecounter_init(&adapter->hw_tc, &adapter->hw_cc,
 			 ktime_get_real_ns());
+	write_seqcount_end(&adapter->hw_tc_seq);
+
+	/* the MAC reset lost the holdover frequency */
+	if (adapter->ptp_holdover.active)
+		adapter->ptp_set_rate(adapter,
+				      adapter->ptp_holdover.applied_scaled_ppm);
 	spin_unlock_irqrestore(&adapter->tmreg_lock, flags);
 
 	adapter->last_overflow_check = jiffies;
@@ -1451,14 +2087,22 @@ static long ixgbe_ptp_create_clock(struct ixgbe_adapter *adapter)
 		adapter->ptp_caps.owner = THIS_MODULE;
 		adapter->ptp_caps.max_adj = 250000000;
 		adapter->ptp_caps.n_alarm = 0;
-		adapter->ptp_caps.n_ext_ts = 0;
-		adapter->ptp_caps.n_per_out = 0;
+		/* fixed pins: clock out on SDP0, aux timestamp on SDP1 */
+		adapter->ptp_caps.n_ext_ts = 1;
+		adapter->ptp_caps.n_per_out = 1;
 		adapter->ptp_caps.pps = 1;
+		adapter->ptp_sdps = ixgbe_ptp_free_sdps(adapter);
+#ifdef HAVE_PTP_SUPPORTED_FLAGS
+		adapter->ptp_caps.supported_perout_flags = PTP_PEROUT_PHASE;
+		adapter->ptp_caps.supported_extts_flags = PTP_RISING_EDGE |
+							  PTP_STRICT_FLAGS;
+#endif
 #ifdef HAVE_PTP_CLOCK_INFO_ADJFINE
-		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine_82599;
+		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine;
 #else
-		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq_82599;
+		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq;
 #endif
+		adapter->ptp_set_rate = ixgbe_ptp_set_rate_82599;
 		adapter->ptp_caps.adjtime = ixgbe_ptp_adjtime;
 #ifdef HAVE_PTP_CLOCK_INFO_GETTIME64
 #ifdef HAVE_PTP_SYS_OFFSET_EXTENDED_IOCTL
@@ -1485,10 +2129,11 @@ static long ixgbe_ptp_create_clock(struct ixgbe_adapter *adapter)
 		adapter->ptp_caps.n_per_out = 0;
 		adapter->ptp_caps.pps = 0;
 #ifdef HAVE_PTP_CLOCK_INFO_ADJFINE
-		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine_82599;
+		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine;
 #else
-		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq_82599;
+		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq;
 #endif
+		adapter->ptp_set_rate = ixgbe_ptp_set_rate_82599;
 		adapter->ptp_caps.adjtime = ixgbe_ptp_adjtime;
 #ifdef HAVE_PTP_CLOCK_INFO_GETTIME64
 #ifdef HAVE_PTP_SYS_OFFSET_EXTENDED_IOCTL
@@ -1512,14 +2157,24 @@ static long ixgbe_ptp_create_clock(struct ixgbe_adapter *adapter)
 		adapter->ptp_caps.owner = THIS_MODULE;
 		adapter->ptp_caps.max_adj = 30000000;
 		adapter->ptp_caps.n_alarm = 0;
-		adapter->ptp_caps.n_ext_ts = 0;
-		adapter->ptp_caps.n_per_out = 0;
+		adapter->ptp_caps.n_ext_ts = IXGBE_PTP_N_EXTTS;
+		adapter->ptp_caps.n_per_out = IXGBE_PTP_N_PEROUT;
 		adapter->ptp_caps.pps = 1;
+#ifdef HAVE_PTP_SUPPORTED_FLAGS
+		adapter->ptp_caps.supported_perout_flags = PTP_PEROUT_PHASE;
+		adapter->ptp_caps.supported_extts_flags = PTP_RISING_EDGE |
+							  PTP_STRICT_FLAGS;
+#endif
+		adapter->ptp_sdps = ixgbe_ptp_free_sdps(adapter);
+#ifdef HAVE_PTP_1588_CLOCK_PINS
+		ixgbe_ptp_setup_pins(adapter);
+#endif
 #ifdef HAVE_PTP_CLOCK_INFO_ADJFINE
-		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine_X550;
+		adapter->ptp_caps.adjfine = ixgbe_ptp_adjfine;
 #else
-		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq_X550;
+		adapter->ptp_caps.adjfreq = ixgbe_ptp_adjfreq;
 #endif
+		adapter->ptp_set_rate = ixgbe_ptp_set_rate_X550;
 		adapter->ptp_caps.adjtime = ixgbe_ptp_adjtime;
 #ifdef HAVE_PTP_CLOCK_INFO_GETTIME64
 #ifdef HAVE_PTP_SYS_OFFSET_EXTENDED_IOCTL
@@ -1557,6 +2212,7 @@ static long ixgbe_ptp_create_clock(struct ixgbe_adapter *adapter)
 	 */
 	adapter->tstamp_config.rx_filter = HWTSTAMP_FILTER_NONE;
 	adapter->tstamp_config.tx_type = HWTSTAMP_TX_OFF;
+	adapter->ptp_holdover.timeout = IXGBE_PTP_HOLDOVER_TIMEOUT;
 
 	return 0;
 }
@@ -1576,6 +2232,8 @@ void ixgbe_ptp_init(struct ixgbe_adapter *adapter)
 	 * device
 	 */
 	spin_lock_init(&adapter->tmreg_lock);
+	spin_lock_init(&adapter->tslatch_lock);
+	seqcount_init(&adapter->hw_tc_seq);
 
 	/* obtain a PTP device, or re-use an existing device */
 	if (ixgbe_ptp_create_clock(adapter))
@@ -1607,6 +2265,8 @@ void ixgbe_ptp_suspend(struct ixgbe_adapter *adapter)
 		return;
 
 	adapter->flags2 &= ~IXGBE_FLAG2_PTP_PPS_ENABLED;
+	adapter->ptp_perout_ena = 0;
+	adapter->ptp_extts_ena = 0;
 	if (adapter->ptp_setup_sdp)
 		adapter->ptp_setup_sdp(adapter);
 
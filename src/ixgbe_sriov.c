@@ -314,6 +314,15 @@ static int ixgbe_pci_sriov_enable(struct pci_dev __maybe_unused *dev, int __mayb
 		return -EOPNOTSUPP;
 	}
 
+#ifdef NETIF_F_HW_VLAN_STAG_RX
+	/* double VLAN mode is global and would apply to VF traffic too */
+	if (adapter->netdev->features & NETIF_F_HW_VLAN_STAG_RX) {
+		e_dev_err("SR-IOV is not supported with 802.1ad offload\n");
+		return -EOPNOTSUPP;
+	}
+
+#endif /* NETIF_F_HW_VLAN_STAG_RX */
+
 	if (adapter->num_vfs == num_vfs)
 		return -EINVAL;
 
@@ -419,9 +428,8 @@ static int ixgbe_set_vf_multicasts(struct ixgbe_adapter *adapter,
 		       >> IXGBE_VT_MSGINFO_SHIFT;
 	u16 *hash_list = (u16 *)&msgbuf[1];
 	struct vf_data_storage *vfinfo = &adapter->vfinfo[vf];
-	struct ixgbe_hw *hw = &adapter->hw;
 	int i;
-	u32 vmolr = IXGBE_READ_REG(hw, IXGBE_VMOLR(vf));
+	u32 vmolr = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR, vf);
 
 	/* only so many hash values supported */
 	entries = min(entries, IXGBE_MAX_VF_MC_ENTRIES);
@@ -438,7 +446,7 @@ static int ixgbe_set_vf_multicasts(struct ixgbe_adapter *adapter,
 		vfinfo->vf_mc_hashes[i] = hash_list[i];
 
 	vmolr |= IXGBE_VMOLR_ROMPE;
-	IXGBE_WRITE_REG(hw, IXGBE_VMOLR(vf), vmolr);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, vf, vmolr);
 
 	/* Sync up the PF and VF in the same MTA table */
 	ixgbe_write_mc_addr_list(adapter->netdev);
@@ -459,7 +467,7 @@ void ixgbe_restore_vf_multicasts(struct ixgbe_adapter *adapter)
 	memset(&hw->mac.mta_shadow, 0, sizeof(hw->mac.mta_shadow));
 
 	for (i = 0; i < adapter->num_vfs; i++) {
-		u32 vmolr = IXGBE_READ_REG(hw, IXGBE_VMOLR(i));
+		u32 vmolr = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR, i);
 		vfinfo = &adapter->vfinfo[i];
 		for (j = 0; j < vfinfo->num_vf_mc_hashes; j++) {
 			hw->addr_ctrl.mta_in_use++;
@@ -471,7 +479,7 @@ void ixgbe_restore_vf_multicasts(struct ixgbe_adapter *adapter)
 			vmolr |= IXGBE_VMOLR_ROMPE;
 		else
 			vmolr &= ~IXGBE_VMOLR_ROMPE;
-		IXGBE_WRITE_REG(hw, IXGBE_VMOLR(i), vmolr);
+		ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, i, vmolr);
 	}
 
 	/* Restore any VF macvlans */
@@ -596,13 +604,14 @@ static int ixgbe_set_vf_lpe(struct ixgbe_adapter *adapter, u32 max_frame, u32 vf
 
 void ixgbe_set_vmolr(struct ixgbe_hw *hw, u32 vf, bool aupe)
 {
-	u32 vmolr = IXGBE_READ_REG(hw, IXGBE_VMOLR(vf));
+	struct ixgbe_adapter *adapter = hw->back;
+	u32 vmolr = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR, vf);
 	vmolr |=  IXGBE_VMOLR_BAM;
 	if (aupe)
 		vmolr |= IXGBE_VMOLR_AUPE;
 	else
 		vmolr &= ~IXGBE_VMOLR_AUPE;
-	IXGBE_WRITE_REG(hw, IXGBE_VMOLR(vf), vmolr);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, vf, vmolr);
 }
 
 static void ixgbe_set_vmvir(struct ixgbe_adapter *adapter,
@@ -1262,10 +1271,10 @@ static int ixgbe_update_vf_xcast_mode(struct ixgbe_adapter *adapter,
 		return -EOPNOTSUPP;
 	}
 
-	vmolr = IXGBE_READ_REG(hw, IXGBE_VMOLR(vf));
+	vmolr = ixgbe_shadow_read(adapter, IXGBE_SHADOW_VMOLR, vf);
 	vmolr &= ~disable;
 	vmolr |= enable;
-	IXGBE_WRITE_REG(hw, IXGBE_VMOLR(vf), vmolr);
+	ixgbe_shadow_write(adapter, IXGBE_SHADOW_VMOLR, vf, vmolr);
 
 	adapter->vfinfo[vf].xcast_mode = xcast_mode;
 
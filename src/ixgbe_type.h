@@ -550,6 +550,9 @@ struct ixgbe_nvm_version {
 #define IXGBE_DMATXCTL_MBINTEN	0x40 /* Bit 6 */
 #define IXGBE_DMATXCTL_VT_SHIFT	16  /* VLAN EtherType */
 
+#define IXGBE_EXVET_VET_EXT_MASK	0xFFFF0000 /* Outer VLAN EtherType */
+#define IXGBE_EXVET_VET_EXT_SHIFT	16
+
 #define IXGBE_PFDTXGSWC_VT_LBEN	0x1 /* Local L2 VT switch enable */
 
 /* Anti-spoofing defines */
@@ -758,12 +761,14 @@ struct ixgbe_dmac_config {
 
 #define IXGBE_SECTXSTAT_SECTX_RDY	0x00000001
 #define IXGBE_SECTXSTAT_ECC_TXERR	0x00000002
+#define IXGBE_SECTXSTAT_SECTX_OFF_DIS	0x00000004
 
 #define IXGBE_SECRXCTRL_SECRX_DIS	0x00000001
 #define IXGBE_SECRXCTRL_RX_DIS		0x00000002
 
 #define IXGBE_SECRXSTAT_SECRX_RDY	0x00000001
 #define IXGBE_SECRXSTAT_ECC_RXERR	0x00000002
+#define IXGBE_SECRXSTAT_SECRX_OFF_DIS	0x00000004
 
 /* LinkSec (MacSec) Registers */
 #define IXGBE_LSECTXCAP		0x08A00
@@ -826,6 +831,16 @@ struct ixgbe_dmac_config {
 #define IXGBE_LSECRXCTRL_RP		0x00000080
 #define IXGBE_LSECRXCTRL_RSV_MASK	0xFFFFFF33
 
+#define IXGBE_LSECTXSA_AN0_MASK		0x00000003
+#define IXGBE_LSECTXSA_AN0_SHIFT	0
+#define IXGBE_LSECTXSA_AN1_MASK		0x0000000C
+#define IXGBE_LSECTXSA_AN1_SHIFT	2
+#define IXGBE_LSECTXSA_SELSA		0x00000010
+#define IXGBE_LSECTXSA_ACTSA		0x00000020
+
+#define IXGBE_LSECRXSA_AN_MASK		0x00000003
+#define IXGBE_LSECRXSA_SAV		0x00000004
+
 /* IpSec Registers */
 #define IXGBE_IPSTXIDX		0x08900
 #define IXGBE_IPSTXSALT		0x08904
@@ -1407,6 +1422,7 @@ struct ixgbe_dmac_config {
 #define IXGBE_RSCCTL_MAXDESC_4	0x04
 #define IXGBE_RSCCTL_MAXDESC_8	0x08
 #define IXGBE_RSCCTL_MAXDESC_16	0x0C
+#define IXGBE_RSCCTL_MAXDESC_MASK	0x0C
 #define IXGBE_RSCCTL_TS_DIS	0x02
 
 /* RSCDBU Bit Masks */
@@ -1462,6 +1478,7 @@ struct ixgbe_dmac_config {
 #define IXGBE_CTRL_EXT_PFRSTD	0x00004000 /* Physical Function Reset Done */
 #define IXGBE_CTRL_EXT_NS_DIS	0x00010000 /* No Snoop disable */
 #define IXGBE_CTRL_EXT_RO_DIS	0x00020000 /* Relaxed Ordering disable */
+#define IXGBE_CTRL_EXT_EXTENDED_VLAN	0x04000000 /* Double VLAN mode */
 #define IXGBE_CTRL_EXT_DRV_LOAD	0x10000000 /* Driver loaded bit for FW */
 
 /* Direct Cache Access (DCA) definitions */
@@ -2580,11 +2597,26 @@ enum {
 #define IXGBE_TSAUXC_EN_TT0		0x00000001
 #define IXGBE_TSAUXC_EN_TT1		0x00000002
 #define IXGBE_TSAUXC_ST0		0x00000010
+#define IXGBE_TSAUXC_EN_CLK1		0x00000020 /* X550 Clock Out 1 */
+#define IXGBE_TSAUXC_ST1		0x00000080 /* X550 Start Clock 1 on TT1 */
+#define IXGBE_TSAUXC_EN_TS0		0x00000100 /* Aux Time Stamp 0 enable */
+#define IXGBE_TSAUXC_AUTT0		0x00000200 /* Aux Time Stamp 0 taken */
+#define IXGBE_TSAUXC_EN_TS1		0x00000400 /* Aux Time Stamp 1 enable */
+#define IXGBE_TSAUXC_AUTT1		0x00000800 /* Aux Time Stamp 1 taken */
 #define IXGBE_TSAUXC_DISABLE_SYSTIME	0x80000000
 
+#define IXGBE_TSSDP_AUX0_SDP_SEL_SHIFT	0
+#define IXGBE_TSSDP_AUX0_TS_SDP_EN	0x00000004
+#define IXGBE_TSSDP_AUX1_SDP_SEL_SHIFT	3
+#define IXGBE_TSSDP_AUX1_TS_SDP_EN	0x00000020
 #define IXGBE_TSSDP_TS_SDP0_SEL_MASK	0x000000C0
 #define IXGBE_TSSDP_TS_SDP0_CLK0	0x00000080
 #define IXGBE_TSSDP_TS_SDP0_EN		0x00000100
+/* Each SDP has a 2 bit output select followed by an enable bit */
+#define IXGBE_TSSDP_TS_SDP_SEL_SHIFT(_i)	(6 + (3 * (_i)))
+#define IXGBE_TSSDP_TS_SDP_SEL_CLK0	0x2
+#define IXGBE_TSSDP_TS_SDP_SEL_CLK1	0x3
+#define IXGBE_TSSDP_TS_SDP_EN(_i)	(IXGBE_TSSDP_TS_SDP0_EN << (3 * (_i)))
 
 #define IXGBE_TSYNCTXCTL_VALID		0x00000001 /* Tx timestamp valid */
 #define IXGBE_TSYNCTXCTL_ENABLED	0x00000010 /* Tx timestamping enabled */
@@ -2602,10 +2634,18 @@ enum {
 
 #define IXGBE_TSIM_SYS_WRAP		0x00000001
 #define IXGBE_TSIM_TXTS			0x00000002
+#define IXGBE_TSIM_TT0			0x00000008
+#define IXGBE_TSIM_TT1			0x00000010
+#define IXGBE_TSIM_AUTT0		0x00000020
+#define IXGBE_TSIM_AUTT1		0x00000040
 #define IXGBE_TSIM_TADJ			0x00000080
 
 #define IXGBE_TSICR_SYS_WRAP		IXGBE_TSIM_SYS_WRAP
 #define IXGBE_TSICR_TXTS		IXGBE_TSIM_TXTS
+#define IXGBE_TSICR_TT0			IXGBE_TSIM_TT0
+#define IXGBE_TSICR_TT1			IXGBE_TSIM_TT1
+#define IXGBE_TSICR_AUTT0		IXGBE_TSIM_AUTT0
+#define IXGBE_TSICR_AUTT1		IXGBE_TSIM_AUTT1
 #define IXGBE_TSICR_TADJ		IXGBE_TSIM_TADJ
 
 #define IXGBE_RXMTRL_V1_CTRLT_MASK	0x000000FF
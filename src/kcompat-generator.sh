@@ -245,6 +245,8 @@ function gen-netdevice() {
 	gen HAVE_NETDEV_MIN_MAX_MTU if struct net_device matches min_mtu in "$ndh"
 	gen HAVE_NETIF_SET_TSO_MAX if fun netif_set_tso_max_size in "$ndh"
 	gen HAVE_SET_NETDEV_DEVLINK_PORT if macro SET_NETDEV_DEVLINK_PORT in "$ndh"
+	gen HAVE_XDO_DEV_STATE_ADD_EXTACK if method xdo_dev_state_add of xfrmdev_ops matches 'struct netlink_ext_ack \\*extack' in "$ndh"
+	gen HAVE_XDO_DEV_STATE_NETDEV if method xdo_dev_state_add of xfrmdev_ops matches 'struct net_device \\*dev' in "$ndh"
 	gen NEED_NETDEV_TX_SENT_QUEUE if fun __netdev_tx_sent_queue absent in "$ndh"
 	gen NEED_NETIF_NAPI_ADD_NO_WEIGHT if fun netif_napi_add matches 'int weight' in "$ndh"
 	gen NEED_NET_PREFETCH if fun net_prefetch absent in "$ndh"
@@ -279,6 +281,7 @@ function gen-ptp() {
 	gen NEED_DIFF_BY_SCALED_PPM if fun diff_by_scaled_ppm absent in "$clockh"
 	gen NEED_PTP_SYSTEM_TIMESTAMP if fun ptp_read_system_prets absent in "$clockh"
 	gen HAVE_PTP_TX_ONESTEP_P2P if enum hwtstamp_tx_types matches HWTSTAMP_TX_ONESTEP_P2P in include/uapi/linux/net_tstamp.h
+	gen HAVE_PTP_SUPPORTED_FLAGS if struct ptp_clock_info matches supported_perout_flags in "$clockh"
 	gen HAVE_PTP_SYS_OFFSET_EXTENDED_IOCTL if macro PTP_SYS_OFFSET_EXTENDED in "$uapih"
 
 	# aarch64 requires additional function to enable cross timestamping
@@ -322,6 +325,7 @@ function gen-other() {
 	gen HAVE_X86_STEPPING if struct cpuinfo_x86 matches x86_stepping in arch/x86/include/asm/processor.h
 	gen HAVE_PCI_ENABLE_PCIE_ERROR_REPORTING if fun pci_enable_pcie_error_reporting in "$pciaerh"
 	gen NEED_PCI_AER_CLEAR_NONFATAL_STATUS if fun pci_aer_clear_nonfatal_status absent in "$pciaerh"
+	gen HAVE_KUNIT_SUITES_FOR_MODULE if macro kunit_test_suites_for_module in include/kunit/test.h
 	gen NEED_BITMAP_COPY_CLEAR_TAIL if fun bitmap_copy_clear_tail absent in include/linux/bitmap.h
 	gen NEED_BITMAP_FROM_ARR32 if fun bitmap_from_arr32 absent in include/linux/bitmap.h
 	gen NEED_BITMAP_TO_ARR32 if fun bitmap_to_arr32 absent in include/linux/bitmap.h
@@ -340,6 +344,7 @@ function gen-other() {
 	gen NEED_FS_FILE_DENTRY if fun file_dentry absent in include/linux/fs.h
 	gen HAVE_HWMON_DEVICE_REGISTER_WITH_INFO if fun hwmon_device_register_with_info in include/linux/hwmon.h
 	gen NEED_HWMON_CHANNEL_INFO if macro HWMON_CHANNEL_INFO absent in include/linux/hwmon.h
+	gen NEED_HRTIMER_SETUP if fun hrtimer_setup absent in include/linux/hrtimer.h
 	gen NEED_ETH_TYPE_VLAN if fun eth_type_vlan absent in include/linux/if_vlan.h
 	gen HAVE_IOMMU_DEV_FEAT_AUX if enum iommu_dev_features matches IOMMU_DEV_FEAT_AUX in include/linux/iommu.h
 	gen NEED_READ_POLL_TIMEOUT if macro read_poll_timeout absent in include/linux/iopoll.h
@@ -389,11 +394,15 @@ function gen-other() {
 	gen NEED_U64_STATS_READ if fun u64_stats_read absent in "$ush"
 	gen NEED_U64_STATS_SET if fun u64_stats_set absent in "$ush"
 	gen HAVE_XARRAY_API if struct xarray in include/linux/xarray.h
+	gen HAVE_METADATA_MACSEC if enum metadata_type matches METADATA_MACSEC in include/net/dst_metadata.h
 	gen HAVE_TC_FLOWER_ENC if enum flow_dissector_key_id matches FLOW_DISSECTOR_KEY_ENC_CONTROL in include/net/flow_dissector.h
 	gen HAVE_TC_FLOWER_VLAN_IN_TAGS if enum flow_dissector_key_id matches FLOW_DISSECTOR_KEY_VLANID in include/net/flow_dissector.h
+	gen HAVE_MACSEC_CTX_PREPARE if struct macsec_context matches prepare in include/net/macsec.h
 	gen HAVE_NET_RPS_H if macro RPS_NO_FILTER in include/net/rps.h
 	gen NEED_XDP_CONVERT_BUFF_TO_FRAME if fun xdp_convert_buff_to_frame absent in include/net/xdp.h
 	gen NEED_XSK_BUFF_DMA_SYNC_FOR_CPU_NO_POOL if fun xsk_buff_dma_sync_for_cpu matches 'struct xsk_buff_pool' in include/net/xdp_sock_drv.h
+	gen HAVE_XFRM_DEV_OFFLOAD if struct xfrm_dev_offload in include/net/xfrm.h
+	gen HAVE_XFRM_DEV_OFFLOAD_DIR if struct xfrm_dev_offload matches dir in include/net/xfrm.h
 	gen HAVE_ASSIGN_STR_2_PARAMS if macro __assign_str matches src in include/trace/stages/stage6_event_callback.h include/trace/trace_events.h include/trace/ftrace.h
 
 	HAVE_LINUX_UNALIGNED=0
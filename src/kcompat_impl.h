@@ -1072,6 +1072,24 @@ cpu_latency_qos_remove_request(struct pm_qos_request *req)
 
 #endif /* NEED_STATIC_BRANCH_LIKELY */
 
+/* NEED_HRTIMER_SETUP
+ *
+ * hrtimer_setup() was added by upstream commit 908a1d775422 ("hrtimers:
+ * Introduce hrtimer_setup() to replace hrtimer_init()") and hrtimer_init()
+ * was later removed.
+ */
+#ifdef NEED_HRTIMER_SETUP
+#include <linux/hrtimer.h>
+static inline void
+hrtimer_setup(struct hrtimer *timer,
+	      enum hrtimer_restart (*function)(struct hrtimer *),
+	      clockid_t clock_id, enum hrtimer_mode mode)
+{
+	hrtimer_init(timer, clock_id, mode);
+	timer->function = function;
+}
+#endif /* NEED_HRTIMER_SETUP */
+
 /* PCI related stuff */
 
 /* NEED_PCI_AER_CLEAR_NONFATAL_STATUS